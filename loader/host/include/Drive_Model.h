@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Drive_Model.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: timing model of the Wii DVD drive behind the simulated
+ *	/dev/di, and the simulated clock returned by gettime
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Drive_Model Class
+
+class Drive_Model
+{
+public:
+	struct Parameters
+	{
+		// -- Geometry (single layer, data area is a ring between the radii)
+		double	Capacity;				// Bytes
+		double	Inner_Radius;			// mm
+		double	Outer_Radius;			// mm
+
+		// -- Motor
+		double	RPM;					// Constant angular velocity
+		u32		Spin_Up;				// us, from stopped to reading
+		u32		Spin_Down;				// us, DI_StopMotor
+
+		// -- Access
+		u32		Settle;					// us, shortest seek
+		u32		Full_Stroke;			// us, inner to outer edge
+		u32		Sequential_Window;		// Bytes ahead of the head reached without seeking
+
+		// -- Transfer
+		double	Outer_Rate;				// Bytes/s at the outer edge
+		u32		Zones;					// Rate is constant within a zone
+
+		// -- Commands
+		u32		Command_Overhead;		// us, IPC round trip and drive command
+		u32		Reset;					// us, DI_Reset without spin-up
+		u32		Open_Partition;			// us, ticket/TMD checks in IOS
+	};
+
+	Parameters	Params;
+
+	// -- Statistics (us and bytes)
+	unsigned int	Commands;
+	unsigned int	Spin_Ups;
+	unsigned int	Seeks;
+	qword			Bytes;
+	qword			Busy_Time;
+	qword			Spin_Up_Time;
+	qword			Seek_Time;
+	qword			Rotation_Time;
+	qword			Transfer_Time;
+
+	bool			Enabled;			// false: commands take no simulated time
+	double			CPU_Scale;			// Host CPU time is multiplied by this
+
+	u64 Now();
+	u64 Schedule(u64 Cost);
+	void Wait_Until(u64 Time);
+
+	u64 Command();
+	u64 Access(qword Offset, qword Length);
+	u64 Reset(bool Spin_Up);
+	u64 Stop_Motor();
+	u64 Open_Partition(qword Offset);
+	bool Motor_On() const;
+
+	void Reset_Statistics();
+
+private:
+	bool	Spinning;
+	qword	Head;						// Disc offset after the last access
+	u64		Drive_Free;					// Simulated time the last command completes
+	u64		Host_Start;					// Host time at the start of simulation
+	u64		Waited;						// Simulated time spent blocked on the drive
+
+	double Radius(qword Offset) const;
+	double Rate(qword Offset) const;
+	u64 Charge(u32 Time, qword* Total);
+
+protected:
+	Drive_Model();
+	Drive_Model(const Drive_Model&);
+	Drive_Model& operator= (const Drive_Model&);
+
+	virtual ~Drive_Model();
+
+public:
+	inline static Drive_Model* Instance()
+	{
+		static Drive_Model instance;
+		return &instance;
+	}
+};
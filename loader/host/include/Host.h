@@ -0,0 +1,32 @@
+/*******************************************************************************
+ * Host.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: settings of the libogc shim that the console takes from its
+ *	own hardware and system settings
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Host Namespace
+
+namespace Host
+{
+	void Set_Region(s32 Region);				// Returned by CONF_GetRegion
+	bool Deliver_Next();						// Complete the oldest queued asynchronous IPC command
+	int Patch_Benchmark(unsigned int Size);		// Time the patch engine on a synthetic image
+	int Compile_Patches(const char* Source, const char* Output);	// Build sd:/SoftChip/Patches.bin, or only validate without Output
+}
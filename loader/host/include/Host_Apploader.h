@@ -0,0 +1,36 @@
+/*******************************************************************************
+ * Host_Apploader.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: stand-in for the disc's apploader.  It hands out the same
+ *	sections in the same order (boot info, bi2, main.dol, FST), so the load
+ *	loop sees the real read pattern.  Sections land in an emulated MEM1.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+#include "Apploader.h"
+
+//--------------------------------------
+// Host apploader
+
+namespace Host_Apploader
+{
+	const dword MEM1_Size = 0x01800000;
+
+	void Start(Apploader::Enter* Enter, Apploader::Load* Load, Apploader::Exit* Exit);
+
+	byte* MEM1();
+	void Release();
+}
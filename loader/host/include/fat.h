@@ -0,0 +1,30 @@
+/*******************************************************************************
+ * fat.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: libfat.  "sd:" is a directory (or symlink) in the
+ *	current directory, so sd:/ paths need no translation
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <ogc/disc_io.h>
+
+//--------------------------------------
+// FAT
+
+extern "C"
+{
+	bool fatMountSimple(const char* name, const DISC_INTERFACE* interface);
+	void fatUnmount(const char* name);
+}
@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * gctypes.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: libogc basic types
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <stdint.h>
+#include <stddef.h>
+
+//--------------------------------------
+// Types
+
+typedef uint8_t		u8;
+typedef uint16_t	u16;
+typedef uint32_t	u32;
+typedef uint64_t	u64;
+
+typedef int8_t		s8;
+typedef int16_t		s16;
+typedef int32_t		s32;
+typedef int64_t		s64;
+
+typedef volatile u8		vu8;
+typedef volatile u16	vu16;
+typedef volatile u32	vu32;
+typedef volatile u64	vu64;
+
+#define ATTRIBUTE_ALIGN(v)	__attribute__((aligned(v)))
+#define ATTRIBUTE_PACKED	__attribute__((packed))
@@ -0,0 +1,31 @@
+/*******************************************************************************
+ * ogc/cache.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: cache maintenance (nothing to do on the host)
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Cache
+
+extern "C"
+{
+	void DCFlushRange(void* startaddress, u32 len);
+	void DCInvalidateRange(void* startaddress, u32 len);
+	void DCStoreRange(void* startaddress, u32 len);
+	void ICInvalidateRange(void* startaddress, u32 len);
+}
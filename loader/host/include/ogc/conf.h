@@ -0,0 +1,37 @@
+/*******************************************************************************
+ * ogc/conf.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: system settings, the region is set by the host program
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Conf
+
+enum
+{
+	CONF_REGION_JP		= 0,
+	CONF_REGION_US		= 1,
+	CONF_REGION_EU		= 2,
+	CONF_REGION_KR		= 4,
+	CONF_REGION_CN		= 5
+};
+
+extern "C"
+{
+	s32 CONF_GetRegion(void);
+}
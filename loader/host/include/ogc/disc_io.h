@@ -0,0 +1,44 @@
+/*******************************************************************************
+ * ogc/disc_io.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: block device interface used by libfat
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Disc interface
+
+typedef u32 sec_t;
+
+typedef bool (*FN_MEDIUM_STARTUP)(void);
+typedef bool (*FN_MEDIUM_ISINSERTED)(void);
+typedef bool (*FN_MEDIUM_READSECTORS)(sec_t sector, sec_t numSectors, void* buffer);
+typedef bool (*FN_MEDIUM_WRITESECTORS)(sec_t sector, sec_t numSectors, const void* buffer);
+typedef bool (*FN_MEDIUM_CLEARSTATUS)(void);
+typedef bool (*FN_MEDIUM_SHUTDOWN)(void);
+
+typedef struct DISC_INTERFACE_STRUCT
+{
+	unsigned long			ioType;
+	unsigned long			features;
+	FN_MEDIUM_STARTUP		startup;
+	FN_MEDIUM_ISINSERTED	isInserted;
+	FN_MEDIUM_READSECTORS	readSectors;
+	FN_MEDIUM_WRITESECTORS	writeSectors;
+	FN_MEDIUM_CLEARSTATUS	clearStatus;
+	FN_MEDIUM_SHUTDOWN		shutdown;
+} DISC_INTERFACE;
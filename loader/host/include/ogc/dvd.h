@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * ogc/dvd.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: disc identifier
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// DVD
+
+typedef struct _dvddiskid
+{
+	s8	gamename[4];
+	s8	company[2];
+	u8	disknum;
+	u8	gamever;
+	u8	streaming;
+	u8	streambufsize;
+	u8	pad[22];
+} dvddiskid;
@@ -0,0 +1,29 @@
+/*******************************************************************************
+ * ogc/ios.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: the IOS running, which is never reloaded
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// IOS
+
+extern "C"
+{
+	s32 IOS_GetVersion();
+	s32 IOS_GetRevision();
+}
@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * ogc/ipc.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: IOS IPC calls, /dev/di is served from a disc image
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// IPC
+
+#define IPC_OK				0
+#define IPC_EINVAL			-4
+#define IPC_ENOENT			-6
+#define IPC_ENOMEM			-22
+
+typedef struct _ioctlv
+{
+	void*	data;
+	u32		len;
+} ioctlv;
+
+typedef s32 (*ipccallback)(s32 result, void* usrdata);
+
+extern "C"
+{
+	s32 IOS_Open(const char* filepath, u32 mode);
+	s32 IOS_Close(s32 fd);
+	s32 IOS_Ioctl(s32 fd, s32 ioctl, void* buffer_in, s32 len_in, void* buffer_io, s32 len_io);
+	s32 IOS_IoctlAsync(s32 fd, s32 ioctl, void* buffer_in, s32 len_in, void* buffer_io, s32 len_io, ipccallback ipc_cb, void* usrdata);
+	s32 IOS_Ioctlv(s32 fd, s32 ioctl, s32 cnt_in, s32 cnt_io, ioctlv* argv);
+	s32 IOS_IoctlvAsync(s32 fd, s32 ioctl, s32 cnt_in, s32 cnt_io, ioctlv* argv, ipccallback ipc_cb, void* usrdata);
+}
@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * ogc/lwp.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: LWP threads on top of pthreads.  Stacks and priorities are
+ *	left to the host.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Thread
+
+#define LWP_THREAD_NULL		0xffffffff
+
+typedef u32 lwp_t;
+
+extern "C"
+{
+	s32 LWP_CreateThread(lwp_t* thethread, void* (*entry)(void*), void* arg, void* stackbase, u32 stack_size, u8 prio);
+	s32 LWP_JoinThread(lwp_t thethread, void** value_ptr);
+}
@@ -0,0 +1,42 @@
+/*******************************************************************************
+ * ogc/lwp_watchdog.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: timebase, ticking at the console's rate
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Timebase
+
+#define TB_BUS_CLOCK				243000000u
+#define TB_TIMER_CLOCK				(TB_BUS_CLOCK / 4000)			// Ticks per msec
+
+#define secs_to_ticks(sec)			((u64)(sec) * (TB_TIMER_CLOCK * 1000))
+#define millisecs_to_ticks(msec)	((u64)(msec) * (TB_TIMER_CLOCK))
+#define microsecs_to_ticks(usec)	(((u64)(usec) * (TB_TIMER_CLOCK / 125)) / 8)
+
+#define ticks_to_secs(ticks)		((u64)(ticks) / (TB_TIMER_CLOCK * 1000))
+#define ticks_to_millisecs(ticks)	((u64)(ticks) / (TB_TIMER_CLOCK))
+#define ticks_to_microsecs(ticks)	(((u64)(ticks) * 8) / (TB_TIMER_CLOCK / 125))
+
+extern "C"
+{
+	u64 gettime(void);
+	u32 diff_sec(u64 start, u64 end);
+	u32 diff_msec(u64 start, u64 end);
+	u32 diff_usec(u64 start, u64 end);
+}
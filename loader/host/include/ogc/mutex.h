@@ -0,0 +1,36 @@
+/*******************************************************************************
+ * ogc/mutex.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: LWP mutexes on top of pthreads
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Mutex
+
+#define LWP_MUTEX_NULL		0xffffffff
+
+typedef u32 mutex_t;
+
+extern "C"
+{
+	s32 LWP_MutexInit(mutex_t* mutex, bool use_recursive);
+	s32 LWP_MutexDestroy(mutex_t mutex);
+	s32 LWP_MutexLock(mutex_t mutex);
+	s32 LWP_MutexTryLock(mutex_t mutex);
+	s32 LWP_MutexUnlock(mutex_t mutex);
+}
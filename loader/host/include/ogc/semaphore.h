@@ -0,0 +1,35 @@
+/*******************************************************************************
+ * ogc/semaphore.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: LWP semaphores on top of pthreads
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Semaphore
+
+#define LWP_SEM_NULL		0xffffffff
+
+typedef u32 sem_t;
+
+extern "C"
+{
+	s32 LWP_SemInit(sem_t* sem, u32 start, u32 max);
+	s32 LWP_SemDestroy(sem_t sem);
+	s32 LWP_SemWait(sem_t sem);
+	s32 LWP_SemPost(sem_t sem);
+}
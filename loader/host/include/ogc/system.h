@@ -0,0 +1,28 @@
+/*******************************************************************************
+ * ogc/system.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: MEM2 arena allocation
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// System
+
+extern "C"
+{
+	void* SYS_AllocArena2MemLo(u32 size, u32 align);
+}
@@ -0,0 +1,25 @@
+/*******************************************************************************
+ * sdcard/wiisd_io.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: front SD slot
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <ogc/disc_io.h>
+
+//--------------------------------------
+// SD
+
+extern const DISC_INTERFACE __io_wiisd;
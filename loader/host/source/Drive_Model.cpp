@@ -0,0 +1,365 @@
+/*******************************************************************************
+ * Drive_Model.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: timing model of the Wii DVD drive.
+ *
+ *	The drive spins the disc at constant angular velocity, so the transfer
+ *	rate grows with the radius; it is modelled as a set of zones with a fixed
+ *	rate each.  Seeks cost a settle time plus a term growing with the square
+ *	root of the radial distance, followed by half a revolution on average.
+ *	Everything is read in 32 KiB ECC blocks.  Commands run one at a time, so
+ *	a command queued while the drive is busy starts when it is free.
+ *
+ *	Simulated time is host CPU time (scaled by CPU_Scale) plus the time spent
+ *	blocked on the drive.  The defaults are estimates, not measurements.
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include <ogc/lwp_watchdog.h>
+
+#include "Drive_Model.h"
+
+static const qword ECC_Block = 0x8000;
+
+static u64 Host_Ticks()
+{
+	struct timespec Now;
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+
+	return secs_to_ticks(Now.tv_sec) + ((u64)Now.tv_nsec * TB_TIMER_CLOCK) / 1000000;
+}
+
+//--------------------------------------
+// Drive_Model Class
+
+/*******************************************************************************
+ * Drive_Model: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Drive_Model::Drive_Model()
+{
+	Params.Capacity				= 4699979776.0;
+	Params.Inner_Radius			= 24.0;
+	Params.Outer_Radius			= 58.0;
+
+	Params.RPM					= 3450.0;
+	Params.Spin_Up				= 1500000;
+	Params.Spin_Down			= 150000;
+
+	Params.Settle				= 2000;
+	Params.Full_Stroke			= 200000;
+	Params.Sequential_Window	= 0x40000;
+
+	Params.Outer_Rate			= 8310000.0;		// 6x DVD
+	Params.Zones				= 16;
+
+	Params.Command_Overhead		= 150;
+	Params.Reset				= 100000;
+	Params.Open_Partition		= 25000;
+
+	Enabled		= false;
+	CPU_Scale	= 1.0;
+
+	Spinning	= true;
+	Head		= 0;
+	Drive_Free	= 0;
+	Waited		= 0;
+	Host_Start	= Host_Ticks();
+
+	Reset_Statistics();
+}
+
+/*******************************************************************************
+ * ~Drive_Model: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Drive_Model::~Drive_Model() {}
+
+/*******************************************************************************
+ * Reset_Statistics: Clear the counters
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Drive_Model::Reset_Statistics()
+{
+	Commands		= 0;
+	Spin_Ups		= 0;
+	Seeks			= 0;
+	Bytes			= 0;
+	Busy_Time		= 0;
+	Spin_Up_Time	= 0;
+	Seek_Time		= 0;
+	Rotation_Time	= 0;
+	Transfer_Time	= 0;
+}
+
+/*******************************************************************************
+ * Now: Current simulated time
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the time in timebase ticks
+ *
+ ******************************************************************************/
+
+u64 Drive_Model::Now()
+{
+	return (u64)((Host_Ticks() - Host_Start) * CPU_Scale) + Waited;
+}
+
+/*******************************************************************************
+ * Schedule: Queue a command on the drive
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the simulated time the command completes
+ *
+ ******************************************************************************/
+
+u64 Drive_Model::Schedule(u64 Cost)
+{
+	u64 Start = Now();
+	if (Drive_Free > Start) Start = Drive_Free;
+
+	Drive_Free = Start + Cost;
+	Busy_Time += ticks_to_microsecs(Cost);
+
+	return Drive_Free;
+}
+
+/*******************************************************************************
+ * Wait_Until: Block the caller until a command has completed
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Drive_Model::Wait_Until(u64 Time)
+{
+	u64 Current = Now();
+	if (Time > Current) Waited += Time - Current;
+}
+
+/*******************************************************************************
+ * Charge: Account time to a statistic
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the time in ticks
+ *
+ ******************************************************************************/
+
+u64 Drive_Model::Charge(u32 Time, qword* Total)
+{
+	if (Total) *Total += Time;
+	return microsecs_to_ticks(Time);
+}
+
+/*******************************************************************************
+ * Radius: Radial position of a disc offset
+ * -----------------------------------------------------------------------------
+ * The spiral fills the ring evenly, so the offset is proportional to the
+ * area inside the radius.
+ *
+ * Return Values:
+ *	returns the radius in mm
+ *
+ ******************************************************************************/
+
+double Drive_Model::Radius(qword Offset) const
+{
+	double Fraction = (double)Offset / Params.Capacity;
+	if (Fraction > 1.0) Fraction = 1.0;
+
+	double Inner = Params.Inner_Radius * Params.Inner_Radius;
+	double Outer = Params.Outer_Radius * Params.Outer_Radius;
+
+	return sqrt(Inner + (Outer - Inner) * Fraction);
+}
+
+/*******************************************************************************
+ * Rate: Transfer rate at a disc offset
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns bytes per second for the zone holding the offset
+ *
+ ******************************************************************************/
+
+double Drive_Model::Rate(qword Offset) const
+{
+	double Width = (Params.Outer_Radius - Params.Inner_Radius) / Params.Zones;
+	unsigned int Zone = (unsigned int)((Radius(Offset) - Params.Inner_Radius) / Width);
+
+	if (Zone >= Params.Zones) Zone = Params.Zones - 1;
+
+	double Middle = Params.Inner_Radius + (Zone + 0.5) * Width;
+	return Params.Outer_Rate * Middle / Params.Outer_Radius;
+}
+
+/*******************************************************************************
+ * Command: Cost of a command that doesn't touch the disc
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the time in ticks
+ *
+ ******************************************************************************/
+
+u64 Drive_Model::Command()
+{
+	if (!Enabled) return 0;
+
+	Commands++;
+	return Charge(Params.Command_Overhead, 0);
+}
+
+/*******************************************************************************
+ * Access: Cost of reading from the disc
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the time in ticks
+ *
+ ******************************************************************************/
+
+u64 Drive_Model::Access(qword Offset, qword Length)
+{
+	// Refused right away, see Motor_On
+	if (!Spinning) return Command();
+
+	if (!Enabled) return 0;
+
+	u64 Cost = Command();
+
+	qword Start	= Offset & ~(ECC_Block - 1);
+	qword End	= (Offset + Length + ECC_Block - 1) & ~(ECC_Block - 1);
+
+	if (Start < Head || Start - Head > Params.Sequential_Window)
+	{
+		double Stroke	= Params.Outer_Radius - Params.Inner_Radius;
+		double Distance	= fabs(Radius(Start) - Radius(Head));
+		u32 Seek		= Params.Settle + (u32)((Params.Full_Stroke - Params.Settle) * sqrt(Distance / Stroke));
+
+		Cost += Charge(Seek, &Seek_Time);
+		Cost += Charge((u32)(30000000.0 / Params.RPM), &Rotation_Time);
+		Seeks++;
+	}
+	else if (Start > Head)
+	{
+		// Close enough ahead to wait for it to pass under the head
+		Cost += Charge((u32)((Start - Head) * 1000000.0 / Rate(Head)), &Rotation_Time);
+	}
+
+	Cost += Charge((u32)((End - Start) * 1000000.0 / Rate((Start + End) / 2)), &Transfer_Time);
+
+	Bytes	+= End - Start;
+	Head	= End;
+
+	return Cost;
+}
+
+/*******************************************************************************
+ * Reset: Cost of DI_Reset
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the time in ticks
+ *
+ ******************************************************************************/
+
+u64 Drive_Model::Reset(bool Spin_Up)
+{
+	bool Stopped = !Spinning;
+
+	if (Spin_Up) Spinning = true;
+	if (!Enabled) return 0;
+
+	u64 Cost = Command() + Charge(Params.Reset, 0);
+
+	if (Spin_Up && Stopped)
+	{
+		Cost += Charge(Params.Spin_Up, &Spin_Up_Time);
+		Spin_Ups++;
+	}
+
+	// The drive reads the lead-in, which leaves the head at the inner edge
+	Head = 0;
+
+	return Cost;
+}
+
+/*******************************************************************************
+ * Stop_Motor: Cost of DI_StopMotor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the time in ticks
+ *
+ ******************************************************************************/
+
+u64 Drive_Model::Stop_Motor()
+{
+	bool Stopping = Spinning;
+
+	Spinning = false;
+	if (!Enabled) return 0;
+
+	u64 Cost = Command();
+
+	if (Stopping) Cost += Charge(Params.Spin_Down, 0);
+
+	return Cost;
+}
+
+/*******************************************************************************
+ * Open_Partition: Cost of DI_OpenPartition
+ * -----------------------------------------------------------------------------
+ * IOS reads the partition header and TMD, then verifies ticket and TMD.
+ *
+ * Return Values:
+ *	returns the time in ticks
+ *
+ ******************************************************************************/
+
+u64 Drive_Model::Open_Partition(qword Offset)
+{
+	if (!Spinning) return Command();
+	if (!Enabled) return 0;
+
+	return Access(Offset, ECC_Block) + Charge(Params.Open_Partition, 0);
+}
+
+/*******************************************************************************
+ * Motor_On: Check that the disc can be read
+ * -----------------------------------------------------------------------------
+ * Once the motor was stopped, the drive fails every read until a DI_Reset
+ * spins it up again.  The state is kept in functional runs too.
+ *
+ * Return Values:
+ *	returns true if the disc is spinning
+ *
+ ******************************************************************************/
+
+bool Drive_Model::Motor_On() const
+{
+	return Spinning;
+}
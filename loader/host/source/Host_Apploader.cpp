@@ -0,0 +1,195 @@
+/*******************************************************************************
+ * Host_Apploader.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: stand-in for the disc's apploader.  Like the real one, each
+ *	call to Load depends on what the previous sections put in memory: the
+ *	DOL header location comes from the boot info, the DOL sections from the
+ *	DOL header.
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include "Host_Apploader.h"
+#include "WiiDisc.h"
+
+//--------------------------------------
+// Apploader state
+
+namespace
+{
+	using Host_Apploader::MEM1_Size;
+	using Wii_Disc::DOL_Header;
+
+	enum Stage
+	{
+		Stage_Boot_Info,
+		Stage_Bi2,
+		Stage_DOL_Header,
+		Stage_DOL,
+		Stage_FST,
+		Stage_Done
+	};
+
+	dword		Boot_Info[8]		__attribute__((aligned(0x20)));
+	byte		Bi2[0x2000]			__attribute__((aligned(0x20)));
+	DOL_Header	Header				__attribute__((aligned(0x20)));
+
+	byte*		MEM1_Buffer		= 0;
+	Stage		Current			= Stage_Boot_Info;
+	int			Section			= 0;
+
+	Apploader::Report Report = 0;
+
+	// Anything outside MEM1 is handed out as a null pointer, which the loader rejects
+	void* Map(dword Address, dword Size)
+	{
+		dword Offset = Address & 0x01ffffff;
+		if (Offset >= MEM1_Size || Size > MEM1_Size - Offset) return 0;
+
+		return MEM1_Buffer + Offset;
+	}
+
+	void Enter(Apploader::Report Callback)
+	{
+		Report = Callback;
+		if (Report) Report("Host apploader\n");
+	}
+
+	int Load(void** Dest, int* Size, int* Offset)
+	{
+		switch (Current)
+		{
+			case Stage_Boot_Info:
+				*Dest	= Boot_Info;
+				*Size	= sizeof(Boot_Info);
+				*Offset	= 0x420 >> 2;
+
+				Current = Stage_Bi2;
+				return 1;
+
+			case Stage_Bi2:
+				*Dest	= Bi2;
+				*Size	= sizeof(Bi2);
+				*Offset	= 0x440 >> 2;
+
+				Current = Stage_DOL_Header;
+				return 1;
+
+			case Stage_DOL_Header:
+				*Dest	= &Header;
+				*Size	= sizeof(Header);
+				*Offset	= BE32(Boot_Info[0]);
+
+				Current	= Stage_DOL;
+				Section	= 0;
+				return 1;
+
+			case Stage_DOL:
+				while (Section < DOL_Header::Sections && BE32(Header.Size[Section]) == 0) Section++;
+
+				if (Section < DOL_Header::Sections)
+				{
+					dword Length = (BE32(Header.Size[Section]) + 0x1f) & ~0x1f;
+
+					*Dest	= Map(BE32(Header.Address[Section]), Length);
+					*Size	= Length;
+					*Offset	= BE32(Boot_Info[0]) + (BE32(Header.Offset[Section]) >> 2);
+
+					Section++;
+					return 1;
+				}
+
+				Current = Stage_FST;
+				// Fall through
+
+			case Stage_FST:
+			{
+				Current = Stage_Done;
+
+				dword Length = BE32(Boot_Info[2]) << 2;
+				if (Length == 0 || Length > MEM1_Size / 2) return 0;
+
+				// The FST goes to the top of MEM1
+				*Dest	= Map((MEM1_Size - Length) & ~0x1f, Length);
+				*Size	= Length;
+				*Offset	= BE32(Boot_Info[1]);
+				return 1;
+			}
+
+			default:
+				return 0;
+		}
+	}
+
+	void* Exit()
+	{
+		return (void*)(unsigned long)BE32(Header.Entry_Point);
+	}
+}
+
+//--------------------------------------
+// Host_Apploader
+
+/*******************************************************************************
+ * Start: Reset the apploader and hand out its entry points
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void, throws if MEM1 can't be allocated
+ *
+ ******************************************************************************/
+
+void Host_Apploader::Start(Apploader::Enter* Enter_Function, Apploader::Load* Load_Function, Apploader::Exit* Exit_Function)
+{
+	if (!MEM1_Buffer) MEM1_Buffer = (byte*)memalign(0x20, MEM1_Size);
+	if (!MEM1_Buffer) throw "Out of memory";
+
+	memset(MEM1_Buffer, 0, MEM1_Size);
+	memset(&Header, 0, sizeof(Header));
+
+	Current = Stage_Boot_Info;
+	Section	= 0;
+
+	*Enter_Function	= Enter;
+	*Load_Function	= Load;
+	*Exit_Function	= Exit;
+}
+
+/*******************************************************************************
+ * MEM1: The emulated MEM1 the sections are loaded into
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the buffer, 0 before Start
+ *
+ ******************************************************************************/
+
+byte* Host_Apploader::MEM1()
+{
+	return MEM1_Buffer;
+}
+
+/*******************************************************************************
+ * Release: Free the emulated MEM1
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Host_Apploader::Release()
+{
+	free(MEM1_Buffer);
+	MEM1_Buffer = 0;
+}
@@ -0,0 +1,282 @@
+/*******************************************************************************
+ * IPC.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: IOS IPC.  The only device is /dev/di, which answers the cIOS
+ *	commands used by the DIP class from the opened Disc_Image, so the drive
+ *	code paths (cache, planner, async reads) run unchanged.
+ *
+ *	Each command is charged to the Drive_Model.  Synchronous commands return
+ *	once the drive has finished them; asynchronous ones complete (run their
+ *	callback) when the caller blocks on a semaphore, at the simulated time
+ *	the drive gets to them.
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+#include <pthread.h>
+
+#include <ogc/ipc.h>
+#include <ogc/ios.h>
+#include <ogc/dvd.h>
+
+#include "Ioctl.h"
+#include "Disc_Image.h"
+#include "Cluster_Cache.h"
+#include "Drive_Model.h"
+#include "Host.h"
+
+//--------------------------------------
+// /dev/di
+
+namespace
+{
+	enum
+	{
+		DI_Handle		= 3,		// Any positive descriptor
+		DI_Success		= 1,		// Drive return codes
+		DI_Error		= 2,
+		Max_Pending		= 8,		// Queued asynchronous commands
+		Host_IOS		= 36		// IOS the host pretends to run
+	};
+
+	struct Completion
+	{
+		u64			Time;			// Simulated time the drive finishes
+		ipccallback	Callback;
+		void*		Data;
+		s32			Result;
+	};
+
+	unsigned int	Offset_Base = 0;
+
+	pthread_mutex_t	Pending_Lock = PTHREAD_MUTEX_INITIALIZER;
+	Completion		Pending[Max_Pending];
+	unsigned int	Pending_Count = 0;
+
+	u64 DI_Cost(s32 ioctl, u32* Command)
+	{
+		Drive_Model* Model = Drive_Model::Instance();
+
+		switch (ioctl)
+		{
+			case Ioctl::DI_Read:
+			{
+				if (Command[1] == 0) return Model->Command();
+
+				// The drive reads and decrypts whole clusters
+				Disc_Image* Image = Disc_Image::Instance();
+				unsigned int Offset = Command[2] << 2;
+
+				qword Start	= Image->Disc_Offset(Offset);
+				qword End	= Image->Disc_Offset(Offset + Command[1] - 1) + Cluster_Cache::Raw_Cluster_Size;
+
+				return Model->Access(Start, End - Start);
+			}
+
+			case Ioctl::DI_ReadUnencrypted:
+				return Model->Access((qword)Command[2] << 2, Command[1]);
+
+			case Ioctl::DI_ReadID:
+				return Model->Access(0, 0x20);
+
+			case Ioctl::DI_Reset:
+				return Model->Reset(Command[1] != 0);
+
+			case Ioctl::DI_StopMotor:
+				return Model->Stop_Motor();
+
+			default:
+				return Model->Command();
+		}
+	}
+
+	s32 DI_Status(int Ret)
+	{
+		return (Ret < 0) ? DI_Error : DI_Success;
+	}
+
+	s32 DI_Command(s32 ioctl, u32* Command, void* Output, s32 Output_Len)
+	{
+		Disc_Image* Image = Disc_Image::Instance();
+
+		// Reads fail while the motor is stopped, DI_Cost charged the refusal
+		if (!Drive_Model::Instance()->Motor_On())
+		{
+			if (ioctl == Ioctl::DI_Read || ioctl == Ioctl::DI_ReadUnencrypted || ioctl == Ioctl::DI_ReadID) return DI_Error;
+		}
+
+		switch (ioctl)
+		{
+			case Ioctl::DI_Inquiry:
+				memset(Output, 0, Output_Len);
+				return DI_Success;
+
+			case Ioctl::DI_ReadID:
+				return DI_Status(Image->Read_DiscID((dvddiskid*)Output));
+
+			case Ioctl::DI_Read:
+				return DI_Status(Image->Read(Output, Command[1], Command[2] << 2));
+
+			case Ioctl::DI_ReadUnencrypted:
+				return DI_Status(Image->Read_Unencrypted(Output, Command[1], Command[2] << 2));
+
+			case Ioctl::DI_VerifyCover:
+			{
+				bool Inserted = false;
+				Image->Verify_Cover(&Inserted);
+
+				*(u32*)Output = Inserted ? 0 : 1;
+				return DI_Success;
+			}
+
+			case Ioctl::DI_WaitCoverClose:
+				return DI_Status(Image->Wait_CoverClose());
+
+			case Ioctl::DI_Reset:
+				return DI_Status(Image->Reset());
+
+			case Ioctl::DI_ClosePartition:
+				return DI_Status(Image->Close_Partition());
+
+			case Ioctl::DI_SetOffsetBase:
+				Offset_Base = Command[1] << 2;
+				return DI_Success;
+
+			case Ioctl::DI_GetOffsetBase:
+				*(u32*)Output = Offset_Base;
+				return DI_Success;
+
+			case Ioctl::DI_StopMotor:
+				return DI_Status(Image->Stop_Motor());
+
+			case Ioctl::DI_EnableDVD:
+				return DI_Success;
+
+			default:
+				return DI_Error;
+		}
+	}
+}
+
+//--------------------------------------
+// IOS
+
+s32 IOS_GetVersion()
+{
+	return Host_IOS;
+}
+
+s32 IOS_GetRevision()
+{
+	return 0;
+}
+
+s32 IOS_Open(const char* filepath, u32 mode)
+{
+	if (strcmp(filepath, "/dev/di") != 0) return IPC_ENOENT;
+
+	return Disc_Image::Instance()->Initialize() ? DI_Handle : IPC_ENOENT;
+}
+
+s32 IOS_Close(s32 fd)
+{
+	if (fd != DI_Handle) return IPC_EINVAL;
+
+	Offset_Base = 0;
+	return IPC_OK;
+}
+
+s32 IOS_Ioctl(s32 fd, s32 ioctl, void* buffer_in, s32 len_in, void* buffer_io, s32 len_io)
+{
+	if (fd != DI_Handle) return IPC_EINVAL;
+	if (!buffer_in || len_in < 0x20) return IPC_EINVAL;
+
+	Drive_Model* Model = Drive_Model::Instance();
+	u64 Done = Model->Schedule(DI_Cost(ioctl, (u32*)buffer_in));
+
+	s32 Ret = DI_Command(ioctl, (u32*)buffer_in, buffer_io, len_io);
+
+	Model->Wait_Until(Done);
+	return Ret;
+}
+
+s32 IOS_IoctlAsync(s32 fd, s32 ioctl, void* buffer_in, s32 len_in, void* buffer_io, s32 len_io, ipccallback ipc_cb, void* usrdata)
+{
+	if (fd != DI_Handle) return IPC_EINVAL;
+	if (!buffer_in || len_in < 0x20) return IPC_EINVAL;
+
+	pthread_mutex_lock(&Pending_Lock);
+
+	if (Pending_Count >= Max_Pending)
+	{
+		pthread_mutex_unlock(&Pending_Lock);
+		return IPC_ENOMEM;
+	}
+
+	// The data is in place right away; only the completion waits for the drive
+	Completion* Entry = &Pending[Pending_Count++];
+
+	Entry->Time		= Drive_Model::Instance()->Schedule(DI_Cost(ioctl, (u32*)buffer_in));
+	Entry->Result	= DI_Command(ioctl, (u32*)buffer_in, buffer_io, len_io);
+	Entry->Callback	= ipc_cb;
+	Entry->Data		= usrdata;
+
+	pthread_mutex_unlock(&Pending_Lock);
+	return IPC_OK;
+}
+
+s32 IOS_Ioctlv(s32 fd, s32 ioctl, s32 cnt_in, s32 cnt_io, ioctlv* argv)
+{
+	if (fd != DI_Handle) return IPC_EINVAL;
+	if (ioctl != Ioctl::DI_OpenPartition || cnt_in != 3 || cnt_io != 2) return IPC_EINVAL;
+
+	// In: command, ticket, certificates.  Out: TMD, error
+	u32* Command = (u32*)argv[0].data;
+
+	Drive_Model* Model = Drive_Model::Instance();
+	u64 Done = Model->Schedule(Model->Open_Partition((qword)Command[1] << 2));
+
+	s32 Ret = DI_Error;
+
+	if (Model->Motor_On()) Ret = DI_Status(Disc_Image::Instance()->Open_Partition(Command[1], argv[1].data, argv[2].data, argv[2].len, argv[3].data));
+
+	Model->Wait_Until(Done);
+	return Ret;
+}
+
+//--------------------------------------
+// Host
+
+// Commands complete in order, like the drive processes them
+bool Host::Deliver_Next()
+{
+	pthread_mutex_lock(&Pending_Lock);
+
+	if (Pending_Count == 0)
+	{
+		pthread_mutex_unlock(&Pending_Lock);
+		return false;
+	}
+
+	Completion Entry = Pending[0];
+
+	Pending_Count--;
+	memmove(&Pending[0], &Pending[1], Pending_Count * sizeof(Completion));
+
+	pthread_mutex_unlock(&Pending_Lock);
+
+	Drive_Model::Instance()->Wait_Until(Entry.Time);
+	if (Entry.Callback) Entry.Callback(Entry.Result, Entry.Data);
+
+	return true;
+}
@@ -0,0 +1,202 @@
+/*******************************************************************************
+ * LWP.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: LWP threads, mutexes and semaphores on top of pthreads.
+ *	Handles index fixed tables, like libogc's object pools.
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <pthread.h>
+
+#include <ogc/lwp.h>
+#include <ogc/mutex.h>
+#include <ogc/semaphore.h>
+
+#include "Host.h"
+
+//--------------------------------------
+// Object pools
+
+namespace
+{
+	enum
+	{
+		Max_Threads		= 8,
+		Max_Mutexes		= 64,
+		Max_Semaphores	= 64
+	};
+
+	struct Semaphore
+	{
+		pthread_mutex_t	Lock;
+		pthread_cond_t	Posted;
+		u32				Count;
+		u32				Max;
+	};
+
+	pthread_mutex_t		Pool_Lock = PTHREAD_MUTEX_INITIALIZER;
+
+	pthread_t			Threads[Max_Threads];
+	u32					Thread_Count = 0;
+
+	pthread_mutex_t		Mutexes[Max_Mutexes];
+	u32					Mutex_Count = 0;
+
+	Semaphore			Semaphores[Max_Semaphores];
+	u32					Semaphore_Count = 0;
+}
+
+//--------------------------------------
+// Thread
+
+s32 LWP_CreateThread(lwp_t* thethread, void* (*entry)(void*), void* arg, void* stackbase, u32 stack_size, u8 prio)
+{
+	pthread_mutex_lock(&Pool_Lock);
+
+	if (Thread_Count >= Max_Threads || pthread_create(&Threads[Thread_Count], 0, entry, arg) != 0)
+	{
+		pthread_mutex_unlock(&Pool_Lock);
+		return -1;
+	}
+
+	*thethread = Thread_Count++;
+
+	pthread_mutex_unlock(&Pool_Lock);
+	return 0;
+}
+
+s32 LWP_JoinThread(lwp_t thethread, void** value_ptr)
+{
+	if (thethread >= Thread_Count) return -1;
+	return pthread_join(Threads[thethread], value_ptr);
+}
+
+//--------------------------------------
+// Mutex
+
+s32 LWP_MutexInit(mutex_t* mutex, bool use_recursive)
+{
+	pthread_mutex_lock(&Pool_Lock);
+
+	if (Mutex_Count >= Max_Mutexes)
+	{
+		pthread_mutex_unlock(&Pool_Lock);
+		return -1;
+	}
+
+	u32 Handle = Mutex_Count++;
+
+	pthread_mutexattr_t Attributes;
+	pthread_mutexattr_init(&Attributes);
+	if (use_recursive) pthread_mutexattr_settype(&Attributes, PTHREAD_MUTEX_RECURSIVE);
+
+	pthread_mutex_init(&Mutexes[Handle], &Attributes);
+	pthread_mutexattr_destroy(&Attributes);
+
+	pthread_mutex_unlock(&Pool_Lock);
+
+	*mutex = Handle;
+	return 0;
+}
+
+s32 LWP_MutexDestroy(mutex_t mutex)
+{
+	return (mutex < Mutex_Count) ? 0 : -1;
+}
+
+s32 LWP_MutexLock(mutex_t mutex)
+{
+	if (mutex >= Mutex_Count) return -1;
+	return pthread_mutex_lock(&Mutexes[mutex]);
+}
+
+s32 LWP_MutexTryLock(mutex_t mutex)
+{
+	if (mutex >= Mutex_Count) return -1;
+	return pthread_mutex_trylock(&Mutexes[mutex]);
+}
+
+s32 LWP_MutexUnlock(mutex_t mutex)
+{
+	if (mutex >= Mutex_Count) return -1;
+	return pthread_mutex_unlock(&Mutexes[mutex]);
+}
+
+//--------------------------------------
+// Semaphore
+
+s32 LWP_SemInit(sem_t* sem, u32 start, u32 max)
+{
+	pthread_mutex_lock(&Pool_Lock);
+
+	if (Semaphore_Count >= Max_Semaphores)
+	{
+		pthread_mutex_unlock(&Pool_Lock);
+		return -1;
+	}
+
+	Semaphore* Object = &Semaphores[Semaphore_Count];
+
+	pthread_mutex_init(&Object->Lock, 0);
+	pthread_cond_init(&Object->Posted, 0);
+	Object->Count	= start;
+	Object->Max		= max;
+
+	*sem = Semaphore_Count++;
+
+	pthread_mutex_unlock(&Pool_Lock);
+	return 0;
+}
+
+s32 LWP_SemDestroy(sem_t sem)
+{
+	return (sem < Semaphore_Count) ? 0 : -1;
+}
+
+s32 LWP_SemWait(sem_t sem)
+{
+	if (sem >= Semaphore_Count) return -1;
+
+	Semaphore* Object = &Semaphores[sem];
+
+	pthread_mutex_lock(&Object->Lock);
+
+	while (Object->Count == 0)
+	{
+		// A queued IPC command may be what this waits for, so let it complete
+		pthread_mutex_unlock(&Object->Lock);
+		bool Delivered = Host::Deliver_Next();
+		pthread_mutex_lock(&Object->Lock);
+
+		if (!Delivered && Object->Count == 0) pthread_cond_wait(&Object->Posted, &Object->Lock);
+	}
+
+	Object->Count--;
+	pthread_mutex_unlock(&Object->Lock);
+
+	return 0;
+}
+
+s32 LWP_SemPost(sem_t sem)
+{
+	if (sem >= Semaphore_Count) return -1;
+
+	Semaphore* Object = &Semaphores[sem];
+
+	pthread_mutex_lock(&Object->Lock);
+	if (Object->Count < Object->Max) Object->Count++;
+	pthread_cond_signal(&Object->Posted);
+	pthread_mutex_unlock(&Object->Lock);
+
+	return 0;
+}
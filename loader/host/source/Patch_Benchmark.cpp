@@ -0,0 +1,334 @@
+/*******************************************************************************
+ * Patch_Benchmark.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: times the single pass patch engine against the scanners it
+ *	replaced (one pass per patch, kept here as the reference) on a synthetic
+ *	image, and checks both produce the same bytes.  Then times each path of
+ *	the search kernel, and checks they all find the same words as a plain
+ *	loop on random data dense with keys.
+ *
+ *	The image is random words split into DOL sized sections; the patterns
+ *	sit near the end of the last section, so every scan covers everything.
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <time.h>
+
+#include <ogc/conf.h>
+
+#include "Host.h"
+#include "Memory_Map.h"
+#include "WiiDisc.h"
+#include "Patcher.h"
+#include "Pattern_Search.h"
+#include "Configuration.h"
+
+//--------------------------------------
+// Reference scanners
+
+namespace
+{
+	enum
+	{
+		Section_Size	= 0x200000,		// Typical large DOL section
+		Runs			= 5
+	};
+
+	// Former Patcher::Set_GameLanguage, with a fixed language
+	bool Reference_Language(void* Address, int Size, int Language)
+	{
+		unsigned int PatchData[3]	= { 0x7C600775, 0x40820010, 0x38000000 };
+		unsigned int* Addr			= (unsigned int*)Address;
+		bool SearchTarget			= false;
+
+		while (Size >= 16)
+		{
+			if (SearchTarget)
+			{
+				if (BE32(*Addr) == 0x88610008)
+				{
+					*Addr = BE32(0x38600000 | Language);
+					return true;
+				}
+			}
+			else if (BE32(Addr[0]) == PatchData[0] && BE32(Addr[1]) == PatchData[1] && BE32(Addr[2]) == PatchData[2])
+			{
+				SearchTarget = true;
+			}
+
+			Addr += 1;
+			Size -= 4;
+		}
+
+		return false;
+	}
+
+	// Former Patcher::Patch_Country_Strings, US console and US disc
+	bool Reference_Country(void* Address, int Size)
+	{
+		u8* Addr = (u8*)Address;
+
+		while (Size >= 4)
+		{
+			if (Addr[0] == 0x01 && Addr[1] == 'U' && Addr[2] == 'S' && Addr[3] == 0x00)
+			{
+				Addr[1] = 'U';
+				Addr[2] = 'S';
+				return true;
+			}
+
+			Addr += 4;
+			Size -= 4;
+		}
+
+		return false;
+	}
+
+	double Seconds()
+	{
+		struct timespec Now;
+		clock_gettime(CLOCK_MONOTONIC, &Now);
+
+		return Now.tv_sec + Now.tv_nsec / 1e9;
+	}
+
+	void Fill(byte* Image, unsigned int Size)
+	{
+		dword* Words = (dword*)Image;
+		dword Seed = 0x12345678;
+
+		for (unsigned int i = 0; i < Size / 4; i++)
+		{
+			Seed = Seed * 1664525 + 1013904223;
+			Words[i] = Seed;
+		}
+
+		// Patterns near the end, with the language target some way after its check
+		dword* End = Words + Size / 4;
+
+		End[-0x400] = BE32(0x7C600775);
+		End[-0x3ff] = BE32(0x40820010);
+		End[-0x3fe] = BE32(0x38000000);
+		End[-0x3e0] = BE32(0x88610008);
+		End[-0x100] = BE32(0x01555300);
+	}
+
+	// Every key index from Start, found by a plain loop
+	unsigned int Reference_Next(const dword* Words, unsigned int Start, unsigned int Count, const dword* Keys, unsigned int Key_Count)
+	{
+		for (unsigned int i = Start; i < Count; i++)
+		{
+			for (unsigned int k = 0; k < Key_Count; k++)
+			{
+				if (BE32(Words[i]) == Keys[k]) return i;
+			}
+		}
+
+		return Count;
+	}
+
+	// Checks every kernel path against the plain loop, with unaligned starts and sizes
+	bool Kernel_Equivalence(unsigned int* Searches)
+	{
+		enum { Words = 0x4000, Trials = 64 };
+
+		static dword	Buffer[Words + 8];
+		dword			Seed = 0x9e3779b9;
+
+		*Searches = 0;
+
+		for (unsigned int Trial = 0; Trial < Trials; Trial++)
+		{
+			Pattern_Search	Search;
+			dword			Keys[Pattern_Search::Max_Keys];
+			unsigned int	Key_Count = 1 + Trial % Pattern_Search::Max_Keys;
+
+			for (unsigned int k = 0; k < Key_Count; k++)
+			{
+				Seed = Seed * 1664525 + 1013904223;
+				Keys[k] = Seed;
+				Search.Add(Keys[k]);
+			}
+
+			// About one word in 64 is a key, others share a key's low bits
+			for (unsigned int i = 0; i < Words + 8; i++)
+			{
+				Seed = Seed * 1664525 + 1013904223;
+				dword Value = Seed;
+
+				if ((Seed >> 26) == 0)			Value = Keys[(Seed >> 8) % Key_Count];
+				else if ((Seed >> 26) == 1)		Value = (Value & ~0xfffu) | (Keys[(Seed >> 8) % Key_Count] & 0xfff);
+
+				Buffer[i] = BE32(Value);
+			}
+
+			const dword*	Base	= Buffer + Trial % 8;
+			unsigned int	Count	= Words - Trial % 5;
+
+			for (int Kernel = 0; Kernel < Pattern_Search::Paths; Kernel++)
+			{
+				if (!Pattern_Search::Supported((Pattern_Search::Path)Kernel)) continue;
+
+				unsigned int Expected = Reference_Next(Base, 0, Count, Keys, Key_Count);
+				unsigned int Found = Search.Next((Pattern_Search::Path)Kernel, Base, 0, Count);
+
+				while (true)
+				{
+					(*Searches)++;
+
+					if (Found != Expected)
+					{
+						printf("Kernel %s found %u instead of %u (%u keys)\n", Pattern_Search::Path_Name((Pattern_Search::Path)Kernel), Found, Expected, Key_Count);
+						return false;
+					}
+
+					if (Found >= Count) break;
+
+					Expected	= Reference_Next(Base, Found + 1, Count, Keys, Key_Count);
+					Found		= Search.Next((Pattern_Search::Path)Kernel, Base, Found + 1, Count);
+				}
+			}
+		}
+
+		return true;
+	}
+}
+
+/*******************************************************************************
+ * Patch_Benchmark: Time the patch engine on a synthetic image
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 0 if the engine and the reference agree, 1 otherwise
+ *
+ ******************************************************************************/
+
+int Host::Patch_Benchmark(unsigned int Size)
+{
+	Size &= ~(Section_Size - 1);
+	if (Size == 0) Size = Section_Size;
+
+	byte* Original	= (byte*)memalign(0x20, Size);
+	byte* Reference	= (byte*)memalign(0x20, Size);
+	byte* Engine	= (byte*)memalign(0x20, Size);
+
+	if (!Original || !Reference || !Engine)
+	{
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	Fill(Original, Size);
+
+	Configuration* Cfg = Configuration::Instance();
+	Cfg->Data.Language					= 3;
+	Cfg->Data.Country_String_Patching	= true;
+	Set_Region(CONF_REGION_US);
+
+	Patcher* Patch	= Patcher::Instance();
+	double Best_Reference	= 1e9;
+	double Best_Engine		= 1e9;
+
+	for (int Run = 0; Run < Runs; Run++)
+	{
+		// Separate passes, section by section, like the old load loop
+		memcpy(Reference, Original, Size);
+
+		double Start = Seconds();
+		bool Language = false, Country = false;
+
+		for (unsigned int Offset = 0; Offset < Size; Offset += Section_Size)
+		{
+			if (!Language) Language = Reference_Language(Reference + Offset, Section_Size, Cfg->Data.Language);
+			if (!Country) Country = Reference_Country(Reference + Offset, Section_Size);
+		}
+
+		double Time = Seconds() - Start;
+		if (Time < Best_Reference) Best_Reference = Time;
+
+		// Single pass
+		memcpy(Engine, Original, Size);
+
+		Start = Seconds();
+		Patch->Prepare("RXXE");		// Any US disc
+
+		for (unsigned int Offset = 0; Offset < Size; Offset += Section_Size)
+		{
+			if (Patch->Pending()) Patch->Scan(Engine + Offset, Section_Size, Offset);
+		}
+
+		Time = Seconds() - Start;
+		if (Time < Best_Engine) Best_Engine = Time;
+	}
+
+	bool Same = (memcmp(Reference, Engine, Size) == 0);
+	double MiB = Size / 1048576.0;
+
+	printf("Patch benchmark: %.0f MiB in %u sections, best of %d runs\n", MiB, Size / Section_Size, Runs);
+	printf("Separate scanners: %8.2f ms (%.0f MiB/s)\n", Best_Reference * 1000, MiB / Best_Reference);
+	printf("Single pass:       %8.2f ms (%.0f MiB/s)\n", Best_Engine * 1000, MiB / Best_Engine);
+
+	for (unsigned int i = 0; const Patcher::Rule* Entry = Patch->Get_Rule(i); i++)
+	{
+		printf("Rule %-16s %u hits\n", Entry->Name, Entry->Hits);
+	}
+
+	printf("Output %s the reference\n", Same ? "matches" : "DIFFERS from");
+
+	// Kernel paths alone, with the engine's keys over the whole image
+	Pattern_Search Search;
+	Search.Add(0x7C600775);
+	Search.Add(0x88610008);
+	Search.Add(0x01555300);
+
+	for (int Kernel = 0; Kernel < Pattern_Search::Paths; Kernel++)
+	{
+		if (!Pattern_Search::Supported((Pattern_Search::Path)Kernel)) continue;
+
+		double			Best	= 1e9;
+		unsigned int	Found	= 0;
+
+		for (int Run = 0; Run < Runs; Run++)
+		{
+			const dword*	Words	= (const dword*)Original;
+			unsigned int	Count	= Size / 4;
+
+			double Start = Seconds();
+			Found = 0;
+
+			for (unsigned int i = Search.Next((Pattern_Search::Path)Kernel, Words, 0, Count); i < Count; i = Search.Next((Pattern_Search::Path)Kernel, Words, i + 1, Count))
+			{
+				Found++;
+			}
+
+			double Time = Seconds() - Start;
+			if (Time < Best) Best = Time;
+		}
+
+		printf("Kernel %-6s      %8.2f ms (%.0f MiB/s), %u keys found\n", Pattern_Search::Path_Name((Pattern_Search::Path)Kernel), Best * 1000, MiB / Best, Found);
+	}
+
+	unsigned int Searches;
+	bool Equivalent = Kernel_Equivalence(&Searches);
+
+	printf("Kernel paths %s the plain loop (%u searches)\n", Equivalent ? "agree with" : "DIFFER from", Searches);
+
+	free(Original);
+	free(Reference);
+	free(Engine);
+
+	return (Same && Equivalent) ? 0 : 1;
+}
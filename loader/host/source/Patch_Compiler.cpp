@@ -0,0 +1,341 @@
+/*******************************************************************************
+ * Patch_Compiler.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: compiles a text patch list into the database the loader
+ *	reads from sd:/SoftChip/Patches.bin, and validates it.  The source is
+ *	one keyword per line; '#' starts a comment:
+ *
+ *		patch Language_Fix		Starts an entry, name up to 19 characters
+ *		game RSB				Disc ID prefix (optional, every game)
+ *		region PDF				Disc region letters (optional, every region)
+ *		segment text			text, data or any (default any)
+ *		match 7C600775 4082????	Up to 4 words, '?' is a wildcard nibble
+ *		target 2				Word to rewrite, from the match start (default 0)
+ *		value 38600001			Replacement
+ *		mask FFFF0000			Bits of the target replaced (default all)
+ *		limit 1					Writes per boot (default 1, 0 for no limit)
+ *		requires Other			Earlier entry that must match first
+ *		trigger					Only enables entries requiring it, no write
+ *		end
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Host.h"
+#include "Patcher.h"
+#include "Patch_Database.h"
+
+//--------------------------------------
+// Source parsing
+
+namespace
+{
+	struct Source_Entry
+	{
+		Patch_Database::Entry	Entry;			// Host byte order
+		bool					Has_Value;
+	};
+
+	Source_Entry	Entries[Patch_Database::Max_Entries];
+	unsigned int	Entry_Count;
+
+	// Parses a hex word of up to 8 digits, '?' nibbles clear the matching bits of Mask
+	bool Parse_Word(const char* Text, dword* Value, dword* Mask)
+	{
+		if (strncmp(Text, "0x", 2) == 0 || strncmp(Text, "0X", 2) == 0) Text += 2;
+		int Length = strlen(Text);
+		if (Length == 0 || Length > 8) return false;
+
+		*Value	= 0;
+		*Mask	= 0;
+
+		for (int i = 0; i < Length; i++)
+		{
+			char	Digit	= Text[i];
+			dword	Nibble	= 0;
+			dword	Known	= 0xf;
+
+			if (Digit >= '0' && Digit <= '9')		Nibble = Digit - '0';
+			else if (Digit >= 'a' && Digit <= 'f')	Nibble = Digit - 'a' + 10;
+			else if (Digit >= 'A' && Digit <= 'F')	Nibble = Digit - 'A' + 10;
+			else if (Digit == '?')					Known = 0;
+			else return false;
+
+			*Value	= (*Value << 4) | Nibble;
+			*Mask	= (*Mask << 4) | Known;
+		}
+
+		return true;
+	}
+
+	int Find_Entry(const char* Name)
+	{
+		for (unsigned int i = 0; i < Entry_Count; i++)
+		{
+			if (strcmp(Entries[i].Entry.Name, Name) == 0) return i;
+		}
+
+		return -1;
+	}
+
+	// Handles one line of an entry; returns 0 or an error message
+	const char* Parse_Keyword(Source_Entry* Current, char* Keyword, char* Argument)
+	{
+		Patch_Database::Entry* Entry = &Current->Entry;
+
+		if (strcmp(Keyword, "game") == 0)
+		{
+			if (!Argument || strlen(Argument) >= Patch_Database::ID_Length) return "bad game ID";
+			strcpy(Entry->Game_ID, Argument);
+		}
+		else if (strcmp(Keyword, "region") == 0)
+		{
+			if (!Argument || strlen(Argument) > Patch_Database::Regions_Length) return "bad region list";
+			strncpy(Entry->Regions, Argument, Patch_Database::Regions_Length);
+		}
+		else if (strcmp(Keyword, "segment") == 0)
+		{
+			if (!Argument)								return "missing segment";
+			else if (strcmp(Argument, "text") == 0)		Entry->Segments = Patcher::Segment_Text;
+			else if (strcmp(Argument, "data") == 0)		Entry->Segments = Patcher::Segment_Data;
+			else if (strcmp(Argument, "any") == 0)		Entry->Segments = Patcher::Segment_Any;
+			else										return "segment must be text, data or any";
+		}
+		else if (strcmp(Keyword, "match") == 0)
+		{
+			Entry->Length = 0;
+
+			for (char* Word = Argument; Word; Word = strtok(0, " \t\r\n"))
+			{
+				if (Entry->Length >= Patch_Database::Max_Words) return "pattern longer than 4 words";
+
+				dword Value, Mask;
+				if (!Parse_Word(Word, &Value, &Mask)) return "bad pattern word";
+
+				Entry->Pattern[Entry->Length]		= Value & Mask;
+				Entry->Pattern_Mask[Entry->Length]	= Mask;
+				Entry->Length++;
+			}
+		}
+		else if (strcmp(Keyword, "target") == 0)
+		{
+			int Target = Argument ? atoi(Argument) : 0;
+			if (!Argument || Target < -128 || Target > 127) return "target out of range";
+
+			Entry->Target = Target;
+		}
+		else if (strcmp(Keyword, "value") == 0 || strcmp(Keyword, "mask") == 0)
+		{
+			dword Value, Mask;
+			if (!Argument || !Parse_Word(Argument, &Value, &Mask) || Mask != 0xffffffff) return "bad word";
+
+			if (Keyword[0] == 'v')
+			{
+				Entry->Value		= Value;
+				Current->Has_Value	= true;
+			}
+			else Entry->Mask = Value;
+		}
+		else if (strcmp(Keyword, "limit") == 0)
+		{
+			int Limit = Argument ? atoi(Argument) : -1;
+			if (Limit < 0 || Limit > 255) return "limit out of range";
+
+			Entry->Limit = Limit;
+		}
+		else if (strcmp(Keyword, "requires") == 0)
+		{
+			int Index = Argument ? Find_Entry(Argument) : -1;
+			if (Index < 0) return "requires an unknown or later entry";
+
+			Entry->Requires = Index;
+		}
+		else if (strcmp(Keyword, "trigger") == 0)
+		{
+			Entry->Flags &= ~Patch_Database::Flag_Write;
+		}
+		else return "unknown keyword";
+
+		return 0;
+	}
+
+	// Checks what the keywords can't on their own
+	const char* Finish_Entry(Source_Entry* Current)
+	{
+		Patch_Database::Entry* Entry = &Current->Entry;
+
+		if (Entry->Length == 0)												return "missing match";
+		if ((Entry->Flags & Patch_Database::Flag_Write) && !Current->Has_Value)	return "missing value (or trigger)";
+
+		const char* Error = Patcher::Check_Entry(Entry, Entry_Count);
+		if (Error) return Error;
+
+		return 0;
+	}
+
+	bool Parse(FILE* fp, const char* Source)
+	{
+		char			Line[256];
+		unsigned int	Number	= 0;
+		Source_Entry*	Current	= 0;
+
+		Entry_Count = 0;
+
+		while (fgets(Line, sizeof(Line), fp))
+		{
+			Number++;
+
+			char* Comment = strchr(Line, '#');
+			if (Comment) *Comment = 0;
+
+			char* Keyword = strtok(Line, " \t\r\n");
+			if (!Keyword) continue;
+
+			char* Argument = strtok(0, " \t\r\n");
+			const char* Error = 0;
+
+			if (strcmp(Keyword, "patch") == 0)
+			{
+				if (Current)												Error = "missing end";
+				else if (Entry_Count >= Patch_Database::Max_Entries)		Error = "too many entries";
+				else if (!Argument || strlen(Argument) >= Patch_Database::Name_Length)	Error = "bad name";
+				else if (Find_Entry(Argument) >= 0)						Error = "duplicate name";
+				else
+				{
+					Current = &Entries[Entry_Count];
+					memset(Current, 0, sizeof(Source_Entry));
+
+					strcpy(Current->Entry.Name, Argument);
+					Current->Entry.Segments	= Patcher::Segment_Any;
+					Current->Entry.Flags	= Patch_Database::Flag_Write;
+					Current->Entry.Limit	= 1;
+					Current->Entry.Requires	= -1;
+					Current->Entry.Mask		= 0xffffffff;
+				}
+			}
+			else if (!Current)
+			{
+				Error = "keyword outside of a patch";
+			}
+			else if (strcmp(Keyword, "end") == 0)
+			{
+				Error = Finish_Entry(Current);
+
+				if (!Error)
+				{
+					Entry_Count++;
+					Current = 0;
+				}
+			}
+			else Error = Parse_Keyword(Current, Keyword, Argument);
+
+			if (Error)
+			{
+				fprintf(stderr, "%s:%u: %s\n", Source, Number, Error);
+				return false;
+			}
+		}
+
+		if (Current)
+		{
+			fprintf(stderr, "%s: missing end after %s\n", Source, Current->Entry.Name);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool Write(const char* Output)
+	{
+		FILE* fp = fopen(Output, "wb");
+		if (!fp) return false;
+
+		Patch_Database::Header Head;
+		memset(&Head, 0, sizeof(Head));
+		memcpy(Head.Signature, Patch_Database::Signature, sizeof(Head.Signature));
+
+		Head.Version	= Patch_Database::Version;
+		Head.Count		= BE32(Entry_Count);
+
+		bool Result = (fwrite(&Head, 1, sizeof(Head), fp) == sizeof(Head));
+
+		for (unsigned int i = 0; Result && i < Entry_Count; i++)
+		{
+			Patch_Database::Entry Entry = Entries[i].Entry;
+
+			for (int Word = 0; Word < Patch_Database::Max_Words; Word++)
+			{
+				Entry.Pattern[Word]			= BE32(Entry.Pattern[Word]);
+				Entry.Pattern_Mask[Word]	= BE32(Entry.Pattern_Mask[Word]);
+			}
+
+			Entry.Value	= BE32(Entry.Value);
+			Entry.Mask	= BE32(Entry.Mask);
+
+			Result = (fwrite(&Entry, 1, sizeof(Entry), fp) == sizeof(Entry));
+		}
+
+		return (fclose(fp) == 0) && Result;
+	}
+}
+
+/*******************************************************************************
+ * Compile_Patches: Compile a text patch list into the loader's database
+ * -----------------------------------------------------------------------------
+ * Without an output file the source is only validated.  The written file is
+ * read back with the loader's own parser.
+ *
+ * Return Values:
+ *	returns 0 on success, 1 on error
+ *
+ ******************************************************************************/
+
+int Host::Compile_Patches(const char* Source, const char* Output)
+{
+	FILE* fp = fopen(Source, "r");
+
+	if (!fp)
+	{
+		fprintf(stderr, "Can't open %s\n", Source);
+		return 1;
+	}
+
+	bool Parsed = Parse(fp, Source);
+	fclose(fp);
+
+	if (!Parsed) return 1;
+
+	printf("%s: %u entries\n", Source, Entry_Count);
+
+	if (!Output) return 0;
+
+	if (!Write(Output))
+	{
+		fprintf(stderr, "Can't write %s\n", Output);
+		return 1;
+	}
+
+	if (!Patcher::Instance()->Load_Database(Output))
+	{
+		fprintf(stderr, "%s: rejected by the loader\n", Output);
+		return 1;
+	}
+
+	printf("Wrote %s (%u bytes)\n", Output,
+		(unsigned int)(sizeof(Patch_Database::Header) + Entry_Count * sizeof(Patch_Database::Entry)));
+
+	return 0;
+}
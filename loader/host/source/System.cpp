@@ -0,0 +1,107 @@
+/*******************************************************************************
+ * System.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: arena, cache, timebase, settings and FAT parts of the libogc
+ *	shim
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <malloc.h>
+
+#include <ogc/system.h>
+#include <ogc/cache.h>
+#include <ogc/conf.h>
+#include <ogc/lwp_watchdog.h>
+#include <sdcard/wiisd_io.h>
+#include <fat.h>
+
+#include "Host.h"
+#include "Drive_Model.h"
+
+static s32 Region = CONF_REGION_US;
+
+//--------------------------------------
+// Host
+
+void Host::Set_Region(s32 Region)
+{
+	::Region = Region;
+}
+
+//--------------------------------------
+// System
+
+// The arena is never handed back, so plain aligned heap memory will do
+void* SYS_AllocArena2MemLo(u32 size, u32 align)
+{
+	return memalign(align, size);
+}
+
+//--------------------------------------
+// Cache (coherent on the host)
+
+void DCFlushRange(void* startaddress, u32 len) {}
+void DCInvalidateRange(void* startaddress, u32 len) {}
+void DCStoreRange(void* startaddress, u32 len) {}
+void ICInvalidateRange(void* startaddress, u32 len) {}
+
+//--------------------------------------
+// Conf
+
+s32 CONF_GetRegion(void)
+{
+	return Region;
+}
+
+//--------------------------------------
+// Timebase
+
+// Simulated time, which is host time unless the drive model is enabled
+u64 gettime(void)
+{
+	return Drive_Model::Instance()->Now();
+}
+
+// The simulated clock can't be set; callers only rely on it staying monotonic
+extern "C" void settime(u64 time) {}
+
+u32 diff_sec(u64 start, u64 end)
+{
+	return (u32)ticks_to_secs(end - start);
+}
+
+u32 diff_msec(u64 start, u64 end)
+{
+	return (u32)ticks_to_millisecs(end - start);
+}
+
+u32 diff_usec(u64 start, u64 end)
+{
+	return (u32)ticks_to_microsecs(end - start);
+}
+
+//--------------------------------------
+// FAT
+
+static bool SD_Startup(void) { return true; }
+static bool SD_Shutdown(void) { return true; }
+
+const DISC_INTERFACE __io_wiisd = { 0, 0, SD_Startup, 0, 0, 0, 0, SD_Shutdown };
+
+// "sd:/..." is used as a relative path, so mounting has nothing to do
+bool fatMountSimple(const char* name, const DISC_INTERFACE* interface)
+{
+	return true;
+}
+
+void fatUnmount(const char* name) {}
@@ -0,0 +1,553 @@
+/*******************************************************************************
+ * main.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Host build: runs the platform independent part of Load_Disc against a
+ *	disc image - disc and partition parsing through the DIP class, then the
+ *	apploader load loop with per-section patching.  The apploader itself is
+ *	PowerPC code; a stand-in hands out the same sections (Host_Apploader).
+ *
+ *	The drive is simulated by the Drive_Model, so the reported boot time is
+ *	what the command sequence would take on the console.
+ *
+ *	Usage: softchip-host [-r JP|US|EU|KR|CN] [-l Language] [-c] [-f] [-s Scale] [-t] [-m] [-w] [-i] <image>
+ *	       softchip-host -b [MiB]      (patch engine benchmark, default 24 MiB)
+ *
+ *	The SD card is the "sd:" directory in the current directory (config,
+ *	log and common.key are read from sd:/SoftChip like on the console).
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include <ogc/conf.h>
+#include <ogc/lwp_watchdog.h>
+
+#include "Host.h"
+#include "Memory_Map.h"
+#include "WiiDisc.h"
+#include "DIP.h"
+#include "Disc_Image.h"
+#include "Drive_Model.h"
+#include "Host_Apploader.h"
+#include "Apploader.h"
+#include "Patcher.h"
+#include "Configuration.h"
+#include "Logger.h"
+#include "Storage.h"
+#include "Profiler.h"
+#include "Coherency.h"
+#include "Buffer_Pool.h"
+#include "Boot_Bundle.h"
+#include "Disc_Probe.h"
+
+/*******************************************************************************
+ * Usage: Print the command line help
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 1
+ *
+ ******************************************************************************/
+
+static int Usage()
+{
+	fprintf(stderr, "Usage: softchip-host [-r JP|US|EU|KR|CN] [-l Language] [-c] [-f] [-s Scale] [-t] [-m] [-w] [-i] <image>\n");
+	fprintf(stderr, "       softchip-host -b [MiB]\n");
+	fprintf(stderr, "       softchip-host -p <patches.txt> [Patches.bin]\n");
+	fprintf(stderr, "\t-r\tConsole region (default US)\n");
+	fprintf(stderr, "\t-l\tPatch the game's language (-2 = by disc region)\n");
+	fprintf(stderr, "\t-c\tPatch the country strings\n");
+	fprintf(stderr, "\t-f\tFunctional run, no drive timing\n");
+	fprintf(stderr, "\t-s\tHost to console CPU time factor (default 1.0)\n");
+	fprintf(stderr, "\t-t\tLog and write the boot trace (sd:/SoftChip/Boot_Trace.json)\n");
+	fprintf(stderr, "\t-m\tIgnore and keep the patch memo (sd:/SoftChip/Patch_Memo.bin)\n");
+	fprintf(stderr, "\t-w\tOpen the disc while the menu is shown, the boot time counts from A\n");
+	fprintf(stderr, "\t-i\tRead the IOS the game requests before the IOS is loaded\n");
+	fprintf(stderr, "\t-b\tBenchmark the patch engine on a synthetic image\n");
+	fprintf(stderr, "\t-p\tCompile a patch list for the SD card (validate only without output)\n");
+	return 1;
+}
+
+/*******************************************************************************
+ * Parse_Region: Convert a region name for CONF_GetRegion
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the CONF_REGION value, or -1 if unknown
+ *
+ ******************************************************************************/
+
+static s32 Parse_Region(const char* Name)
+{
+	if (strcmp(Name, "JP") == 0) return CONF_REGION_JP;
+	if (strcmp(Name, "US") == 0) return CONF_REGION_US;
+	if (strcmp(Name, "EU") == 0) return CONF_REGION_EU;
+	if (strcmp(Name, "KR") == 0) return CONF_REGION_KR;
+	if (strcmp(Name, "CN") == 0) return CONF_REGION_CN;
+
+	return -1;
+}
+
+/*******************************************************************************
+ * Print_Drive: Print the simulated boot time and where it went
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+static void Print_Drive(u64 Start, u64 End)
+{
+	Drive_Model* Drive = Drive_Model::Instance();
+
+	printf("Simulated boot time: %u us\n", diff_usec(Start, End));
+	printf("Drive: %u commands, %u seeks, %u spin-ups, %llu bytes\n", Drive->Commands, Drive->Seeks, Drive->Spin_Ups, Drive->Bytes);
+	printf("Drive busy: %llu us (spin-up %llu, seek %llu, rotation %llu, transfer %llu)\n",
+		Drive->Busy_Time, Drive->Spin_Up_Time, Drive->Seek_Time, Drive->Rotation_Time, Drive->Transfer_Time);
+}
+
+/*******************************************************************************
+ * Load_Disc: Parse the disc and run the apploader load loop
+ * -----------------------------------------------------------------------------
+ * Same command sequence as SoftChip::Load_Disc, without the IOS reload.
+ *
+ * Return Values:
+ *	returns void, throws on error like SoftChip::Load_Disc
+ *
+ ******************************************************************************/
+
+static void* Boot_Buffer(unsigned int Length)
+{
+	void* Buffer = Buffer_Pool::Instance()->Alloc(Length);
+	if (!Buffer) throw "Out of I/O buffers";
+
+	memset(Buffer, 0, Length);
+	return Buffer;
+}
+
+static void Load_Disc(Disc_Source* DI, DIP* Drive, u64 Start, bool No_Memo)
+{
+	// As in SoftChip::Load_Disc, the I/O buffers come from the pool
+	Buffer_Scope		Boot_Buffers;
+	Apploader::Header&	Loader			= *(Apploader::Header*)Boot_Buffer(sizeof(Apploader::Header));
+
+	Configuration*	Cfg = Configuration::Instance();
+	Logger*			Log = Logger::Instance();
+
+	Boot_Bundle*	Bundle	= Boot_Bundle::Instance();
+	Disc_Probe*		Probe	= Disc_Probe::Instance();
+
+	// The disc may have been opened while the menu was shown (-w), unless the drive was stopped since
+	bool Probed = (Probe->Claim() == Disc_Probe::Stage_Opened);
+
+	if (Probed && !Drive->Spin.Spinning())
+	{
+		DI->Close_Partition();
+		Probed = false;
+	}
+
+	if (!Probed)
+	{
+		Bundle->Begin();
+
+		bool Disc_Inserted = false;
+
+		{
+			Scoped_Timer Cover_Timer("Verify_Cover");
+			if (DI->Verify_Cover(&Disc_Inserted) < 0) throw "Verify_Cover failed";
+		}
+
+		if (!Disc_Inserted) throw "No disc inserted";
+
+		Probe->Open(DI);
+	}
+
+	Log->Write("Disc probe: %s\r\n", Probed ? "opened while the menu was shown" : (Probe->Error ? Probe->Error : "not done"));
+
+	Wii_Disc::Header& Header = *Probe->Header;
+	if (BE32(Header.Magic) != 0x5d1c9ea3) throw "Not a Wii disc";
+
+	char ID[8];
+	memset(ID, 0, sizeof(ID));
+	memcpy(ID, &Header.ID, 6);			// Game and maker code, like Memory::Disc_ID
+
+	char Title[sizeof(Header.Title) + 1];
+	memset(Title, 0, sizeof(Title));
+	memcpy(Title, Header.Title, sizeof(Header.Title));
+
+	printf("Disc ID: %s\n", ID);
+	printf("Disc Title: %s\n", Title);
+	Log->Write("Disc ID: %s\r\n", ID);
+	Log->Write("Disc Title: %s\r\n", Title);
+
+	printf("Boot Partition is located at: 0x%llx\n", (qword)Probe->Partition.Offset << 2);
+
+	byte* Tmd_Buffer = Probe->TMD;
+
+	printf("IOS requested by the game inside the tmd: %u\n", Tmd_Buffer[0x18b]);
+
+	// As in SoftChip::Load_Disc, the last boot's sections are staged while the apploader starts
+	{
+		Scoped_Timer Plan_Timer("Load_Plan");
+		DI->Load_Plan(ConfigData::Default_PlanFile, &Probe->Disc_ID);
+	}
+
+	// Apploader header and payload (the payload isn't run, but the drive reads it)
+	if (DI->Read(&Loader, sizeof(Apploader::Header), Wii_Disc::Offsets::Apploader) < 0) throw "Error reading the apploader header";
+
+	dword Payload_Size = (BE32(Loader.Size) + BE32(Loader.Trailer_Size) + 0x1f) & ~0x1f;
+
+	if (Payload_Size)
+	{
+		void* Payload = memalign(0x20, Payload_Size);
+		if (!Payload) throw "Out of memory";
+
+		int Ret = DI->Read(Payload, Payload_Size, Wii_Disc::Offsets::Apploader + 0x20);
+		free(Payload);
+
+		if (Ret < 0) throw "Error reading the apploader";
+	}
+
+	Apploader::Enter	Enter	= 0;
+	Apploader::Load		Load	= 0;
+	Apploader::Exit		Exit	= 0;
+
+	Host_Apploader::Start(&Enter, &Load, &Exit);
+	Enter((Apploader::Report)printf);
+
+	// Load loop, as in SoftChip::Load_Disc
+	Patcher* Patch = Patcher::Instance();
+	Patch->Prepare(ID);
+
+	// As in SoftChip::Load_Disc, everything is scanned if main.dol's header can't be read
+	Wii_Disc::DOL_Header* DOL = (Wii_Disc::DOL_Header*)Boot_Buffer(sizeof(Wii_Disc::DOL_Header));
+	dword DOL_Offset;
+
+	if (!Wii_Disc::Read_DOL_Header(DI, DOL, &DOL_Offset) || !Patch->Set_DOL(DOL, DOL_Offset))
+	{
+		Log->Write("Warning: main.dol header unusable, patching every section\r\n");
+	}
+
+	if (!No_Memo) Patch->Load_Memo(ConfigData::Default_MemoFile);
+
+	// The loader's and the apploader's globals, at the start of MEM1
+	Coherency* Cache = Coherency::Instance();
+	Cache->Clear();
+	Cache->Touch(Host_Apploader::MEM1(), Memory::Globals_End - Memory::Disc_ID);
+
+	void*	Address = 0;
+	int		Section_Size;
+	int		Partition_Offset;
+	int		Section_Count = 0;
+	u64		Patch_Time = 0;
+
+	Profiler* Prof = Profiler::Instance();
+	u64 Apploader_Start = Prof->Now();
+
+	bool	Loading = Load(&Address, &Section_Size, &Partition_Offset);
+
+	if (Loading)
+	{
+		if (!Address) throw "Null pointer from apploader";
+		DI->Queue_Read(Address, Section_Size, Partition_Offset << 2);
+	}
+
+	while (Loading)
+	{
+		if (DI->Read_Pending())
+		{
+			Scoped_Timer Wait_Timer("Wait_Read");
+			DI->Wait_Read();
+		}
+
+		void*	Section			= Address;
+		int		Section_Length	= Section_Size;
+		dword	Section_Offset	= Partition_Offset << 2;
+
+		Loading = Load(&Address, &Section_Size, &Partition_Offset);
+		if (Loading && !Address) throw "Null pointer from apploader";
+
+		bool	Overlaps = Loading
+						&& (byte*)Address < (byte*)Section + Section_Length
+						&& (byte*)Section < (byte*)Address + Section_Size;
+
+		if (Loading && !Overlaps) DI->Queue_Read(Address, Section_Size, Partition_Offset << 2);
+
+		{
+			Scoped_Timer Patch_Timer("Patch");
+			u64 Patch_Start = gettime();
+
+			if (Patch->Pending()) Patch->Scan(Section, Section_Length, Section_Offset);
+			Cache->Touch(Section, Section_Length);
+
+			Patch_Time += gettime() - Patch_Start;
+		}
+
+		Section_Count++;
+
+		if (Loading && Overlaps) DI->Queue_Read(Address, Section_Size, Partition_Offset << 2);
+	}
+
+	Prof->Record("Apploader", Apploader_Start, Prof->Now());
+
+	if (!DI->Save_Plan(ConfigData::Default_PlanFile)) fprintf(stderr, "Can't save the prefetch plan\n");
+	if (DI == Bundle) Bundle->Commit();
+
+	void* Entry = Exit();
+
+	Cache->Flush();
+
+	u64 End = gettime();
+
+	printf("Loaded %d sections, entry 0x%lx\n", Section_Count, (unsigned long)Entry);
+
+	if (Cfg->Data.Language != -1) printf("Language: %s\n", Patch->Applied(Patcher::Patch_Language) ? "patched" : "pattern not found");
+	if (Cfg->Data.Country_String_Patching) printf("Country strings: %s\n", Patch->Applied(Patcher::Patch_Country_Strings) ? "patched" : "pattern not found");
+
+	printf("Patching: %llu us, %llu of %llu bytes scanned\n", (qword)ticks_to_microsecs(Patch_Time), Patch->Scanned, Patch->Loaded);
+	printf("Cache flush: %u bytes in %u ranges instead of %u\n", Cache->Flushed_Bytes, Cache->Flushed_Ranges, (unsigned int)Coherency::MEM1_Size);
+	printf("Buffer pool: peak %u bytes, %u bytes carved\n", Buffer_Pool::Instance()->Peak, Buffer_Pool::Instance()->Carved);
+	printf("Cluster cache: %u hits, %u misses\n", Drive->Cache.Hits, Drive->Cache.Misses);
+	printf("Drive motor: %u spin-ups, %u avoided, %u resets skipped, %u stops sent\n",
+		Drive->Spin.Spin_Ups, Drive->Spin.Spin_Ups_Avoided, Drive->Spin.Resets_Skipped, Drive->Spin.Stops);
+	printf("Prefetch plan: %s, %u of %u planned sections served, %u bytes staged in %u reads\n",
+		Drive->Prefetch.Status, Drive->Prefetch.Served, Drive->Prefetch.Planned, Drive->Prefetch.Staged_Bytes, Drive->Prefetch.Reads);
+
+	for (unsigned int i = 0; const Ioctl_Stats::Counters* Entry = Drive->Stats.Get(i); i++)
+	{
+		if (!Entry->Calls) continue;
+
+		printf("%-18s %3u calls, %u errors, %8llu bytes, avg %7llu us, max %7u us\n", Entry->Name, Entry->Calls, Entry->Errors,
+			(unsigned long long)Entry->Bytes, (unsigned long long)(Entry->Total_Time / Entry->Calls), Entry->Max_Time);
+	}
+
+	if (DI == Bundle)
+	{
+		printf("Boot bundle: %s, %u reads (%u bytes) served, %u missed, %u bytes recorded\n",
+			Bundle->Status, Bundle->Served, Bundle->Served_Bytes, Bundle->Missed, Bundle->Recorded_Bytes);
+	}
+
+	if (Drive_Model::Instance()->Enabled) Print_Drive(Start, End);
+
+	DI->Log_Statistics();
+	Patch->Log_Statistics();
+	Cache->Log_Statistics();
+	Buffer_Pool::Instance()->Log_Statistics();
+
+	if (!No_Memo && !Patch->Save_Memo(ConfigData::Default_MemoFile)) fprintf(stderr, "Can't save the patch memo\n");
+	DI->Close_Partition();
+}
+
+/*******************************************************************************
+ * int main: Application Entry Point
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *
+ * 0 = Success
+ ******************************************************************************/
+
+int main(int argc, char* argv[])
+{
+	const char*	Image		= 0;
+	s32			Region		= CONF_REGION_US;
+	int			Language	= -1;
+	bool		Country		= false;
+	bool		Timing		= true;
+	double		Scale		= 1.0;
+	bool		Trace		= false;
+	bool		No_Memo		= false;
+	bool		Menu		= false;
+	bool		Preflight	= false;
+
+	if (argc >= 2 && strcmp(argv[1], "-b") == 0)
+	{
+		unsigned int Size = (argc >= 3) ? atoi(argv[2]) : 24;
+		if (Size == 0 || Size > 256) return Usage();
+
+		return Host::Patch_Benchmark(Size << 20);
+	}
+
+	if (argc >= 3 && argc <= 4 && strcmp(argv[1], "-p") == 0)
+	{
+		Storage::Instance()->Initialize_FAT();
+		return Host::Compile_Patches(argv[2], (argc == 4) ? argv[3] : 0);
+	}
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+		{
+			Region = Parse_Region(argv[++i]);
+			if (Region < 0) return Usage();
+		}
+		else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+		{
+			Language = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-c") == 0)
+		{
+			Country = true;
+		}
+		else if (strcmp(argv[i], "-f") == 0)
+		{
+			Timing = false;
+		}
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+		{
+			Scale = atof(argv[++i]);
+			if (Scale <= 0) return Usage();
+		}
+		else if (strcmp(argv[i], "-t") == 0)
+		{
+			Trace = true;
+		}
+		else if (strcmp(argv[i], "-m") == 0)
+		{
+			No_Memo = true;
+		}
+		else if (strcmp(argv[i], "-w") == 0)
+		{
+			Menu = true;
+		}
+		else if (strcmp(argv[i], "-i") == 0)
+		{
+			Preflight = true;
+		}
+		else if (argv[i][0] != '-' && !Image)
+		{
+			Image = argv[i];
+		}
+		else return Usage();
+	}
+
+	if (!Image) return Usage();
+
+	Host::Set_Region(Region);
+
+	// Same start up as the loader
+	Storage::Instance()->Initialize_FAT();
+
+	Configuration* Cfg = Configuration::Instance();
+	Cfg->Read(ConfigData::Default_ConfigFile);
+
+	Patcher::Instance()->Load_Database(ConfigData::Default_PatchFile);
+
+	if (Language != -1) Cfg->Data.Language = Language;
+	if (Country) Cfg->Data.Country_String_Patching = true;
+	if (Trace) Cfg->Data.Logging = true;
+
+	Profiler* Prof = Profiler::Instance();
+	Prof->Enabled = Cfg->Data.Logging;
+
+	Logger* Log = Logger::Instance();
+	Log->ShowTime = true;
+	Log->OpenLog(ConfigData::Default_LogFile);
+	Log->Write("---------------------\r\n");
+	Log->Write("Loading Disc (host)...\r\n");
+
+	if (!Disc_Image::Instance()->Open(Image))
+	{
+		fprintf(stderr, "Can't open %s\n", Image);
+		return 1;
+	}
+
+	Drive_Model* Drive = Drive_Model::Instance();
+	Drive->Enabled		= Timing;
+	Drive->CPU_Scale	= Scale;
+
+	// Boot time counts from here; the loader stops the drive while it starts up
+	u64 Start = gettime();
+
+	DIP* DI = DIP::Instance();
+	DI->Spin.Idle_Timeout = Cfg->Data.Spin_Down * 60000;
+	DI->Cache.Size = Cfg->Data.Cache_Clusters;
+
+	if (!DI->Initialize())
+	{
+		fprintf(stderr, "Error Initializing DIP-Module.\n");
+		return 1;
+	}
+
+	// As in SoftChip::Load_IOS, the game's IOS is read before it's loaded, and the disc keeps spinning
+	if (Preflight)
+	{
+		bool		Inserted	= false;
+		byte		IOS			= 0;
+		dvddiskid*	Disc_ID		= (dvddiskid*)memalign(0x20, sizeof(dvddiskid));
+
+		try
+		{
+			Preflight = Disc_ID && DI->Verify_Cover(&Inserted) >= 0 && Inserted
+				&& DI->Reset() >= 0 && DI->Read_DiscID(Disc_ID) >= 0
+				&& Wii_Disc::Read_Requested_IOS(DI, &IOS);
+		}
+		catch (const char* Message)
+		{
+			Preflight = false;
+		}
+
+		free(Disc_ID);
+
+		if (Preflight) printf("IOS requested by the game, before the IOS is loaded: %u\n", IOS);
+		else printf("IOS preflight failed\n");
+	}
+
+	if (!Preflight) DI->Stop_Motor();
+
+	// As in SoftChip::Load_Disc, the probe's buffers are kept outside the boot's scope
+	Disc_Probe::Instance()->Initialize();
+
+	// Boot bundles as on the console, if sd:/SoftChip/Bundles exists
+	Disc_Source* Source = DI;
+	if (Boot_Bundle::Instance()->Open(ConfigData::Bundle_Folder, DI)) Source = Boot_Bundle::Instance();
+
+	// As on the console, the disc is opened while the menu is shown
+	if (Menu)
+	{
+		Disc_Probe* Probe = Disc_Probe::Instance();
+
+		Boot_Bundle::Instance()->Begin();
+
+		if (Probe->Start(Source))
+		{
+			Probe->Wait();
+			printf("Disc probe: %u us while the menu was shown\n", diff_usec(Probe->Started_At, Probe->Finished_At));
+
+			Start = gettime();
+		}
+	}
+
+	int Result = 0;
+
+	try
+	{
+		Load_Disc(Source, DI, Start, No_Memo);
+	}
+	catch (const char* Message)
+	{
+		fprintf(stderr, "Exception: %s\n", Message);
+		Log->Write("Exception: %s\r\n", Message);
+		Result = 1;
+	}
+
+	Prof->Record("Load_Disc", Start, Prof->Now());
+	if (Prof->Dump(ConfigData::Default_TraceFile)) printf("Boot trace written to %s\n", ConfigData::Default_TraceFile);
+
+	DI->Close();
+	Disc_Image::Instance()->Close();
+	Host_Apploader::Release();
+	Log->CloseLog();
+
+	return Result;
+}
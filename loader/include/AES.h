@@ -0,0 +1,45 @@
+/*******************************************************************************
+ * AES.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of an AES-128 CBC decryptor, used to read the
+ *	encrypted partitions of disc images
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// AES Class
+
+class AES
+{
+public:
+	void Set_Key(const byte* Key);
+	void Decrypt(const byte* IV, const byte* In, byte* Out, unsigned int size);
+
+	AES();
+	virtual ~AES();
+
+private:
+	byte Round_Keys[176];
+
+	static bool Tables_Ready;
+	static byte Sbox[256];
+	static byte Inv_Sbox[256];
+	static byte Mul9[256], Mul11[256], Mul13[256], Mul14[256];
+
+	static void Build_Tables();
+	void Decrypt_Block(const byte* In, byte* Out) const;
+};
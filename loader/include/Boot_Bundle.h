@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * Boot_Bundle.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a disc source serving a boot's reads from a
+ *	bundle on the SD card, in front of the drive or a disc image.  A boot
+ *	without a usable bundle records its reads, and a successful one writes
+ *	them to the bundle.  The bundle is only served once the disc ID and the
+ *	boot partition's TMD match it, and every read is checked against its
+ *	checksum; anything else is read from the disc.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+
+#include "Disc_Source.h"
+#include "Bundle_File.h"
+
+//--------------------------------------
+// Boot_Bundle Class
+
+class Boot_Bundle : public Disc_Source
+{
+public:
+	bool Open(const char* Bundle_Folder, Disc_Source* Disc);	// false if the folder doesn't exist
+	void Begin();												// Start of a boot
+	bool Commit();												// After a successful boot
+
+	bool Initialize();
+	void Close();
+
+	//----------------------------------
+	// Commands
+
+	int	Read_DiscID(dvddiskid* Disc_ID);
+	int Read(void* Buffer, unsigned int size, unsigned int offset);
+	int Read_Unencrypted(void* Buffer, unsigned int size, unsigned int offset);
+	int	Wait_CoverClose();
+	int Verify_Cover(bool *Inserted);
+	int Reset();
+	int Set_OffsetBase(unsigned int Base);
+	int Get_OffsetBase(unsigned int* Base);
+	int	Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, unsigned int Cert_Len, void* Out);
+	int Close_Partition();
+	int Stop_Motor();
+
+	int Queue_Read(void* Buffer, unsigned int size, unsigned int offset);
+	int Wait_Read();
+	bool Read_Pending();
+
+	bool Load_Plan(const char* Path, const dvddiskid* Disc_ID);
+	bool Save_Plan(const char* Path);
+
+	void Log_Statistics();
+
+	// -- Counters of the boot
+	const char*		Status;
+	unsigned int	Served;				// Reads served from the bundle
+	dword			Served_Bytes;
+	unsigned int	Missed;				// Reads the bundle didn't have or failed the checksum
+	dword			Recorded_Bytes;
+
+private:
+	enum
+	{
+		Max_Data		= 0x00c00000,	// Reads recorded per boot, in MEM2
+		Max_TMD_Size	= 0x49e4,		// Size of Open_Partition's TMD buffer
+		TMD_Contents	= 0x1de,		// Content count in a signed TMD
+		TMD_Header		= 0x1e4,		// Signed TMD up to the contents
+		TMD_Content		= 0x24
+	};
+
+	Disc_Source*	Disc;
+	char			Folder[64];
+	char			Path[96];			// This disc's bundle
+	unsigned int	Offset_Base;
+
+	// -- Bundle of the disc, served once Matched
+	Bundle_File::Header	Loaded;
+	Bundle_File::Entry	Entries[Bundle_File::Max_Entries];
+	dword				Entry_Count;
+	bool				Found;			// Disc ID matches, TMD not checked yet
+	bool				Matched;
+	FILE*				File;			// Reopened after Close
+
+	// -- This boot's reads, written by Commit
+	bool				Recording;
+	byte				Disc_ID[8];
+	dword				TMD_Hash;
+	Bundle_File::Entry	Records[Bundle_File::Max_Entries];
+	dword				Record_Count;
+	byte*				Data;
+	dword				Data_Size;
+	bool				Overflow;
+
+	// -- Read queued on the disc, recorded once it arrives
+	void*				Pending_Buffer;
+	unsigned int		Pending_Size;
+	unsigned int		Pending_Offset;
+
+	bool Load(const dvddiskid* ID);
+	bool Serve(int Type, void* Buffer, unsigned int size, unsigned int offset);
+	void Record(int Type, const void* Buffer, unsigned int size, unsigned int offset);
+
+protected:
+	Boot_Bundle();
+	Boot_Bundle(const Boot_Bundle&);
+	Boot_Bundle& operator= (const Boot_Bundle&);
+
+	virtual ~Boot_Bundle();
+
+public:
+	inline static Boot_Bundle* Instance()
+	{
+		static Boot_Bundle instance;
+		return &instance;
+	}
+};
@@ -0,0 +1,104 @@
+/*******************************************************************************
+ * Buffer_Pool.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of the pool the loader's I/O buffers come from.  It
+ *	is carved once out of MEM2, so MEM1 stays free for the game, and every
+ *	buffer is aligned for DMA.  Freed buffers are kept on a list per size
+ *	class and handed out again, and a Buffer_Scope gives back whatever a
+ *	boot phase left allocated.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Buffer_Pool Class
+
+class Buffer_Pool
+{
+public:
+	enum
+	{
+		Arena_Size	= 0x20000,			// Reserved in MEM2 on first use
+		Alignment	= 0x20,				// DMA and cache line alignment
+		Min_Class	= 6,				// 64 bytes
+		Classes		= 10				// Up to 32 KiB
+	};
+
+	void*	Alloc(unsigned int Length);	// 0 when too big or the arena is used up
+	void	Free(void* Buffer);			// Ignores 0 and anything not from the pool
+	void	Log_Statistics() const;
+
+	dword			In_Use;				// Bytes of the size classes handed out
+	dword			Peak;
+	dword			Carved;				// Bytes of the arena used, headers included
+	unsigned int	Allocations;
+	unsigned int	Reused;				// Served from a free list
+
+protected:
+	friend class Buffer_Scope;
+
+	// Precedes every buffer, one alignment unit so the buffer stays aligned
+	struct Block
+	{
+		Block*			Next;			// Free list
+		unsigned int	Class;
+		unsigned int	Scope;			// Depth of the scope it was allocated in
+		bool			Used;
+		byte			Padding[Alignment - 2 * sizeof(unsigned int) - sizeof(Block*) - sizeof(bool)];
+	};
+
+	byte*			Arena;
+	Block*			Free_List[Classes];
+	unsigned int	Depth;				// Of the innermost Buffer_Scope
+
+	void	Release(Block* Entry);
+	void	Release_Scope(unsigned int Scope);
+
+	Buffer_Pool();
+	Buffer_Pool(const Buffer_Pool&);
+	Buffer_Pool& operator= (const Buffer_Pool&);
+
+	virtual ~Buffer_Pool();
+
+public:
+	inline static Buffer_Pool* Instance()
+	{
+		static Buffer_Pool instance;
+		return &instance;
+	}
+};
+
+//--------------------------------------
+// Buffer_Scope Class
+
+// Frees the buffers allocated between construction and destruction (nested scopes included)
+class Buffer_Scope
+{
+public:
+	Buffer_Scope() : Scope(++Buffer_Pool::Instance()->Depth) {}
+
+	~Buffer_Scope()
+	{
+		Buffer_Pool::Instance()->Release_Scope(Scope);
+		Buffer_Pool::Instance()->Depth = Scope - 1;
+	}
+
+private:
+	unsigned int Scope;
+
+	Buffer_Scope(const Buffer_Scope&);
+	Buffer_Scope& operator= (const Buffer_Scope&);
+};
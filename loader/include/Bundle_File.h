@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * Bundle_File.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the format of a boot bundle kept on the SD card: every read a
+ *	boot of the disc made (headers, ticket, apploader, FST and main.dol), in
+ *	one file, behind a manifest of where each came from.  All words are
+ *	big-endian.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Bundle_File Namespace
+
+namespace Bundle_File
+{
+	const byte Version = 1;
+	const char Signature[] = "SoftChipBundle_";		// 15 characters, followed by the version
+
+	enum
+	{
+		Max_Entries			= 64,		// Reads of one boot
+		Type_Encrypted		= 0,		// Read from the open partition
+		Type_Unencrypted	= 1
+	};
+
+	struct Header
+	{
+		char	Signature[15];
+		byte	Version;
+		byte	Disc_ID[8];				// Game, maker, disc number and version
+		dword	TMD_Hash;				// Of the boot partition's TMD
+		dword	Count;					// Entries following the header
+	} __attribute__((packed));
+
+	struct Entry
+	{
+		dword	Type;
+		dword	Base;					// Offset base the read was made with
+		dword	Offset;					// As given to the read
+		dword	Length;
+		dword	Checksum;				// FNV-1a of the data, see FNV::Hash
+		dword	Position;				// Of the data in the file
+	} __attribute__((packed));
+}
@@ -0,0 +1,81 @@
+/*******************************************************************************
+ * Cluster_Cache.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a LRU cache of disc clusters kept in MEM2
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Cluster_Cache Class
+
+class Cluster_Cache
+{
+public:
+	enum
+	{
+		Encrypted			= 0,		// DI_Read (partition data, hashes stripped)
+		Unencrypted			= 1			// DI_ReadUnencrypted (raw disc)
+	};
+
+	enum
+	{
+		Raw_Cluster_Size	= 0x8000,	// Cluster size on disc
+		Data_Cluster_Size	= 0x7c00,	// User data in an encrypted cluster
+		Max_Clusters		= 64,		// Upper bound for the cache size
+		Default_Clusters	= 16,		// 512 KiB
+		Max_Read_Clusters	= 4			// Larger reads bypass the cache
+	};
+
+	unsigned int	Size;				// Clusters to use from the next Initialize, 0: no cache
+	unsigned int	Hits;				// Clusters served from memory
+	unsigned int	Misses;				// Clusters read from the drive
+
+	bool Initialize();
+	void Flush();
+	void Validate_Disc(const void* Disc_ID);
+
+	unsigned int Cluster_Size(int Type) const;
+	bool Caches(int Type, unsigned int size) const;
+
+	byte* Find(int Type, dword Partition, dword Base, dword Offset);
+	byte* Insert(int Type, dword Partition, dword Base, dword Offset);
+	void Commit(byte* Data);
+
+	Cluster_Cache();
+	virtual ~Cluster_Cache();
+
+private:
+	struct Entry
+	{
+		bool	Valid;
+		int		Type;
+		dword	Partition;
+		dword	Base;
+		dword	Offset;
+		dword	Stamp;			// Last use, for LRU replacement
+		byte*	Data;
+	};
+
+	Entry			Entries[Max_Clusters];
+	unsigned int	Count;
+	unsigned int	Reserved;		// Slots with a buffer
+	dword			Clock;
+	byte			Disc[0x20];
+
+	Cluster_Cache(const Cluster_Cache&);
+	Cluster_Cache& operator= (const Cluster_Cache&);
+};
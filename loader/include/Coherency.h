@@ -0,0 +1,70 @@
+/*******************************************************************************
+ * Coherency.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class keeping the ranges of game memory the
+ *	loader wrote or had loaded, so only those are flushed from the data
+ *	cache and invalidated in the instruction cache before the jump.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Coherency Class
+
+class Coherency
+{
+public:
+	enum
+	{
+		Max_Ranges	= 64,				// Past that, the closest ranges are merged
+		Line_Size	= 32,				// Cache line of Broadway
+		MEM1_Size	= 0x01800000		// What the blanket flush covered
+	};
+
+	struct Range
+	{
+		unsigned long	Start;			// Line aligned, unsigned long so the host build can use it
+		unsigned long	End;
+	};
+
+	void	Touch(const void* Address, unsigned int Length);	// Record a range written by the CPU or by DMA
+	void	Flush();											// Flush and invalidate the recorded ranges, once
+	void	Clear();
+	void	Log_Statistics() const;
+
+	unsigned int	Flushed_Ranges;		// Of the last Flush
+	dword			Flushed_Bytes;
+
+protected:
+	Range			Ranges[Max_Ranges];
+	unsigned int	Range_Count;
+
+	void	Merge();
+	void	Merge_Closest();
+
+	Coherency();
+	Coherency(const Coherency&);
+	Coherency& operator= (const Coherency&);
+
+	virtual ~Coherency();
+
+public:
+	inline static Coherency* Instance()
+	{
+		static Coherency instance;
+		return &instance;
+	}
+};
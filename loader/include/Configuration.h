@@ -29,12 +29,72 @@
 
 namespace ConfigData
 {
-	const byte LastVersion = 6;
+	const byte LastVersion = 9;
 	const char Signature[] = "B5662343D78AD6D";
 	const char SoftChip_Folder[] = "sd:/SoftChip";
 	const char Default_ConfigFile[] = "sd:/SoftChip/Default.cfg";
 	const char Default_LogFile[] = "sd:/SoftChip/Default.log";
+	const char Default_TraceFile[] = "sd:/SoftChip/Boot_Trace.json";
+	const char Default_PatchFile[] = "sd:/SoftChip/Patches.bin";
+	const char Default_MemoFile[] = "sd:/SoftChip/Patch_Memo.bin";
+	const char Default_PlanFile[] = "sd:/SoftChip/Prefetch_Plan.bin";
+	const char Default_InventoryFile[] = "sd:/SoftChip/IOS_Inventory.bin";
+	const char Default_CertFile[] = "sd:/SoftChip/cert.sys";
+	const char Bundle_Folder[] = "sd:/SoftChip/Bundles";
+	const char Default_ImageFile[] = "sd:/SoftChip/Game.iso";
+	const char Common_KeyFile[] = "sd:/SoftChip/common.key";
 	
+	struct Ver9
+	{
+		char		IOS;
+		signed char	Language;
+		bool		SysVMode;
+		bool		AutoBoot;
+		bool		Silent;
+		bool		Logging;
+		bool		Remove_002;
+		bool		Fake_IOS_Version;
+		bool		Load_requested_IOS;
+		bool		Country_String_Patching;
+		bool		SamNMaxFix;
+		byte		Spin_Down;			// Minutes the drive spins idle before it's stopped, 0: at once
+		bool		Use_Image;			// Load from Default_ImageFile, if it matches the disc in the drive
+		byte		Cache_Clusters;		// Disc clusters kept in MEM2, 0: no cluster cache
+	} __attribute__((packed));
+
+	struct Ver8
+	{
+		char		IOS;
+		signed char	Language;
+		bool		SysVMode;
+		bool		AutoBoot;
+		bool		Silent;
+		bool		Logging;
+		bool		Remove_002;
+		bool		Fake_IOS_Version;
+		bool		Load_requested_IOS;
+		bool		Country_String_Patching;
+		bool		SamNMaxFix;
+		byte		Spin_Down;			// Minutes the drive spins idle before it's stopped, 0: at once
+		bool		Use_Image;			// Load from Default_ImageFile, if it matches the disc in the drive
+	} __attribute__((packed));
+
+	struct Ver7
+	{
+		char		IOS;
+		signed char	Language;
+		bool		SysVMode;
+		bool		AutoBoot;
+		bool		Silent;
+		bool		Logging;
+		bool		Remove_002;
+		bool		Fake_IOS_Version;
+		bool		Load_requested_IOS;
+		bool		Country_String_Patching;
+		bool		SamNMaxFix;
+		byte		Spin_Down;			// Minutes the drive spins idle before it's stopped, 0: at once
+	} __attribute__((packed));
+
 	struct Ver6
 	{
 		char		IOS;
@@ -115,7 +175,7 @@ public:
 	bool Read(const char* Path);
 	bool Save(const char* Path);
 
-	ConfigData::Ver6 Data;
+	ConfigData::Ver9 Data;
 
 protected:
 	virtual bool Parse(FILE *fp);
@@ -137,6 +197,24 @@ public:
 //--------------------------------------
 // Derived Configurations
 
+class ConfigVer9 : public Configuration
+{
+protected:
+	bool Parse(FILE *fp);
+};
+
+class ConfigVer8 : public Configuration
+{
+protected:
+	bool Parse(FILE *fp);
+};
+
+class ConfigVer7 : public Configuration
+{
+protected:
+	bool Parse(FILE *fp);
+};
+
 class ConfigVer6 : public Configuration
 {
 protected:
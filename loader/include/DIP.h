@@ -17,12 +17,21 @@
 //--------------------------------------
 // Includes
 
+#include <ogc/ipc.h>
 #include <ogc/mutex.h>
+#include <ogc/semaphore.h>
+
+#include "Disc_Source.h"
+#include "Cluster_Cache.h"
+#include "Read_Planner.h"
+#include "Prefetch_Plan.h"
+#include "Ioctl_Stats.h"
+#include "Spin_State.h"
 
 //--------------------------------------
 // DIP Class
 
-class DIP
+class DIP : public Disc_Source
 {
 public:
 
@@ -44,13 +53,113 @@ public:
 	int	Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, unsigned int Cert_Len, void* Out);
 	int Close_Partition();
 	int Stop_Motor();
+	bool Idle();
+	int Flush_Stop();
 	void Close();
 
+	//----------------------------------
+	// Asynchronous Commands
+
+	int Read_Async(void* Buffer, unsigned int size, unsigned int offset);
+	int Queue_Read(void* Buffer, unsigned int size, unsigned int offset);
+	int Wait_Read();
+	bool Read_Pending();
+
+	bool Load_Plan(const char* Path, const dvddiskid* Disc_ID);
+	bool Save_Plan(const char* Path);
+
+	void Log_Statistics();
+
+	//----------------------------------
+	// Cluster Cache
+
+	Cluster_Cache Cache;
+
+	//----------------------------------
+	// Read Coalescing
+
+	Read_Planner Planner;
+
+	//----------------------------------
+	// Learned Prefetching
+
+	Prefetch_Plan Prefetch;
+
+	//----------------------------------
+	// Per-command counters
+
+	Ioctl_Stats Stats;
+
+	//----------------------------------
+	// Motor
+
+	Spin_State Spin;
+
 private:
 
-	static unsigned int Mutex;
-	static unsigned int Command[8];
-	static unsigned int Output[8];
+	//----------------------------------
+	// Command Blocks
+
+	enum { Block_Count = 4 };
+
+	struct Request
+	{
+		unsigned int	Command[8];		// Ioctl input, handed to IOS
+		unsigned int	Output[8];		// Ioctl output, handed to IOS
+		ioctlv			Vectors[5];		// Used by Ioctlv commands
+		sem_t			Done;			// Posted on asynchronous completion
+		volatile s32	Result;			// Asynchronous result
+		u64				Issued;			// Time the command was handed to IOS
+		volatile u64	Completed;		// Time of the asynchronous completion
+		bool			Busy;			// Owned by a request in flight
+	} __attribute__((aligned(0x20)));
+
+	static mutex_t		Mutex;			// Guards the pool
+	static sem_t		Free_Blocks;	// Counts blocks that aren't busy
+	static Request		Blocks[Block_Count];
+
+	Request*			Pending_Read;	// Block of the read queued by Read_Async
+
+	//----------------------------------
+	// Prefetched Extents
+
+	enum { Max_Prefetch = 2 };			// Leaves a block for Pending_Read and one for commands
+
+	Request*			Prefetching[Max_Prefetch];	// Extents being read, oldest first
+	Prefetch_Plan::Extent* Prefetched[Max_Prefetch];
+	unsigned int		Prefetch_Count;
+
+	// -- Queued read waiting for its extents, served by Wait_Read
+	void*				Deferred_Buffer;
+	unsigned int		Deferred_Size;
+	unsigned int		Deferred_Offset;
+
+	//----------------------------------
+	// Unaligned Reads
+
+	enum { Bounce_Size = 0x2000 };
+
+	byte*				Bounce;			// Stages the parts of a read that can't be DMAed in place, in MEM2
+	unsigned int		Bounced;		// Bytes copied out of it
+
+	Request* Acquire();
+	void Release(Request* Block);
+
+	static s32 Async_Callback(s32 Result, void* Userdata);
+
+	int Send(int Command_ID, Request* Block, void* Output = 0, unsigned int Length = 0);
+	int Send_Reset();
+	int Send_Stop();
+
+	int Cached_Read(int Type, void* Buffer, unsigned int size, unsigned int offset);
+	int Split_Read(int Type, void* Buffer, unsigned int size, unsigned int offset);
+	int Bounce_Read(int Type, void* Buffer, unsigned int size, unsigned int offset);
+	int Raw_Read(int Type, void* Buffer, unsigned int size, unsigned int offset);
+
+	void Prefetch_Issue();
+	void Prefetch_Wait();
+	void Prefetch_Stop();
+	int Prefetch_Serve();
 
 	void Lock();
 	void Unlock();
@@ -62,7 +171,9 @@ protected:
 
 	virtual ~DIP();
 
-	int	Device_Handle;
+	int				Device_Handle;
+	unsigned int	Offset_Base;		// Last value given to Set_OffsetBase
+	unsigned int	Partition;			// Opened partition, 0 if none
 
 public:
 	inline static DIP* Instance()
@@ -0,0 +1,95 @@
+/*******************************************************************************
+ * Disc_Image.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a disc source reading a raw (1:1) Wii disc image
+ *	from a file
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+
+#include "Disc_Source.h"
+#include "Memory_Map.h"
+#include "AES.h"
+
+//--------------------------------------
+// Disc_Image Class
+
+class Disc_Image : public Disc_Source
+{
+public:
+	bool Open(const char* Path);
+
+	bool Initialize();
+	void Close();
+
+	//----------------------------------
+	// Commands
+
+	int	Read_DiscID(dvddiskid* Disc_ID);
+	int Read(void* Buffer, unsigned int size, unsigned int offset);
+	int Read_Unencrypted(void* Buffer, unsigned int size, unsigned int offset);
+	int	Wait_CoverClose();
+	int Verify_Cover(bool *Inserted);
+	int Reset();
+	int Set_OffsetBase(unsigned int Base);
+	int Get_OffsetBase(unsigned int* Base);
+	int	Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, unsigned int Cert_Len, void* Out);
+	int Close_Partition();
+	int Stop_Motor();
+
+	qword Disc_Offset(unsigned int offset) const;	// Image position of the cluster holding a partition offset
+
+private:
+	enum
+	{
+		Cluster_Size		= 0x8000,	// Raw cluster
+		Cluster_Header		= 0x400,	// Hashes, followed by the user data
+		Cluster_Data		= 0x7c00,	// User data per cluster
+		Max_TMD_Size		= 0x49e4	// Size of Open_Partition's TMD buffer
+	};
+
+	char		Path[256];				// Image file, reopened by Initialize
+	FILE*		File;
+	unsigned int Offset_Base;
+
+	// -- Opened partition
+	bool		Partition_Open;
+	qword		Data_Offset;			// Start of the partition's clusters in the image
+	qword		Data_Size;
+	AES			Title_Key;
+
+	// -- Last decrypted cluster
+	byte		Cluster[Cluster_Size];
+	qword		Cluster_Index;			// ~0 if Cluster holds nothing
+
+	int Read_Raw(void* Buffer, unsigned int size, qword offset);
+	bool Load_Cluster(qword Index);
+	bool Load_CommonKey(byte* Key);
+
+protected:
+	Disc_Image();
+	Disc_Image(const Disc_Image&);
+	Disc_Image& operator= (const Disc_Image&);
+
+	virtual ~Disc_Image();
+
+public:
+	inline static Disc_Image* Instance()
+	{
+		static Disc_Image instance;
+		return &instance;
+	}
+};
@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Disc_Probe.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class that opens the disc on a background
+ *	thread while the main menu or the autoboot countdown is shown: spin-up,
+ *	disc ID, header, partition table, ticket and Open_Partition.  Pressing A
+ *	then starts the load at the apploader.
+ *
+ *	Nothing else may use the disc, the buffer pool or the SD card while the
+ *	thread runs; the menu waits for it or cancels it first.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <ogc/dvd.h>
+#include <ogc/lwp.h>
+
+#include "Disc_Source.h"
+#include "WiiDisc.h"
+
+//--------------------------------------
+// Disc_Probe Class
+
+class Disc_Probe
+{
+public:
+	enum Stage
+	{
+		Stage_Idle,						// Not started, cancelled or claimed
+		Stage_Running,
+		Stage_No_Disc,					// The load asks for a disc
+		Stage_Failed,					// See Error, the load starts over
+		Stage_Opened					// Partition opened, the load starts at the apploader
+	};
+
+	enum
+	{
+		Stack_Size		= 0x8000,
+		Priority		= 48,			// Below the menu, which only waits for the next frame
+		Ticket_Size		= 0x800,
+		TMD_Size		= 0x49e4,		// Size of Open_Partition's TMD buffer
+		Steps_Total		= 6
+	};
+
+	bool Initialize();					// Takes the buffers from the pool, outside any Buffer_Scope
+	bool Start(Disc_Source* Source);	// false if already started, or no thread
+	bool Started();
+	Stage Poll();						// Doesn't wait, Stage_Running until the thread is done
+	void Stop();						// Asks the thread to stop after its current command
+	Stage Wait();						// Waits for the thread, keeps the result
+	Stage Claim();						// Waits, then hands the opened partition over
+	bool Cancel();						// Closes what the thread opened, false if it's still running
+	void Open(Disc_Source* Source);		// The same steps on the caller's thread, throws on error
+
+	// -- What was read, valid once opened (in MEM2)
+	dvddiskid					Disc_ID;
+	Wii_Disc::Header*			Header;
+	Wii_Disc::Partition_Info	Partition;
+	byte*						Ticket;
+	byte*						TMD;
+
+	const char*					Error;		// Why the thread stopped
+	const char* volatile		Activity;	// Command being sent, for the progress report
+	volatile unsigned int		Steps_Done;
+	u64							Started_At;	// Profiler time
+	u64							Finished_At;
+
+private:
+	Disc_Source*	Disc;
+	lwp_t			Thread;
+	volatile Stage	Status;
+	volatile bool	Cancelled;
+
+	// -- Timeline of the thread, recorded by the main thread once it's joined
+	const char*		Mark_Names[Steps_Total + 2];	// 0 ends the last step
+	u64				Mark_Times[Steps_Total + 2];
+	unsigned int	Marks;
+
+	void Steps();
+	void Check();
+	void Report(const char* Name);
+	void Mark(const char* Name);
+	void Record_Steps(u64 End);
+
+	static void* Entry(void* Argument);
+
+protected:
+	Disc_Probe();
+	Disc_Probe(const Disc_Probe&);
+	Disc_Probe& operator= (const Disc_Probe&);
+
+	virtual ~Disc_Probe();
+
+public:
+	inline static Disc_Probe* Instance()
+	{
+		static Disc_Probe instance;
+		return &instance;
+	}
+};
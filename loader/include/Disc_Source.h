@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Disc_Source.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the interface shared by everything the loader can read a Wii disc
+ *	from (the drive through /dev/di, or a disc image)
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <ogc/dvd.h>
+
+//--------------------------------------
+// Disc_Source Class
+
+class Disc_Source
+{
+public:
+	virtual bool Initialize() = 0;
+	virtual void Close() = 0;
+
+	//----------------------------------
+	// Commands
+
+	virtual int	Read_DiscID(dvddiskid* Disc_ID) = 0;
+	virtual int Read(void* Buffer, unsigned int size, unsigned int offset) = 0;
+	virtual int Read_Unencrypted(void* Buffer, unsigned int size, unsigned int offset) = 0;
+	virtual int	Wait_CoverClose() = 0;
+	virtual int Verify_Cover(bool *Inserted) = 0;
+	virtual int Reset() = 0;
+	virtual int Set_OffsetBase(unsigned int Base) = 0;
+	virtual int Get_OffsetBase(unsigned int* Base) = 0;
+	virtual int	Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, unsigned int Cert_Len, void* Out) = 0;
+	virtual int Close_Partition() = 0;
+	virtual int Stop_Motor() = 0;
+
+	//----------------------------------
+	// Section Loading (synchronous unless overridden)
+
+	virtual int Queue_Read(void* Buffer, unsigned int size, unsigned int offset) { return Read(Buffer, size, offset); }
+	virtual int Wait_Read() { return 0; }
+	virtual bool Read_Pending() { return false; }
+
+	//----------------------------------
+	// Prefetching (none unless overridden)
+
+	virtual bool Load_Plan(const char* Path, const dvddiskid* Disc_ID) { return false; }
+	virtual bool Save_Plan(const char* Path) { return true; }
+
+	//----------------------------------
+	// Diagnostics
+
+	virtual void Log_Statistics() {}
+
+	virtual ~Disc_Source() {}
+};
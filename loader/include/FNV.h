@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * FNV.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the FNV-1a hash used to tell whether what's kept on the SD card
+ *	or in memory still matches: bundle reads, patch memos, the IOS inventory
+ *	and the certificate chain.  Hashes are written to files, so the results
+ *	must never change.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// FNV Namespace
+
+namespace FNV
+{
+	const dword Offset_Basis	= 2166136261u;
+	const dword Prime			= 16777619u;
+
+	// Folds one value into the hash
+	inline dword Mix(dword Hash, dword Value)
+	{
+		return (Hash ^ Value) * Prime;
+	}
+
+	// Hash of a buffer, a word at a time, the tail a byte at a time
+	inline dword Hash(const void* Data, unsigned int Length)
+	{
+		const byte*	Bytes	= (const byte*)Data;
+		dword		Result	= Offset_Basis;
+		unsigned int i		= 0;
+
+		for (; i + 4 <= Length; i += 4)
+		{
+			dword Word;
+			memcpy(&Word, Bytes + i, 4);
+
+			Result = Mix(Result, Word);
+		}
+
+		for (; i < Length; i++) Result = Mix(Result, Bytes[i]);
+
+		return Result;
+	}
+}
@@ -0,0 +1,78 @@
+/*******************************************************************************
+ * IOS_Inventory.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class that keeps the revision of each installed
+ *	IOS for the IOS menu.  The inventory on the SD card is trusted as long as
+ *	the list of titles is the one it was written for; otherwise its entries
+ *	are stale, and their TMDs are read one per frame while the menu is shown,
+ *	the selected IOS first.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <vector>
+#include <gctypes.h>
+
+#include "Inventory_File.h"
+
+using namespace std;
+
+//--------------------------------------
+// IOS_Inventory Class
+
+class IOS_Inventory
+{
+public:
+	struct Entry
+	{
+		u32				Title;			// IOS number
+		dword			Revision;
+		dword			TMD_Hash;
+		bool			Known;			// Revision read from a TMD, now or on an earlier boot
+		bool			Stale;			// Not read since the title list changed
+		bool			Seen;			// TMD read this session
+	};
+
+	unsigned int		TMD_Reads;		// TMDs read this session
+
+	void Update(const char* Path, const vector<u32>& Titles);
+	bool Refresh(unsigned int Index);
+	int Next_Stale();
+	bool Save(const char* Path);
+
+	unsigned int Count() const;
+	const Entry& Get(unsigned int Index) const;
+
+private:
+	vector<Entry>		Entries;		// In the order of the titles given to Update
+	dword				List_Hash;
+	bool				Loaded;			// The file was read
+	bool				Changed;		// Differs from the file
+
+	void Read(const char* Path);
+
+protected:
+	IOS_Inventory();
+	IOS_Inventory(const IOS_Inventory&);
+	IOS_Inventory& operator= (const IOS_Inventory&);
+
+	virtual ~IOS_Inventory();
+
+public:
+	inline static IOS_Inventory* Instance()
+	{
+		static IOS_Inventory instance;
+		return &instance;
+	}
+};
@@ -0,0 +1,55 @@
+/*******************************************************************************
+ * Inventory_File.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the format of the IOS inventory kept on the SD card: for each IOS
+ *	installed, the revision and a hash of its TMD, so the IOS menu doesn't
+ *	read every TMD each time it's shown.  All words are big-endian.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Inventory_File Namespace
+
+namespace Inventory_File
+{
+	const byte Version = 1;
+	const char Signature[] = "SoftChipIOSInv_";		// 15 characters, followed by the version
+
+	enum
+	{
+		Max_Entries		= 256,			// As many as cIOS lists
+		Flag_Verified	= 0x01			// Read from the TMD since the title list last changed
+	};
+
+	struct Header
+	{
+		char	Signature[15];
+		byte	Version;
+		dword	Count;					// Entries following the header, in the menu's order
+		dword	List_Hash;				// Of the IOS titles listed when it was written
+		byte	Padding[8];
+	} __attribute__((packed));
+
+	struct Entry
+	{
+		dword	Title;					// Low word of the title ID, the IOS number
+		dword	Revision;				// Title version in the TMD
+		dword	TMD_Hash;
+		byte	Flags;
+		byte	Padding[3];
+	} __attribute__((packed));
+}
@@ -0,0 +1,67 @@
+/*******************************************************************************
+ * Ioctl_Stats.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class that keeps per-command counters and
+ *	latency histograms for the /dev/di ioctls
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Ioctl_Stats Class
+
+class Ioctl_Stats
+{
+public:
+	enum
+	{
+		Commands	= 13,				// Ioctls issued by the DIP class
+		Buckets		= 20				// Bucket 0: < 16 us, bucket n: < 16 us << n, last: the rest
+	};
+
+	struct Counters
+	{
+		const char*		Name;
+		int				Command;		// Ioctl number
+		unsigned int	Calls;
+		unsigned int	Errors;			// Drive errors and IPC failures
+		qword			Bytes;			// Data transferred by reads
+		qword			Total_Time;		// us
+		unsigned int	Max_Time;		// us
+		unsigned int	Histogram[Buckets];
+	};
+
+	void Record(int Command, int Result, unsigned int Bytes, u64 Start, u64 End);
+	void Reset();
+	void Log() const;
+
+	const Counters* Find(int Command) const;
+	const Counters* Get(unsigned int Index) const;
+	static unsigned int Bucket_Limit(unsigned int Bucket);
+
+	Ioctl_Stats();
+	virtual ~Ioctl_Stats();
+
+private:
+	Counters Table[Commands];
+
+	Counters* Lookup(int Command);
+
+	Ioctl_Stats(const Ioctl_Stats&);
+	Ioctl_Stats& operator= (const Ioctl_Stats&);
+};
@@ -29,10 +29,15 @@ public:
 	void CloseLog();
 	void Write(const char* Message, ...);
 
+	bool OpenTrace(const char* Filename);
+	void CloseTrace();
+	void Trace(const char* Message, ...);
+
 	bool ShowTime;
 
 protected:
 	FILE *LogFile;
+	FILE *TraceFile;
 
 	Logger();
 	Logger(const Logger&);
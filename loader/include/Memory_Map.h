@@ -25,6 +25,19 @@ typedef unsigned short		word;
 typedef unsigned int		dword;
 typedef unsigned long long	qword;
 
+//--------------------------------------
+// Byte order
+
+// Disc structures and game code are big-endian; this is a no-op on the console
+inline dword BE32(dword Value)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	return __builtin_bswap32(Value);
+#else
+	return Value;
+#endif
+}
+
 namespace Memory
 {
 	// TODO: Replace these with pointers to help type-safety
@@ -55,7 +68,8 @@ namespace Memory
 		Requested_IOS_Version		= 0x80003188,
 		Requested_IOS_Revision		= 0x8000318A,
 		Apploader					= 0x81200000,
-		Exit_Stub					= 0x80001800
+		Exit_Stub					= 0x80001800,
+		Globals_End					= 0x80003400	// End of the OS globals the loader and apploader write
 	};
 }
 
@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Patch_Database.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the format of the patch database read from the SD card.  It is
+ *	compiled from a text file by the host build (softchip-host -p), which
+ *	also validates it.  All words are big-endian.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Patch_Database Namespace
+
+namespace Patch_Database
+{
+	const byte Version = 1;
+	const char Signature[] = "SoftChipPatches";		// 15 characters, followed by the version
+
+	enum
+	{
+		Max_Entries		= 24,
+		Max_Words		= 4,
+		Name_Length		= 20,
+		ID_Length		= 8,
+		Regions_Length	= 8
+	};
+
+	enum Flags
+	{
+		Flag_Write		= 0x01			// Rewrite the target word, otherwise the entry is only a trigger
+	};
+
+	struct Header
+	{
+		char	Signature[15];
+		byte	Version;
+		dword	Count;					// Entries following the header
+		byte	Padding[12];
+	} __attribute__((packed));
+
+	struct Entry
+	{
+		char		Name[Name_Length];			// NUL terminated
+		char		Game_ID[ID_Length];			// Prefix of the disc ID, empty for every game
+		char		Regions[Regions_Length];	// Disc region letters, empty for every region
+		byte		Segments;					// Patcher::Segment_Type mask
+		byte		Length;						// Words in Pattern
+		signed char	Target;						// Word to rewrite, relative to the start of the match
+		byte		Flags;
+		byte		Limit;						// Writes per boot, 0 for no limit
+		signed char	Requires;					// Earlier entry that must match first, -1 for none
+		byte		Padding[2];
+		dword		Pattern[Max_Words];
+		dword		Pattern_Mask[Max_Words];	// Bits compared; the first word is compared whole
+		dword		Value;
+		dword		Mask;						// Bits of the target replaced by Value
+	} __attribute__((packed));
+}
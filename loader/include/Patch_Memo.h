@@ -0,0 +1,60 @@
+/*******************************************************************************
+ * Patch_Memo.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the format of the patch memo kept on the SD card: for each game
+ *	booted, where in main.dol every patch was found, so the next boot can
+ *	patch without scanning.  All words are big-endian.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Patch_Memo Namespace
+
+namespace Patch_Memo
+{
+	const byte Version = 1;
+	const char Signature[] = "SoftChipPtcMemo";		// 15 characters, followed by the version
+
+	enum
+	{
+		Max_Records		= 64,			// Games remembered, the least recently booted is dropped
+		Max_Sites		= 8,			// Patches remembered per game
+		No_Site			= 0xffffffff	// The pattern isn't in main.dol
+	};
+
+	struct Header
+	{
+		char	Signature[15];
+		byte	Version;
+		dword	Count;					// Records following the header, most recent first
+		byte	Padding[12];
+	} __attribute__((packed));
+
+	struct Site
+	{
+		dword	Key;					// Identifies the rule's pattern, see Patcher::Rule_Key
+		dword	Offset;					// Of the match in the partition, in bytes, or No_Site
+	} __attribute__((packed));
+
+	struct Record
+	{
+		char	Game_ID[8];				// Disc ID and maker code
+		dword	Checksum;				// Of main.dol's header
+		dword	Count;					// Sites used
+		Site	Sites[Max_Sites];
+	} __attribute__((packed));
+}
@@ -0,0 +1,171 @@
+/*******************************************************************************
+ * Patcher.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class patching the game's sections in memory.
+ *	All active patches are compiled into one table of rules keyed by a hash
+ *	of their first word, so each section is scanned once for all of them.
+ *	The search kernel finds the words equal to a first word.  With main.dol's header, sections are only
+ *	scanned where they hold DOL text or data a pending rule applies to.
+ *	Besides the patches built in, rules come from the SD patch database.
+ *	Where each patch was found is remembered per game in the patch memo;
+ *	when main.dol is the same on the next boot, those sites are checked and
+ *	patched directly instead of being searched for.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+#include "Configuration.h"
+#include "WiiDisc.h"
+#include "Patch_Database.h"
+#include "Patch_Memo.h"
+#include "Pattern_Search.h"
+
+//--------------------------------------
+// Patcher Class
+
+class Patcher
+{
+public:
+	enum
+	{
+		Max_Rules	= 32,
+		Max_Words	= Patch_Database::Max_Words,	// Longest pattern, in words
+		Hash_Bits	= 6,
+		Max_Segments	= Wii_Disc::DOL_Header::Sections
+	};
+
+	// How a rule is found
+	enum Memo_State
+	{
+		Memo_None,								// Searched for
+		Memo_Site,								// At Site, checked when its section loads
+		Memo_Absent								// Not in main.dol
+	};
+
+	// Parts of main.dol a rule applies to
+	enum Segment_Type
+	{
+		Segment_Text	= 1,
+		Segment_Data	= 2,
+		Segment_Any		= Segment_Text | Segment_Data
+	};
+
+	enum Patch_ID
+	{
+		Patch_Language,
+		Patch_Country_Strings,
+		Patch_002,
+		Patch_Custom,							// Rules from the patch database
+		Patches
+	};
+
+	// A word aligned pattern.  When it matches, one of its words is rewritten
+	// under a mask, or, for a trigger, later rules requiring it are enabled.
+	struct Rule
+	{
+		const char*		Name;
+		int				Patch;					// Patch_ID it belongs to
+		unsigned int	Segments;				// Segment_Type mask
+		dword			Match[Max_Words];
+		dword			Match_Mask[Max_Words];	// Bits compared, all of them for the first word
+		unsigned int	Length;					// Words in Match
+		bool			Write;					// false: trigger only
+		int				Word;					// Word to rewrite, relative to the start of the match
+		dword			Value;
+		dword			Mask;					// Bits of the word replaced by Value
+		int				Requires;				// Rule that must match first in the same section, -1 for none
+		unsigned int	Limit;					// Writes per boot, 0 for no limit
+		unsigned int	Hits;					// Matches since Prepare
+		int				Next;					// Hash chain
+		int				Memo;					// Memo_State
+		dword			Site;					// Partition offset of the first match, Patch_Memo::No_Site if none
+	};
+
+	// A DOL section, as a range of offsets into the partition
+	struct Segment
+	{
+		dword			Start;
+		dword			End;
+		unsigned int	Type;
+	};
+
+	qword	Loaded;													// Bytes passed to Scan since Prepare
+	qword	Scanned;												// Bytes actually searched
+
+	bool	Load_Database(const char* Path);						// Read the patch database, once at startup
+	bool	Prepare(const char* Disc_ID);							// Compile the patches enabled for a game
+	bool	Set_DOL(const Wii_Disc::DOL_Header* Header, dword Offset);	// Restrict scans to main.dol (after Prepare)
+	bool	Load_Memo(const char* Path);							// Use the sites found by a previous boot (after Set_DOL)
+	bool	Save_Memo(const char* Path);							// Remember the sites found by this boot
+	void	Scan(void* Address, int Size, dword Offset);			// Apply all patches to a section in one pass
+	bool	Pending(unsigned int Type = Segment_Any) const;			// Some patch still has to be applied
+	bool	Searching(unsigned int Type = Segment_Any) const;		// Some pending patch isn't in the memo
+	bool	Enabled(Patch_ID Patch) const;							// Patch has at least one rule
+	unsigned int	Applied(Patch_ID Patch) const;					// Writes done by a patch
+	void	Log_Statistics() const;
+
+	const Rule* Get_Rule(unsigned int Index) const;
+
+	static const char* Check_Entry(const Patch_Database::Entry* Entry, unsigned int Index);
+	static dword Rule_Key(const Rule* Entry);
+
+protected:
+	Configuration*	Cfg;
+
+	Rule			Rules[Max_Rules];
+	unsigned int	Rule_Count;
+	signed char		Heads[1 << Hash_Bits];
+	Pattern_Search	Search;							// Keyed by the first words of the rules
+
+	Patch_Database::Entry	Database[Patch_Database::Max_Entries];
+	unsigned int			Database_Count;
+	const char*				Database_Status;		// Result of Load_Database, for the log
+
+	Segment			Segments[Max_Segments];
+	unsigned int	Segment_Count;					// 0: main.dol unknown, everything is scanned
+	dword			DOL_Checksum;					// Of the header given to Set_DOL, 0 if none
+
+	char			Game_ID[8];						// Given to Prepare
+	unsigned int	Memo_Used;						// Rules Load_Memo found sites for
+	unsigned int	Memo_Missed;					// Sites that didn't match any more
+	const char*		Memo_Status;					// For the log
+
+	int		Add_Rule(const char* Name, int Patch, unsigned int Segments, const dword* Match, const dword* Match_Mask, unsigned int Length, int Requires);
+	void	Set_Write(int Index, int Word, dword Value, dword Mask, unsigned int Limit);
+	void	Add_Database(const char* Disc_ID);
+	void	Scan_Range(dword* Words, unsigned int Count, unsigned int Type, dword Offset);
+	bool	Match(dword* Words, unsigned int i, unsigned int Count, unsigned int Type, dword Offset, bool* Matched);
+	void	Apply_Memo(dword* Words, unsigned int Count, dword Offset);
+	void	Write(Rule* Entry, dword* Target);
+	bool	Open(const Rule* Entry) const;
+
+	static inline unsigned int Hash(dword Value)
+	{
+		return (Value * 0x9e3779b1u) >> (32 - Hash_Bits);
+	}
+
+	Patcher();
+	Patcher(const Patcher&);
+	Patcher& operator= (const Patcher&);
+
+	virtual ~Patcher();
+
+public:
+	inline static Patcher* Instance()
+	{
+		static Patcher instance;
+		return &instance;
+	}
+};
@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Pattern_Search.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of the word pattern search kernel.  It finds the
+ *	words equal to one of a few keys (the first words of the patterns), the
+ *	caller then compares the rest of each pattern under its mask.
+ *
+ *	The scalar path tests each word against a table of the keys' low bits,
+ *	a cache line at a time, prefetching ahead (dcbt on the console).  The
+ *	host build also has SSE2 and AVX2 paths comparing 4 or 8 words against
+ *	every key at once.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Pattern_Search Class
+
+class Pattern_Search
+{
+public:
+	enum
+	{
+		Table_Bits		= 12,			// Low bits of a word (as stored) indexing the table, 4 KiB
+		Max_Keys		= 8,			// More keys are only filtered by the table
+		Line_Words		= 8,			// 32 byte cache lines
+		Prefetch_Lines	= 4				// How far ahead of the scan lines are touched
+	};
+
+	enum Path
+	{
+		Path_Scalar,
+		Path_SSE2,
+		Path_AVX2,
+		Paths
+	};
+
+	void			Clear();
+	void			Add(dword Key);													// In host byte order
+	unsigned int	Next(const dword* Words, unsigned int Start, unsigned int Count) const;
+	unsigned int	Next(Path Kernel, const dword* Words, unsigned int Start, unsigned int Count) const;
+
+	static bool		Compare(const dword* Words, const dword* Pattern, const dword* Mask, unsigned int Length);
+	static bool		Supported(Path Kernel);
+	static Path		Best_Path();
+	static const char* Path_Name(Path Kernel);
+
+	Pattern_Search();
+	virtual ~Pattern_Search();
+
+private:
+	byte			Table[1 << Table_Bits];
+	dword			Keys[Max_Keys];			// As stored in memory
+	unsigned int	Key_Count;				// Above Max_Keys, the table alone decides
+	Path			Default;
+
+	// Nonzero if a key may be the word (as stored in memory)
+	inline byte Candidate(dword Raw) const
+	{
+		return Table[Raw & ((1 << Table_Bits) - 1)];
+	}
+
+	bool			Is_Key(dword Raw) const;
+	unsigned int	Next_Scalar(const dword* Words, unsigned int Start, unsigned int Count) const;
+	unsigned int	Next_SSE2(const dword* Words, unsigned int Start, unsigned int Count) const;
+	unsigned int	Next_AVX2(const dword* Words, unsigned int Start, unsigned int Count) const;
+
+	Pattern_Search(const Pattern_Search&);
+	Pattern_Search& operator= (const Pattern_Search&);
+};
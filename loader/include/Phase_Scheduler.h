@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * Phase_Scheduler.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class that keeps track of the phase SoftChip::Run
+ *	is in.  Run ticks once per frame; each tick of a phase does one step's
+ *	work without waiting, so the menu, the input and the power/reset buttons
+ *	stay alive while the drive works.  A step may have a timeout, and it may
+ *	report its progress.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Phase_Scheduler Class
+
+class Phase_Scheduler
+{
+public:
+	bool Enter(int Phase);							// true on the first tick of a phase
+	void Go(int Step, unsigned int Timeout = 0);	// Next step of the phase, timeout in ms (0: none)
+	int Step();
+	bool Expired();									// The step's timeout has passed
+
+	void Report(const char* Activity, unsigned int Percent);	// Printed when the activity changes
+	void Tick();									// Ends the tick, waits for the next frame
+
+	unsigned int	Ticks;							// Frames since the start
+
+private:
+	int				Current;						// Phase
+	int				Current_Step;
+	u64				Deadline;						// 0 if the step has no timeout
+	const char*		Last_Activity;
+
+protected:
+	Phase_Scheduler();
+	Phase_Scheduler(const Phase_Scheduler&);
+	Phase_Scheduler& operator= (const Phase_Scheduler&);
+
+	virtual ~Phase_Scheduler();
+
+public:
+	inline static Phase_Scheduler* Instance()
+	{
+		static Phase_Scheduler instance;
+		return &instance;
+	}
+};
@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * Prefetch_File.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the format of the prefetch plans kept on the SD card: for each
+ *	disc booted, the reads the apploader asked for, in the order it asked.
+ *	All words are big-endian.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Prefetch_File Namespace
+
+namespace Prefetch_File
+{
+	const byte Version = 1;
+	const char Signature[] = "SoftChipPrefPln";		// 15 characters, followed by the version
+
+	enum
+	{
+		Max_Records		= 32,			// Discs remembered, the least recently booted is dropped
+		Max_Sections	= 64			// Reads remembered per disc
+	};
+
+	struct Header
+	{
+		char	Signature[15];
+		byte	Version;
+		dword	Count;					// Records following the header, most recent first
+		byte	Padding[12];
+	} __attribute__((packed));
+
+	struct Section
+	{
+		dword	Offset;					// In the partition, in bytes
+		dword	Size;
+	} __attribute__((packed));
+
+	struct Record
+	{
+		char	Disc_ID[8];				// Disc ID, maker code, disc number and version
+		dword	Count;					// Sections used
+		Section	Sections[Max_Sections];
+	} __attribute__((packed));
+}
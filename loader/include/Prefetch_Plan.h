@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Prefetch_Plan.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class that learns which sections the apploader
+ *	reads.  The reads of the last boot of a disc are sorted by disc offset,
+ *	merged into extents and staged in MEM2 ahead of the apploader, which then
+ *	gets its sections from the staging area.  The data always comes from the
+ *	disc being booted, so a stale plan costs reads, never a bad section.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+#include "Prefetch_File.h"
+
+//--------------------------------------
+// Prefetch_Plan Class
+
+class Prefetch_Plan
+{
+public:
+	enum
+	{
+		Staging_Size	= 0x00800000,	// Planned data staged per boot, in MEM2
+		Max_Transfer	= 0x00040000,	// Largest read of an extent
+		Max_Gap			= 0x00020000,	// Sections closer than this are read as one
+		Max_Extents		= Staging_Size / Max_Transfer + Prefetch_File::Max_Sections
+	};
+
+	enum State
+	{
+		Extent_Idle,
+		Extent_Reading,
+		Extent_Ready,
+		Extent_Failed
+	};
+
+	struct Extent
+	{
+		dword			Start;			// In the partition, in bytes
+		dword			Length;			// Multiple of 32
+		dword			Staging;		// Offset of its data in the staging area
+		State			Status;
+	};
+
+	// -- Counters of the boot
+	const char*		Status;
+	unsigned int	Planned;			// Sections of the plan that fit the staging area
+	unsigned int	Served;				// Reads copied out of the staging area
+	unsigned int	Reads;				// Extents read
+	dword			Staged_Bytes;
+
+	bool Load(const char* Path, const byte* Disc_ID);
+	bool Save(const char* Path);
+	void Record(unsigned int Offset, unsigned int Size);
+	void Reset();
+
+	Extent* Next_Extent();
+	int Find(unsigned int Offset, unsigned int Size, int* First);
+	bool Ready(int First, int Last);
+	bool Failed(int First, int Last);
+	void Copy(void* Buffer, unsigned int Size, unsigned int Offset, int First);
+	byte* Data(const Extent* Entry);
+
+	Prefetch_Plan();
+	virtual ~Prefetch_Plan();
+
+private:
+	byte*					Staging;		// Allocated with the first plan
+	byte					Disc_ID[8];
+	bool					Known;			// Disc_ID was set by Load
+
+	// -- Extents of the loaded plan, in disc order
+	Extent					Extents[Max_Extents];
+	unsigned int			Extent_Count;
+	unsigned int			Next;			// First extent not read yet
+
+	// -- Plan loaded, and the reads of this boot
+	Prefetch_File::Record	Loaded;
+	Prefetch_File::Record	Current;
+
+	void Build();
+
+	Prefetch_Plan(const Prefetch_Plan&);
+	Prefetch_Plan& operator= (const Prefetch_Plan&);
+};
@@ -0,0 +1,96 @@
+/*******************************************************************************
+ * Profiler.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of the boot timeline profiler.  Scoped timers record
+ *	into a fixed ring, which is written out as a Chrome trace (load it in
+ *	chrome://tracing or Perfetto).  Only used from the main thread; other
+ *	threads may only read the clock (Now).
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Profiler Class
+
+class Profiler
+{
+public:
+	enum
+	{
+		Ring_Size = 256				// Oldest events are dropped once full
+	};
+
+	struct Event
+	{
+		const char*	Name;			// Must be a string literal
+		u64			Start;			// Timebase ticks
+		u64			End;
+	};
+
+	bool Enabled;					// Follows the logging option
+
+	u64 Now();
+	void Set_Time(u64 Ticks);
+	void Record(const char* Name, u64 Start, u64 End);
+	void Clear();
+	bool Dump(const char* Filename);
+
+private:
+	Event			Events[Ring_Size];
+	unsigned int	Next;
+	unsigned int	Count;
+	u64				Offset;			// Keeps times monotonic across Set_Time
+
+protected:
+	Profiler();
+	Profiler(const Profiler&);
+	Profiler& operator= (const Profiler&);
+
+	virtual ~Profiler();
+
+public:
+	inline static Profiler* Instance()
+	{
+		static Profiler instance;
+		return &instance;
+	}
+};
+
+//--------------------------------------
+// Scoped_Timer Class
+
+// Records the time between construction and destruction; a flag test when disabled
+class Scoped_Timer
+{
+public:
+	explicit Scoped_Timer(const char* Event_Name) : Name(Event_Name), Active(Profiler::Instance()->Enabled), Start(0)
+	{
+		if (Active) Start = Profiler::Instance()->Now();
+	}
+
+	~Scoped_Timer()
+	{
+		if (Active) Profiler::Instance()->Record(Name, Start, Profiler::Instance()->Now());
+	}
+
+private:
+	const char*	Name;
+	bool		Active;
+	u64			Start;
+
+	Scoped_Timer(const Scoped_Timer&);
+	Scoped_Timer& operator= (const Scoped_Timer&);
+};
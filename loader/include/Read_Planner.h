@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * Read_Planner.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class that coalesces small sequential partition
+ *	reads into larger transfers
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include "Memory_Map.h"
+
+//--------------------------------------
+// Read_Planner Class
+
+class Read_Planner
+{
+public:
+	enum
+	{
+		Window_Size		= 0x20000,		// One transfer covers this much of the disc
+		Max_Small_Read	= 0x8000		// Larger requests are read directly
+	};
+
+	unsigned int	Requests;			// Requests seen since Reset
+	unsigned int	Saved;				// Requests served without an ioctl
+
+	bool Initialize();
+	void Reset();
+	bool Serve(void* Address, unsigned int Size, unsigned int Offset);
+	bool Staging() const;
+	int Complete(bool Success);			// Called by Wait_Read for a refill
+
+	Read_Planner();
+	virtual ~Read_Planner();
+
+private:
+	byte*			Window;				// Staging buffer in MEM2
+	unsigned int	Window_Start;		// Disc offset of Window[0]
+	unsigned int	Window_Length;		// Valid bytes in Window, 0 if empty
+	unsigned int	Last_End;			// Disc offset right after the last request
+	void*			Staged_Address;		// Request waiting for the refill, 0 if none
+	unsigned int	Staged_Size;
+
+	Read_Planner(const Read_Planner&);
+	Read_Planner& operator= (const Read_Planner&);
+};
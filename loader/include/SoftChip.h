@@ -33,11 +33,19 @@
 #include <ogc/dvd.h>
 
 #include "DIP.h"
+#include "Disc_Image.h"
 #include "Input.h"
 #include "Console.h"
 #include "Storage.h"
 #include "Configuration.h"
 #include "Logger.h"
+#include "Patcher.h"
+#include "Profiler.h"
+#include "Coherency.h"
+#include "Buffer_Pool.h"
+#include "Boot_Bundle.h"
+#include "Disc_Probe.h"
+#include "Phase_Scheduler.h"
 
 #define Phase_IOS				0
 #define Phase_Menu				1
@@ -51,18 +59,44 @@
 class SoftChip
 {
 protected:
-	DIP*			DI;						// DIP interface
+	Disc_Source*	DI;						// Disc being loaded (drive or image)
+	DIP*			Drive;					// DIP interface
 	Input*			Controls;				// Input
 	Console*		Out;					// Console
 	Configuration*	Cfg;					// Configuration
 	Logger*			Log;					// Logger
 	Storage*		SD;						// Storage
+	Patcher*		Patch;					// Patcher
+	Profiler*		Prof;					// Boot timeline
+	Coherency*		Cache;					// Ranges to flush before the jump
+	Buffer_Pool*	Pool;					// DMA buffers in MEM2
+	Boot_Bundle*	Bundle;					// Boot reads kept on SD
+	Disc_Probe*		Probe;					// Opens the disc while the menu is shown
+	Phase_Scheduler* Scheduler;				// Phase, step and timeout of the logic
 
 	// -- Logic
 	int				NextPhase;				// Logic Step
 	bool			Skip_AutoBoot;			// Force Menu
 	dword			Cursor_IOS;				// IOS Position in Console
 	dword			Cursor_Menu;			// Menu Position in Console
+	bool			Image_Selected;			// Cfg->Data.Use_Image when DI was chosen
+	bool			Image_Used;				// DI reads the disc image
+	// -- Menus, kept across the ticks
+	Console::Option* oLang;
+	Console::Option* oPCS;
+	Console::Option* oMode;
+	Console::Option* oIOS;
+	Console::Option* oLRI;
+	Console::Option* oSAM;
+	Console::Option* oBoot;
+	Console::Option* oSlnt;
+	Console::Option* oLogg;
+	Console::Option* oSpin;
+	Console::Option* oImg;
+	Console::Option* oCach;
+	Console::Option* oSelect;				// IOS Menu
+	vector<string>	IOS_Names;				// IOS Menu entries
+	vector<u32>		IOS_Numbers;
 	// -- Flags
 	bool			Standby_Flag;			// Flag is set when power button is pressed
 	bool			Reset_Flag;				// Flag is set when reset button is pressed
@@ -78,20 +112,47 @@ public:
 	void Run();							// Main Function
 
 private:
+	// -- Steps of the phases
+	enum
+	{
+		Step_Enter		= 0,				// Every phase starts here
+		Step_Countdown,						// Menu: autoboot, until (Home) or the timeout
+		Step_Input,							// Menus: input of one frame
+		Step_Help,							// Disclaimer: shown, waiting for a key
+		Step_Return,						// Disclaimer: help shown, waiting for a key
+		Step_Probe,							// Play: waiting for the probe thread
+		Step_No_Disc,						// Play: waiting for a disc, probed again every second
+		Step_Hung,							// Play: the drive stopped answering
+		Step_Failed							// Play: the load failed, waiting for a key
+	};
+
+	enum
+	{
+		Autoboot_Delay	= 2000,				// ms to press (Home) before the autoboot
+		Disc_Retry		= 1000,				// ms between two probes without a disc
+		Probe_Timeout	= 30000				// ms the drive has to open the disc
+	};
+
 	static void Standby();				// Put the console into standby
 	static void Reboot();				// Return to system menu
 	void VerifyFlags();					// Verify if the flags are set
 	void Exit_Loader();					// Return to Loader or System Menu
 
 	void	Load_IOS();												// Load the IOS
+	bool	Preflight_IOS(byte* IOS);								// Read the IOS the game requests
+	void	Select_Source();										// Choose the drive or the disc image
+	void	Verify_Image();											// Check the drive holds the image's game
+	void	Tick_Menu();											// One frame of the Main Menu phase
+	void	Tick_Disclaimer();										// One frame of the Disclaimer phase
+	void	Tick_Play();											// One frame of the Play phase
+	void	Ask_Disc();												// Wait for a disc in the Play phase
 	void	Show_Menu();											// Show the Main Menu
+	void	Update_Menu();											// Handle the input of the Main Menu
 	void	Show_IOSMenu();											// Show the Menu for selecting IOS
+	void	Update_IOSMenu();										// Handle the input of the IOS Menu
 	void 	Load_Disc();											// Loads the disc
 	void 	Determine_VideoMode(char Region);						// Determines which video mode to use based on current system settings
 	void	Set_VideoMode();										// Set Video Mode
-	bool	Set_GameLanguage(void *Address, int Size, char Region);// Patch Game's Language
-	bool	Remove_002_Protection(void *Address, int Size);			// Remove the 002 protection
-	bool	Patch_Country_Strings(void *Address, int Size, char discregion);
 
 protected:
 	SoftChip();
@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * Spin_State.h
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains definition of a class that keeps track of the drive's motor for
+ *	the DIP class.  A stop is only sent once the drive has been idle for the
+ *	configured time, so a command soon after it doesn't pay for a spin-up,
+ *	and a reset is skipped while the same disc spins under the same IOS.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+//--------------------------------------
+// Includes
+
+#include <gctypes.h>
+
+//--------------------------------------
+// Spin_State Class
+
+class Spin_State
+{
+public:
+	unsigned int	Idle_Timeout;		// ms the motor spins after the last command, 0 stops it at once
+
+	// -- Counters
+	unsigned int	Spin_Ups;			// Resets of a drive that wasn't known to spin
+	unsigned int	Spin_Ups_Avoided;	// Deferred stops a command came before, not sent
+	unsigned int	Resets_Skipped;		// The disc was already spinning and identified
+	unsigned int	Stops;				// Stops sent to the drive
+
+	void Access();						// A command is being sent
+	void Reset(int IOS);				// The drive was reset under an IOS
+	void Identified();					// The disc ID was read after the reset
+	void Removed();						// No disc, or the cover was opened
+	void Stopped();
+	void Closed();						// The handle was closed, the next IOS needs a reset
+
+	bool Skip_Reset(int IOS);			// true if the reset isn't needed
+	bool Defer_Stop();					// true if the stop is left to Stop_Due
+	bool Stop_Due();					// true if a deferred stop should be sent now
+	bool Stop_Deferred() const;			// true if a stop is waiting for the idle timeout
+	bool Spinning() const;
+	bool Reset_Skipped() const;			// The last reset was skipped
+
+	Spin_State();
+	virtual ~Spin_State();
+
+private:
+	bool			Motor;				// Known to spin
+	bool			Ready;				// Reset and identified, reads work
+	bool			Stop_Pending;		// Stop deferred until Idle_Timeout
+	bool			Skipped;			// Last reset skipped
+	int				Reset_IOS;			// IOS the drive was reset under
+	u64				Last_Access;
+
+	Spin_State(const Spin_State&);
+	Spin_State& operator= (const Spin_State&);
+};
@@ -19,6 +19,8 @@
 
 #include "Memory_Map.h"
 
+class Disc_Source;
+
 //--------------------------------------
 // WiiDisc Structures
 
@@ -75,10 +77,57 @@ struct Partition_Info
 	dword	Type;
 } __attribute__((__packed__));
 
+struct Partition_Header
+{
+	byte	Ticket[0x2a4];
+	dword	TMD_Size;
+	dword	TMD_Offset;				// From the partition's start (>> 2)
+	dword	Cert_Size;
+	dword	Cert_Offset;			// (>> 2)
+	dword	H3_Offset;				// (>> 2)
+	dword	Data_Offset;			// (>> 2)
+	dword	Data_Size;				// (>> 2)
+} __attribute__((__packed__));
+
+struct DOL_Header
+{
+	enum
+	{
+		Text_Sections	= 7,
+		Data_Sections	= 11,
+		Sections		= Text_Sections + Data_Sections		// Text sections come first in each table
+	};
+
+	dword	Offset[Sections];		// Offset into the DOL
+	dword	Address[Sections];		// Load address
+	dword	Size[Sections];
+	dword	BSS_Address;
+	dword	BSS_Size;
+	dword	Entry_Point;
+	byte	Padding[0x1c];
+} __attribute__((__packed__));
+
 namespace Offsets
 {
 	const dword Descriptor	= 0x00040000;		// Offset into disc to partition descriptor
+	const dword Main_DOL	= 0x00000420;		// Offset into the partition to main.dol's offset (>> 2)
 	const dword Apploader	= 0x00002440;		// Offset into the partition to apploader header
+	const dword TMD_IOS		= 0x0000018b;		// Offset into the TMD to the IOS the game requests (low byte of the system version)
 }
 
+//--------------------------------------
+// Disc parsing
+
+// Reads the primary partition table, converted to host byte order.  The table
+// comes from the Buffer_Pool and must be freed by the caller.
+Partition_Info* Read_Partitions(Disc_Source* DI, dword* Count);
+
+// Reads the IOS the game requests from the boot partition's TMD, unencrypted,
+// so it's known before the partition is opened.  The disc must be reset.
+bool Read_Requested_IOS(Disc_Source* DI, byte* IOS);
+
+// Reads main.dol's header from the open partition, converted to host byte
+// order.  Offset receives the DOL's offset into the partition, in bytes.
+bool Read_DOL_Header(Disc_Source* DI, DOL_Header* Header, dword* Offset);
+
 }
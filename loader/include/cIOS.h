@@ -68,6 +68,8 @@ protected:
 
 public:
 	s32 GetCerts(signed_blob** Certs, u32* Length);
+	s32 RereadCerts(signed_blob** Certs, u32* Length);	// Drops the copy on the SD card
+	bool CertsFromSD();
 	s32 GenerateTicket(signed_blob** Ticket, u32* Length);
 	s32 GetTMD(u64 TicketID, signed_blob** TMD, u32* Length);
 
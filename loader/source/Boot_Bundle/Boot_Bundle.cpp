@@ -0,0 +1,560 @@
+/*******************************************************************************
+ * Boot_Bundle.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of the disc source serving a boot's reads from
+ *	a bundle on the SD card
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+#include <dirent.h>
+#include <ogc/system.h>
+
+#include "Boot_Bundle.h"
+#include "Storage.h"
+#include "FNV.h"
+#include "Logger.h"
+
+//--------------------------------------
+// Byte order
+
+namespace
+{
+	void Swap_Entry(Bundle_File::Entry* Entry)
+	{
+		Entry->Type		= BE32(Entry->Type);
+		Entry->Base		= BE32(Entry->Base);
+		Entry->Offset	= BE32(Entry->Offset);
+		Entry->Length	= BE32(Entry->Length);
+		Entry->Checksum	= BE32(Entry->Checksum);
+		Entry->Position	= BE32(Entry->Position);
+	}
+}
+
+//--------------------------------------
+// Boot_Bundle Class
+
+/*******************************************************************************
+ * Boot_Bundle: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Boot_Bundle::Boot_Bundle()
+{
+	Disc			= 0;
+	Folder[0]		= 0;
+	File			= 0;
+	Data			= 0;
+
+	Begin();
+}
+
+/*******************************************************************************
+ * ~Boot_Bundle: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Boot_Bundle::~Boot_Bundle() {}
+
+/*******************************************************************************
+ * Open: Put the bundles in front of a disc
+ * -----------------------------------------------------------------------------
+ * Bundles are opt-in: they are only used if their folder exists.
+ *
+ * Return Values:
+ *	returns true if the folder exists, the disc is then read through this
+ *
+ ******************************************************************************/
+
+bool Boot_Bundle::Open(const char* Bundle_Folder, Disc_Source* Source)
+{
+	DIR* Dir = opendir(Bundle_Folder);
+	if (!Dir) return false;
+
+	closedir(Dir);
+
+	strncpy(Folder, Bundle_Folder, sizeof(Folder) - 1);
+	Folder[sizeof(Folder) - 1] = 0;
+
+	Disc = Source;
+	return true;
+}
+
+/*******************************************************************************
+ * Begin: Forget the last boot
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Boot_Bundle::Begin()
+{
+	if (File) fclose(File);
+	File			= 0;
+
+	Path[0]			= 0;
+	Offset_Base		= 0;
+	Entry_Count		= 0;
+	Found			= false;
+	Matched			= false;
+
+	Recording		= true;
+	TMD_Hash		= 0;
+	Record_Count	= 0;
+	Data_Size		= 0;
+	Overflow		= false;
+	Pending_Buffer	= 0;
+
+	memset(Disc_ID, 0, sizeof(Disc_ID));
+
+	Status			= "no disc ID";
+	Served			= 0;
+	Served_Bytes	= 0;
+	Missed			= 0;
+	Recorded_Bytes	= 0;
+}
+
+/*******************************************************************************
+ * Load: Read the manifest of the disc's bundle
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if there is a bundle for the disc ID
+ *
+ ******************************************************************************/
+
+bool Boot_Bundle::Load(const dvddiskid* ID)
+{
+	FILE* fp = Storage::Instance()->OpenFile(Path, "rb");
+	if (!fp) return false;
+
+	bool Result = false;
+
+	if (fread(&Loaded, 1, sizeof(Loaded), fp) == sizeof(Loaded)
+		&& memcmp(Loaded.Signature, Bundle_File::Signature, sizeof(Loaded.Signature)) == 0
+		&& Loaded.Version == Bundle_File::Version
+		&& memcmp(Loaded.Disc_ID, ID, sizeof(Loaded.Disc_ID)) == 0
+		&& BE32(Loaded.Count) <= Bundle_File::Max_Entries)
+	{
+		Entry_Count		= BE32(Loaded.Count);
+		Loaded.TMD_Hash	= BE32(Loaded.TMD_Hash);
+
+		Result = (fread(Entries, sizeof(Bundle_File::Entry), Entry_Count, fp) == Entry_Count);
+
+		for (dword i = 0; i < Entry_Count; i++) Swap_Entry(&Entries[i]);
+	}
+
+	fclose(fp);
+
+	if (!Result) Entry_Count = 0;
+	return Result;
+}
+
+/*******************************************************************************
+ * Serve: Read from the bundle
+ * -----------------------------------------------------------------------------
+ * The header, partition table and ticket are served once the disc ID
+ * matched, reads from the partition only once its TMD matched too.  Only
+ * reads made exactly as on the recorded boot are served.
+ *
+ * Return Values:
+ *	returns true if the data was read and passed its checksum
+ *
+ ******************************************************************************/
+
+bool Boot_Bundle::Serve(int Type, void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (Type == Bundle_File::Type_Encrypted ? !Matched : !Found) return false;
+
+	const Bundle_File::Entry* Entry = 0;
+
+	for (dword i = 0; i < Entry_Count && !Entry; i++)
+	{
+		const Bundle_File::Entry* Candidate = &Entries[i];
+
+		if (Candidate->Type == (dword)Type && Candidate->Base == Offset_Base
+			&& Candidate->Offset == offset && Candidate->Length == size) Entry = Candidate;
+	}
+
+	if (!File && Entry) File = Storage::Instance()->OpenFile(Path, "rb");
+
+	if (!Entry || !File || fseek(File, Entry->Position, SEEK_SET) != 0
+		|| fread(Buffer, 1, size, File) != size || FNV::Hash(Buffer, size) != Entry->Checksum)
+	{
+		Missed++;
+		return false;
+	}
+
+	Served++;
+	Served_Bytes += size;
+	return true;
+}
+
+/*******************************************************************************
+ * Record: Keep a read for the bundle
+ * -----------------------------------------------------------------------------
+ * The data is copied to MEM2 before anything patches it.  A boot reading
+ * more than Max_Data isn't recorded.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Boot_Bundle::Record(int Type, const void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (!Recording || Overflow || size == 0) return;
+
+	// Reads repeated after an IOS reload are kept once
+	for (dword i = 0; i < Record_Count; i++)
+	{
+		const Bundle_File::Entry* Entry = &Records[i];
+
+		if (Entry->Type == (dword)Type && Entry->Base == Offset_Base
+			&& Entry->Offset == offset && Entry->Length == size) return;
+	}
+
+	if (!Data) Data = (byte*)SYS_AllocArena2MemLo(Max_Data, 0x20);
+
+	if (!Data || Record_Count == Bundle_File::Max_Entries || size > Max_Data - Data_Size)
+	{
+		Overflow = true;
+		return;
+	}
+
+	memcpy(Data + Data_Size, Buffer, size);
+
+	Bundle_File::Entry* Entry = &Records[Record_Count++];
+
+	Entry->Type		= Type;
+	Entry->Base		= Offset_Base;
+	Entry->Offset	= offset;
+	Entry->Length	= size;
+	Entry->Checksum	= FNV::Hash(Data + Data_Size, size);
+	Entry->Position	= Data_Size;			// Into Data until Commit
+
+	Data_Size		+= size;
+	Recorded_Bytes	+= size;
+}
+
+/*******************************************************************************
+ * Commit: Write the reads of a successful boot to the disc's bundle
+ * -----------------------------------------------------------------------------
+ * The manifest and the data are written as one file, in the order the boot
+ * read them.  A bundle that was used but missed reads is removed instead.
+ *
+ * Return Values:
+ *	returns true if a bundle was written
+ *
+ ******************************************************************************/
+
+bool Boot_Bundle::Commit()
+{
+	if (!Disc) return false;
+
+	// A bundle that missed reads is dropped, so the next boot records a new one
+	if (Matched)
+	{
+		if (File) fclose(File);
+		File = 0;
+
+		if (Missed) remove(Path);
+
+		Status = Missed ? "used, dropped" : "used";
+		return false;
+	}
+
+	if (!Recording || Overflow || !Record_Count || !TMD_Hash || !Path[0])
+	{
+		if (Overflow) Status = "boot too large to record";
+		return false;
+	}
+
+	FILE* fp = Storage::Instance()->OpenFile(Path, "wb");
+
+	if (!fp)
+	{
+		Status = "could not be written";
+		return false;
+	}
+
+	Bundle_File::Header Head;
+	memset(&Head, 0, sizeof(Head));
+	memcpy(Head.Signature, Bundle_File::Signature, sizeof(Head.Signature));
+	memcpy(Head.Disc_ID, Disc_ID, sizeof(Head.Disc_ID));
+
+	Head.Version	= Bundle_File::Version;
+	Head.TMD_Hash	= BE32(TMD_Hash);
+	Head.Count		= BE32(Record_Count);
+
+	bool	Result	= (fwrite(&Head, 1, sizeof(Head), fp) == sizeof(Head));
+	dword	Start	= sizeof(Head) + Record_Count * sizeof(Bundle_File::Entry);
+
+	for (dword i = 0; Result && i < Record_Count; i++)
+	{
+		Bundle_File::Entry Entry = Records[i];
+		Entry.Position += Start;
+		Swap_Entry(&Entry);
+
+		Result = (fwrite(&Entry, 1, sizeof(Entry), fp) == sizeof(Entry));
+	}
+
+	if (Result) Result = (fwrite(Data, 1, Data_Size, fp) == Data_Size);
+	Result = (fclose(fp) == 0) && Result;
+
+	if (!Result) remove(Path);
+
+	Status = Result ? "written" : "could not be written";
+	return Result;
+}
+
+/*******************************************************************************
+ * Disc commands: Passed on to the disc, reads through the bundle
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the disc's result
+ *
+ ******************************************************************************/
+
+bool Boot_Bundle::Initialize()
+{
+	return Disc->Initialize();
+}
+
+void Boot_Bundle::Close()
+{
+	// The FAT may be released next, the bundle is reopened when needed
+	if (File) fclose(File);
+	File = 0;
+
+	Disc->Close();
+}
+
+int Boot_Bundle::Read_DiscID(dvddiskid* ID)
+{
+	int Ret = Disc->Read_DiscID(ID);
+	if (Ret < 0) return Ret;
+
+	memcpy(Disc_ID, ID, sizeof(Disc_ID));
+
+	// Named after the game and maker code
+	char Name[7];
+
+	for (int i = 0; i < 6; i++)
+	{
+		char c = ((const char*)ID)[i];
+		Name[i] = ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) ? c : '_';
+	}
+
+	Name[6] = 0;
+	sprintf(Path, "%s/%s.bin", Folder, Name);
+
+	if (!Found && !Matched)
+	{
+		Found	= Load(ID);
+		Status	= Found ? "found" : "not found";
+	}
+
+	return Ret;
+}
+
+int Boot_Bundle::Read(void* Buffer, unsigned int size, unsigned int offset)
+{
+	bool From_Bundle = Serve(Bundle_File::Type_Encrypted, Buffer, size, offset);
+	int Ret = From_Bundle ? 0 : Disc->Read(Buffer, size, offset);
+
+	if (Ret >= 0) Record(Bundle_File::Type_Encrypted, Buffer, size, offset);
+	return Ret;
+}
+
+int Boot_Bundle::Read_Unencrypted(void* Buffer, unsigned int size, unsigned int offset)
+{
+	bool From_Bundle = Serve(Bundle_File::Type_Unencrypted, Buffer, size, offset);
+	int Ret = From_Bundle ? 0 : Disc->Read_Unencrypted(Buffer, size, offset);
+
+	if (Ret >= 0) Record(Bundle_File::Type_Unencrypted, Buffer, size, offset);
+	return Ret;
+}
+
+int Boot_Bundle::Wait_CoverClose()
+{
+	return Disc->Wait_CoverClose();
+}
+
+int Boot_Bundle::Verify_Cover(bool *Inserted)
+{
+	return Disc->Verify_Cover(Inserted);
+}
+
+int Boot_Bundle::Reset()
+{
+	return Disc->Reset();
+}
+
+int Boot_Bundle::Set_OffsetBase(unsigned int Base)
+{
+	int Ret = Disc->Set_OffsetBase(Base);
+	if (Ret >= 0) Offset_Base = Base;
+
+	return Ret;
+}
+
+int Boot_Bundle::Get_OffsetBase(unsigned int* Base)
+{
+	return Disc->Get_OffsetBase(Base);
+}
+
+/*******************************************************************************
+ * Open_Partition: Open the partition, and check the bundle against its TMD
+ * -----------------------------------------------------------------------------
+ * Once the TMD matches, the boot no longer needs to be recorded.  A bundle
+ * whose TMD doesn't match is replaced by this boot's reads.
+ *
+ * Return Values:
+ *	returns the disc's result
+ *
+ ******************************************************************************/
+
+int Boot_Bundle::Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, unsigned int Cert_Len, void* Out)
+{
+	int Ret = Disc->Open_Partition(Offset, Ticket, Certificate, Cert_Len, Out);
+	if (Ret < 0 || !Out) return Ret;
+
+	const byte*		TMD		= (const byte*)Out;
+	unsigned int	Size	= TMD_Header + ((TMD[TMD_Contents] << 8) | TMD[TMD_Contents + 1]) * TMD_Content;
+
+	if (Size > Max_TMD_Size) Size = Max_TMD_Size;
+	TMD_Hash = FNV::Hash(TMD, Size);
+
+	if (Found && TMD_Hash == Loaded.TMD_Hash)
+	{
+		Matched		= true;
+		Recording	= false;
+		Status		= "matched";
+	}
+	else if (Found || Matched)
+	{
+		Found		= false;
+		Matched		= false;
+		Status		= "TMD changed";
+	}
+
+	return Ret;
+}
+
+int Boot_Bundle::Close_Partition()
+{
+	return Disc->Close_Partition();
+}
+
+int Boot_Bundle::Stop_Motor()
+{
+	return Disc->Stop_Motor();
+}
+
+/*******************************************************************************
+ * Queue_Read: Serve a section from the bundle, or queue it on the disc
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 0 if the data is in place or the read was queued
+ *
+ ******************************************************************************/
+
+int Boot_Bundle::Queue_Read(void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (Serve(Bundle_File::Type_Encrypted, Buffer, size, offset))
+	{
+		Record(Bundle_File::Type_Encrypted, Buffer, size, offset);
+		return 0;
+	}
+
+	int Ret = Disc->Queue_Read(Buffer, size, offset);
+	if (Ret < 0) return Ret;
+
+	if (Disc->Read_Pending())
+	{
+		Pending_Buffer	= Buffer;
+		Pending_Size	= size;
+		Pending_Offset	= offset;
+	}
+	else Record(Bundle_File::Type_Encrypted, Buffer, size, offset);
+
+	return Ret;
+}
+
+/*******************************************************************************
+ * Wait_Read: Wait for the queued read, and record it before it is patched
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the disc's result
+ *
+ ******************************************************************************/
+
+int Boot_Bundle::Wait_Read()
+{
+	int Ret = Disc->Wait_Read();
+
+	if (Pending_Buffer && Ret >= 0) Record(Bundle_File::Type_Encrypted, Pending_Buffer, Pending_Size, Pending_Offset);
+	Pending_Buffer = 0;
+
+	return Ret;
+}
+
+bool Boot_Bundle::Read_Pending()
+{
+	return Disc->Read_Pending();
+}
+
+/*******************************************************************************
+ * Load_Plan: Prefetch from the disc, unless the bundle serves the boot
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the disc is prefetching
+ *
+ ******************************************************************************/
+
+bool Boot_Bundle::Load_Plan(const char* Path, const dvddiskid* Disc_ID)
+{
+	if (Matched) return false;
+
+	return Disc->Load_Plan(Path, Disc_ID);
+}
+
+bool Boot_Bundle::Save_Plan(const char* Path)
+{
+	if (Matched) return true;
+
+	return Disc->Save_Plan(Path);
+}
+
+/*******************************************************************************
+ * Log_Statistics: Write the disc's and the bundle's counters to the log
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Boot_Bundle::Log_Statistics()
+{
+	Disc->Log_Statistics();
+
+	Logger::Instance()->Write("Boot bundle: %s, %u reads (%u bytes) served, %u missed, %u bytes recorded\r\n",
+		Status, Served, Served_Bytes, Missed, Recorded_Bytes);
+}
@@ -0,0 +1,173 @@
+/*******************************************************************************
+ * Buffer_Pool.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of the pool the loader's I/O buffers come from
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <ogc/system.h>
+
+#include "Buffer_Pool.h"
+#include "Logger.h"
+
+//--------------------------------------
+// Buffer_Pool Class
+
+/*******************************************************************************
+ * Buffer_Pool: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Buffer_Pool::Buffer_Pool()
+{
+	Arena		= 0;
+	Depth		= 0;
+	In_Use		= 0;
+	Peak		= 0;
+	Carved		= 0;
+	Allocations	= 0;
+	Reused		= 0;
+
+	for (unsigned int i = 0; i < Classes; i++) Free_List[i] = 0;
+}
+
+/*******************************************************************************
+ * ~Buffer_Pool: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Buffer_Pool::~Buffer_Pool() {}
+
+/*******************************************************************************
+ * Alloc: Get an aligned buffer
+ * -----------------------------------------------------------------------------
+ * The length is rounded up to its size class.  A free buffer of the class
+ * is reused, otherwise a new one is carved from the arena; arena memory
+ * can't be given back, so buffers are never split or joined.
+ *
+ * Return Values:
+ *	returns the buffer, or 0 if it is too big or the arena is used up
+ *
+ ******************************************************************************/
+
+void* Buffer_Pool::Alloc(unsigned int Length)
+{
+	unsigned int Class = 0;
+	while (Class < Classes && (1u << (Min_Class + Class)) < Length) Class++;
+
+	if (Class == Classes) return 0;
+
+	unsigned int Size = 1u << (Min_Class + Class);
+	Block* Entry = Free_List[Class];
+
+	if (Entry)
+	{
+		Free_List[Class] = Entry->Next;
+		Reused++;
+	}
+	else
+	{
+		if (!Arena) Arena = (byte*)SYS_AllocArena2MemLo(Arena_Size, Alignment);
+		if (!Arena || Carved + sizeof(Block) + Size > Arena_Size) return 0;
+
+		Entry			= (Block*)(Arena + Carved);
+		Entry->Class	= Class;
+		Carved			+= sizeof(Block) + Size;
+	}
+
+	Entry->Next		= 0;
+	Entry->Scope	= Depth;
+	Entry->Used		= true;
+
+	In_Use += Size;
+	if (In_Use > Peak) Peak = In_Use;
+	Allocations++;
+
+	return Entry + 1;
+}
+
+/*******************************************************************************
+ * Free: Give a buffer back
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Buffer_Pool::Free(void* Buffer)
+{
+	if (!Buffer || !Arena) return;
+	if ((byte*)Buffer <= Arena || (byte*)Buffer >= Arena + Carved) return;
+
+	Block* Entry = (Block*)Buffer - 1;
+	if (Entry->Used) Release(Entry);
+}
+
+/*******************************************************************************
+ * Release: Put a block on its class' free list
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Buffer_Pool::Release(Block* Entry)
+{
+	Entry->Used			= false;
+	Entry->Next			= Free_List[Entry->Class];
+	Free_List[Entry->Class] = Entry;
+
+	In_Use -= 1u << (Min_Class + Entry->Class);
+}
+
+/*******************************************************************************
+ * Release_Scope: Free every block allocated in a scope or the ones inside it
+ * -----------------------------------------------------------------------------
+ * The blocks lie back to back in the arena, so they are simply walked.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Buffer_Pool::Release_Scope(unsigned int Scope)
+{
+	for (dword Offset = 0; Offset < Carved; )
+	{
+		Block* Entry = (Block*)(Arena + Offset);
+
+		if (Entry->Used && Entry->Scope >= Scope) Release(Entry);
+
+		Offset += sizeof(Block) + (1u << (Min_Class + Entry->Class));
+	}
+}
+
+/*******************************************************************************
+ * Log_Statistics: Write the pool's usage to the log
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Buffer_Pool::Log_Statistics() const
+{
+	Logger::Instance()->Write("Buffer pool: peak %u bytes, %u of %u bytes of MEM2 carved, %u allocations (%u reused)\r\n",
+		Peak, Carved, (unsigned int)Arena_Size, Allocations, Reused);
+}
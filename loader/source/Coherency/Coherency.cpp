@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * Coherency.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class keeping the ranges of game memory the
+ *	loader wrote or had loaded
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <ogc/cache.h>
+
+#include "Coherency.h"
+#include "Logger.h"
+
+//--------------------------------------
+// Coherency Class
+
+/*******************************************************************************
+ * Coherency: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Coherency::Coherency()
+{
+	Flushed_Ranges	= 0;
+	Flushed_Bytes	= 0;
+
+	Clear();
+}
+
+/*******************************************************************************
+ * ~Coherency: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Coherency::~Coherency() {}
+
+/*******************************************************************************
+ * Clear: Forget every range
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Coherency::Clear()
+{
+	Range_Count = 0;
+}
+
+/*******************************************************************************
+ * Touch: Record a range of game memory
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Coherency::Touch(const void* Address, unsigned int Length)
+{
+	if (Length == 0) return;
+
+	unsigned long Start	= (unsigned long)Address & ~(unsigned long)(Line_Size - 1);
+	unsigned long End	= ((unsigned long)Address + Length + Line_Size - 1) & ~(unsigned long)(Line_Size - 1);
+
+	if (Range_Count == Max_Ranges)
+	{
+		Merge();
+		if (Range_Count == Max_Ranges) Merge_Closest();
+	}
+
+	Ranges[Range_Count].Start	= Start;
+	Ranges[Range_Count].End		= End;
+	Range_Count++;
+}
+
+/*******************************************************************************
+ * Merge: Sort the ranges and join the ones overlapping or touching
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Coherency::Merge()
+{
+	// Insertion sort, the apploader hands out sections mostly in order
+	for (unsigned int i = 1; i < Range_Count; i++)
+	{
+		Range Entry = Ranges[i];
+		unsigned int j = i;
+
+		while (j > 0 && Ranges[j - 1].Start > Entry.Start)
+		{
+			Ranges[j] = Ranges[j - 1];
+			j--;
+		}
+
+		Ranges[j] = Entry;
+	}
+
+	unsigned int Count = 0;
+
+	for (unsigned int i = 0; i < Range_Count; i++)
+	{
+		if (Count > 0 && Ranges[i].Start <= Ranges[Count - 1].End)
+		{
+			if (Ranges[i].End > Ranges[Count - 1].End) Ranges[Count - 1].End = Ranges[i].End;
+		}
+		else Ranges[Count++] = Ranges[i];
+	}
+
+	Range_Count = Count;
+}
+
+/*******************************************************************************
+ * Merge_Closest: Make room by joining the two ranges with the smallest gap
+ * -----------------------------------------------------------------------------
+ * The ranges must be sorted and disjoint (after Merge).  The gap is then
+ * flushed too, which is harmless.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Coherency::Merge_Closest()
+{
+	if (Range_Count < 2) return;
+
+	unsigned int Closest = 0;
+
+	for (unsigned int i = 1; i + 1 < Range_Count; i++)
+	{
+		if (Ranges[i + 1].Start - Ranges[i].End < Ranges[Closest + 1].Start - Ranges[Closest].End) Closest = i;
+	}
+
+	Ranges[Closest].End = Ranges[Closest + 1].End;
+
+	for (unsigned int i = Closest + 1; i + 1 < Range_Count; i++) Ranges[i] = Ranges[i + 1];
+
+	Range_Count--;
+}
+
+/*******************************************************************************
+ * Flush: Flush the data cache and invalidate the instruction cache
+ * -----------------------------------------------------------------------------
+ * Done once before the jump to the game, for the merged ranges only.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Coherency::Flush()
+{
+	Merge();
+
+	Flushed_Ranges	= Range_Count;
+	Flushed_Bytes	= 0;
+
+	for (unsigned int i = 0; i < Range_Count; i++)
+	{
+		void*	Address	= (void*)Ranges[i].Start;
+		dword	Length	= Ranges[i].End - Ranges[i].Start;
+
+		DCFlushRange(Address, Length);
+		ICInvalidateRange(Address, Length);
+
+		Flushed_Bytes += Length;
+	}
+
+	Clear();
+}
+
+/*******************************************************************************
+ * Log_Statistics: Write what the last Flush covered to the log
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Coherency::Log_Statistics() const
+{
+	Logger::Instance()->Write("Cache flush: %u bytes in %u ranges (all of MEM1: %u bytes)\r\n",
+		Flushed_Bytes, Flushed_Ranges, (unsigned int)MEM1_Size);
+}
@@ -19,6 +19,7 @@
 #include <string.h>
 
 #include "Configuration.h"
+#include "Cluster_Cache.h"
 
 //--------------------------------------
 // Configuration Class
@@ -82,6 +83,18 @@ bool Configuration::Read(const char *Path)
 		// Get File Version		
 		switch (Buffer[15]) 
 		{
+			case 9:		// Version 9
+				Parser = new ConfigVer9();
+				break;
+
+			case 8:		// Version 8
+				Parser = new ConfigVer8();
+				break;
+
+			case 7:		// Version 7
+				Parser = new ConfigVer7();
+				break;
+
 			case 6:		// Version 6
 				Parser = new ConfigVer6();
 				break;
@@ -187,11 +200,14 @@ bool Configuration::Parse(FILE *fp)	// Default Settings
 	Data.Load_requested_IOS = false;
 	Data.Country_String_Patching = false;
 	Data.SamNMaxFix = true;
+	Data.Spin_Down = 5;
+	Data.Use_Image = false;
+	Data.Cache_Clusters = Cluster_Cache::Default_Clusters;
 	
 	return true;
 }
 
-bool ConfigVer6::Parse(FILE *fp)	// Ver5 Settings
+bool ConfigVer9::Parse(FILE *fp)	// Ver9 Settings
 {
 	// Get File Data
 	if (fread(&Data, 1, sizeof(Data), fp) != sizeof(Data))
@@ -200,11 +216,86 @@ bool ConfigVer6::Parse(FILE *fp)	// Ver5 Settings
 		return true;
 }
 
+bool ConfigVer8::Parse(FILE *fp)	// Ver8 Settings
+{
+	// Get File Data
+	ConfigData::Ver8 Temp;
+	if (fread(&Temp, 1, sizeof(Temp), fp) != sizeof(Temp))
+		return false;
+
+	// Convert
+	Configuration::Parse(0);
+	Data.IOS = Temp.IOS;
+	Data.Language = Temp.Language;
+	Data.AutoBoot = Temp.AutoBoot;
+	Data.SysVMode = Temp.SysVMode;
+	Data.Silent = Temp.Silent;
+	Data.Logging = Temp.Logging;
+	Data.Remove_002 = Temp.Remove_002;
+	Data.Fake_IOS_Version = Temp.Fake_IOS_Version;
+	Data.Country_String_Patching = Temp.Country_String_Patching;
+	Data.Load_requested_IOS = Temp.Load_requested_IOS;
+	Data.SamNMaxFix = Temp.SamNMaxFix;
+	Data.Spin_Down = Temp.Spin_Down;
+	Data.Use_Image = Temp.Use_Image;
+
+	return true;
+}
+
+bool ConfigVer7::Parse(FILE *fp)	// Ver7 Settings
+{
+	// Get File Data
+	ConfigData::Ver7 Temp;
+	if (fread(&Temp, 1, sizeof(Temp), fp) != sizeof(Temp))
+		return false;
+
+	// Convert
+	Configuration::Parse(0);
+	Data.IOS = Temp.IOS;
+	Data.Language = Temp.Language;
+	Data.AutoBoot = Temp.AutoBoot;
+	Data.SysVMode = Temp.SysVMode;
+	Data.Silent = Temp.Silent;
+	Data.Logging = Temp.Logging;
+	Data.Remove_002 = Temp.Remove_002;
+	Data.Fake_IOS_Version = Temp.Fake_IOS_Version;
+	Data.Country_String_Patching = Temp.Country_String_Patching;
+	Data.Load_requested_IOS = Temp.Load_requested_IOS;
+	Data.SamNMaxFix = Temp.SamNMaxFix;
+	Data.Spin_Down = Temp.Spin_Down;
+
+	return true;
+}
+
+bool ConfigVer6::Parse(FILE *fp)	// Ver6 Settings
+{
+	// Get File Data
+	ConfigData::Ver6 Temp;
+	if (fread(&Temp, 1, sizeof(Temp), fp) != sizeof(Temp))
+		return false;
+
+	// Convert
+	Configuration::Parse(0);
+	Data.IOS = Temp.IOS;
+	Data.Language = Temp.Language;
+	Data.AutoBoot = Temp.AutoBoot;
+	Data.SysVMode = Temp.SysVMode;
+	Data.Silent = Temp.Silent;
+	Data.Logging = Temp.Logging;
+	Data.Remove_002 = Temp.Remove_002;
+	Data.Fake_IOS_Version = Temp.Fake_IOS_Version;
+	Data.Country_String_Patching = Temp.Country_String_Patching;
+	Data.Load_requested_IOS = Temp.Load_requested_IOS;
+	Data.SamNMaxFix = Temp.SamNMaxFix;
+
+	return true;
+}
+
 bool ConfigVer5::Parse(FILE *fp)	// Ver4 Settings
 {
 	// Get File Data
 	ConfigData::Ver5 Temp;
-	if (fread(&Temp, 1, sizeof(Data), fp) != sizeof(Data))
+	if (fread(&Temp, 1, sizeof(Temp), fp) != sizeof(Temp))
 		return false;
 
 	// Convert
@@ -227,7 +318,7 @@ bool ConfigVer4::Parse(FILE *fp)	// Ver4 Settings
 {
 	// Get File Data
 	ConfigData::Ver4 Temp;
-	if (fread(&Temp, 1, sizeof(Data), fp) != sizeof(Data))
+	if (fread(&Temp, 1, sizeof(Temp), fp) != sizeof(Temp))
 		return false;
 
 	// Convert
@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * Cluster_Cache.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a LRU cache of disc clusters kept in MEM2
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+#include <ogc/system.h>
+
+#include "Cluster_Cache.h"
+
+//--------------------------------------
+// Cluster_Cache Class
+
+/*******************************************************************************
+ * Cluster_Cache: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Cluster_Cache::Cluster_Cache()
+{
+	Size		= Default_Clusters;
+	Hits		= 0;
+	Misses		= 0;
+	Count		= 0;
+	Reserved	= 0;
+	Clock		= 0;
+
+	memset(Entries, 0, sizeof(Entries));
+	memset(Disc, 0, sizeof(Disc));
+}
+
+/*******************************************************************************
+ * ~Cluster_Cache: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Cluster_Cache::~Cluster_Cache() {}
+
+/*******************************************************************************
+ * Initialize: Reserve the cluster buffers in MEM2
+ * -----------------------------------------------------------------------------
+ * Arena memory can't be given back, so a smaller Size leaves the buffers of the
+ * dropped slots reserved, and they are used again if the cache grows.
+ *
+ * Return Values:
+ *	true if the cache is usable
+ *
+ ******************************************************************************/
+
+bool Cluster_Cache::Initialize()
+{
+	unsigned int Clusters = (Size > Max_Clusters) ? Max_Clusters : Size;
+
+	if (Clusters > Reserved)
+	{
+		byte* Buffer = (byte*)SYS_AllocArena2MemLo((Clusters - Reserved) * Raw_Cluster_Size, 0x20);
+		if (!Buffer) return (Count > 0);
+
+		for (unsigned int i = Reserved; i < Clusters; i++)
+		{
+			Entries[i].Valid	= false;
+			Entries[i].Data		= Buffer + ((i - Reserved) * Raw_Cluster_Size);
+		}
+
+		Reserved = Clusters;
+	}
+
+	for (unsigned int i = Clusters; i < Count; i++) Entries[i].Valid = false;
+
+	Count = Clusters;
+	return (Count > 0);
+}
+
+/*******************************************************************************
+ * Flush: Drop every cached cluster
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Cluster_Cache::Flush()
+{
+	for (unsigned int i = 0; i < Count; i++) Entries[i].Valid = false;
+}
+
+/*******************************************************************************
+ * Validate_Disc: Flush the cache if a different disc was identified
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Cluster_Cache::Validate_Disc(const void* Disc_ID)
+{
+	if (memcmp(Disc, Disc_ID, sizeof(Disc)) == 0) return;
+
+	Flush();
+	memcpy(Disc, Disc_ID, sizeof(Disc));
+}
+
+/*******************************************************************************
+ * Cluster_Size: Cluster granularity of a read type
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns size in bytes
+ *
+ ******************************************************************************/
+
+unsigned int Cluster_Cache::Cluster_Size(int Type) const
+{
+	return (Type == Encrypted) ? Data_Cluster_Size : Raw_Cluster_Size;
+}
+
+/*******************************************************************************
+ * Caches: Decide whether a read goes through the cache
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	true if the read should be served cluster by cluster
+ *
+ ******************************************************************************/
+
+bool Cluster_Cache::Caches(int Type, unsigned int size) const
+{
+	return (Count > 0) && (size <= Max_Read_Clusters * Cluster_Size(Type));
+}
+
+/*******************************************************************************
+ * Find: Look up a cluster
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the cluster data, or NULL if it isn't cached
+ *
+ ******************************************************************************/
+
+byte* Cluster_Cache::Find(int Type, dword Partition, dword Base, dword Offset)
+{
+	for (unsigned int i = 0; i < Count; i++)
+	{
+		Entry* e = &Entries[i];
+
+		if (e->Valid && e->Type == Type && e->Offset == Offset && e->Partition == Partition && e->Base == Base)
+		{
+			e->Stamp = ++Clock;
+			Hits++;
+			return e->Data;
+		}
+	}
+
+	Misses++;
+	return 0;
+}
+
+/*******************************************************************************
+ * Insert: Claim the least recently used slot for a cluster
+ * -----------------------------------------------------------------------------
+ * The slot stays invalid until the caller has filled the returned buffer and
+ * hands it to Commit, so a failed read never leaves a cluster behind.
+ *
+ * Return Values:
+ *	returns a 32-byte aligned buffer of Raw_Cluster_Size bytes
+ *
+ ******************************************************************************/
+
+byte* Cluster_Cache::Insert(int Type, dword Partition, dword Base, dword Offset)
+{
+	Entry* Victim = &Entries[0];
+
+	for (unsigned int i = 0; i < Count; i++)
+	{
+		if (!Entries[i].Valid)
+		{
+			Victim = &Entries[i];
+			break;
+		}
+
+		if (Entries[i].Stamp < Victim->Stamp) Victim = &Entries[i];
+	}
+
+	Victim->Valid		= false;
+	Victim->Type		= Type;
+	Victim->Partition	= Partition;
+	Victim->Base		= Base;
+	Victim->Offset		= Offset;
+	Victim->Stamp		= ++Clock;
+
+	return Victim->Data;
+}
+
+/*******************************************************************************
+ * Commit: Validate a slot returned by Insert, once its buffer was read
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Cluster_Cache::Commit(byte* Data)
+{
+	for (unsigned int i = 0; i < Count; i++)
+	{
+		if (Entries[i].Data == Data) Entries[i].Valid = true;
+	}
+}
@@ -16,32 +16,24 @@
 // Includes
 
 #include <string.h>
-//#include <ogcsys.h>
+#include <ogc/ipc.h>
 #include <ogc/ios.h>
-#include <ogc/isfs.h>
-#include <ogc/video.h>
 #include <ogc/system.h>
-#include <ogc/consol.h>
-#include <ogc/ios.h>
-#include <ogc/es.h>
-#include <ogc/ipc.h>
-#include <ogc/stm.h>
-#include <ogc/color.h>
-#include <ogc/cache.h>
-#include <ogc/conf.h>
-#include <ogc/consol.h>
 #include <ogc/dvd.h>
+#include <ogc/lwp_watchdog.h>
 
 #include "DIP.h"
 #include "Ioctl.h"
 #include "Memory_Map.h"
+#include "Logger.h"
+#include "Profiler.h"
 
 //--------------------------------------
 // DIP Class
 
-unsigned int DIP::Mutex = 0;
-unsigned int DIP::Command[8];
-unsigned int DIP::Output[8];
+mutex_t DIP::Mutex = LWP_MUTEX_NULL;
+sem_t DIP::Free_Blocks = LWP_SEM_NULL;
+DIP::Request DIP::Blocks[DIP::Block_Count];
 
 /*******************************************************************************
  * DIP: Default Constructor
@@ -54,9 +46,21 @@ unsigned int DIP::Output[8];
 DIP::DIP()
 {
 	this->Device_Handle = -1;
-
-	memset(Command, 0, 0x20);
-	memset(Output, 0, 0x20);
+	this->Offset_Base = 0;
+	this->Partition = 0;
+	this->Pending_Read = 0;
+	this->Prefetch_Count = 0;
+	this->Deferred_Buffer = 0;
+	this->Deferred_Size = 0;
+	this->Deferred_Offset = 0;
+	this->Bounce = 0;
+	this->Bounced = 0;
+
+	for (int i = 0; i < Block_Count; i++)
+	{
+		Blocks[i].Busy = false;
+		Blocks[i].Done = LWP_SEM_NULL;
+	}
 }
 
 /*******************************************************************************
@@ -79,6 +83,85 @@ void DIP::Unlock()
 	LWP_MutexUnlock(Mutex);
 }
 
+/*******************************************************************************
+ * Send: Issue a synchronous ioctl with the command in a block, and time it
+ * -----------------------------------------------------------------------------
+ * Without an output buffer the block's own output is used.
+ *
+ * Return Values:
+ *	returns result of IOS_Ioctl
+ *
+ ******************************************************************************/
+
+int DIP::Send(int Command_ID, Request* Block, void* Output, unsigned int Length)
+{
+	unsigned int Bytes = Length;
+
+	if (!Output)
+	{
+		Output	= Block->Output;
+		Length	= 0x20;
+	}
+
+	u64 Start = gettime();
+	int Ret = IOS_Ioctl(Device_Handle, Command_ID, Block->Command, 0x20, Output, Length);
+
+	Stats.Record(Command_ID, Ret, Bytes, Start, gettime());
+
+	return Ret;
+}
+
+/*******************************************************************************
+ * Acquire: Take a free command block, waiting for one if all are in flight
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns a cleared command block owned by the caller
+ *
+ ******************************************************************************/
+
+DIP::Request* DIP::Acquire()
+{
+	LWP_SemWait(Free_Blocks);
+
+	Lock();
+
+	Request* Block = 0;
+	for (int i = 0; i < Block_Count && !Block; i++)
+	{
+		if (!Blocks[i].Busy) Block = &Blocks[i];
+	}
+
+	Block->Busy = true;
+
+	Unlock();
+
+	// Any command keeps the motor spinning
+	Spin.Access();
+
+	memset(Block->Command, 0, 0x20);
+	memset(Block->Output, 0, 0x20);
+	Block->Result = 0;
+
+	return Block;
+}
+
+/*******************************************************************************
+ * Release: Return a command block to the pool
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void DIP::Release(Request* Block)
+{
+	Lock();
+	Block->Busy = false;
+	Unlock();
+
+	LWP_SemPost(Free_Blocks);
+}
+
 /*******************************************************************************
  * Initialize: Open the /dev/di file descriptor
  * -----------------------------------------------------------------------------
@@ -89,7 +172,21 @@ void DIP::Unlock()
 
 bool DIP::Initialize()
 {
-	LWP_MutexInit(&Mutex, false);
+	Scoped_Timer Timer("DIP::Initialize");
+
+	if (Mutex == LWP_MUTEX_NULL)
+	{
+		LWP_MutexInit(&Mutex, false);
+		LWP_SemInit(&Free_Blocks, Block_Count, Block_Count);
+
+		for (int i = 0; i < Block_Count; i++) LWP_SemInit(&Blocks[i].Done, 0, 1);
+	}
+
+	Cache.Initialize();
+	Planner.Initialize();
+
+	if (!Bounce) Bounce = (byte*)SYS_AllocArena2MemLo(Bounce_Size, 0x20);
+
 	if (Device_Handle < 0)
 	{
 		Device_Handle = IOS_Open("/dev/di", 0);
@@ -108,10 +205,18 @@ bool DIP::Initialize()
 
 void DIP::Close()
 {
+	// Never pull the handle out from under a queued read
+	if (Pending_Read) Wait_Read();
+	Prefetch_Stop();
+
+	Spin.Closed();
+
 	if (Device_Handle > 0)
 	{
 		IOS_Close(Device_Handle);
 		Device_Handle = -1;
+		Offset_Base = 0;
+		Partition = 0;
 	}
 }
 
@@ -127,16 +232,16 @@ int DIP::Inquiry(void* Drive_ID)
 {
 	if (!Drive_ID) throw "Null DriveID pointer";
 
-	Command[0] = Ioctl::DI_Inquiry << 24;
+	Request* Block = Acquire();
 
-	Lock();
+	Block->Command[0] = Ioctl::DI_Inquiry << 24;
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_Inquiry, Command, 0x20, Output, 0x20);
+	int Ret = Send(Ioctl::DI_Inquiry, Block);
 
-	Unlock();
+	memcpy(Drive_ID, Block->Output, 8);
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_Inquiry)";
-	memcpy(Drive_ID, Output, 8);
 
 	return ((Ret == 1) ? 0 : -Ret);
 }
@@ -153,16 +258,22 @@ int DIP::Read_DiscID(dvddiskid* Disc_ID)
 {
 	if (!Disc_ID) throw "Null Disc_ID pointer";
 	
-	Command[0] = Ioctl::DI_ReadID << 24;
+	Request* Block = Acquire();
 
-	Lock();
+	Block->Command[0] = Ioctl::DI_ReadID << 24;
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_ReadID, Command, 0x20, Output, 0x20);
+	int Ret = Send(Ioctl::DI_ReadID, Block);
 
-	Unlock();
+	memcpy(Disc_ID, Block->Output, 0x20);
+	if (Ret == 1) Cache.Validate_Disc(Block->Output);
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_ReadID)";
-	memcpy(Disc_ID, Output, 0x20);
+
+	if (Ret == 1) Spin.Identified();
+
+	// The disc changed behind a skipped reset, reset it and ask again
+	else if (Spin.Reset_Skipped() && Send_Reset() == 0) return Read_DiscID(Disc_ID);
 	
 	return ((Ret == 1) ? 0 : -Ret);
 }
@@ -170,6 +281,8 @@ int DIP::Read_DiscID(dvddiskid* Disc_ID)
 /*******************************************************************************
  * Read: Read from the disc into a buffer
  * -----------------------------------------------------------------------------
+ * Any buffer and offset can be used, see Split_Read.
+ *
  * Return Values:
  *	returns result of Ioctl command
  *
@@ -178,49 +291,166 @@ int DIP::Read_DiscID(dvddiskid* Disc_ID)
 int DIP::Read(void* Buffer, unsigned int size, unsigned int offset)
 {
 	if (!Buffer) return -1; //throw "Null Buffer";
-	if (reinterpret_cast<unsigned int>(Buffer) & 0x1f) throw "Buffer alignment error";
 
-	memset(Command, 0, 0x20);
-	Command[0] = Ioctl::DI_Read << 24;
-	Command[1] = size;
-	Command[2] = offset >> 2;
+	return Split_Read(Cluster_Cache::Encrypted, Buffer, size, offset);
+}
 
-	Lock();
+/*******************************************************************************
+ * Read_Unencrypted: Read from the disc into a buffer
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns result of Ioctl command
+ *
+ ******************************************************************************/
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_Read, Command, 0x20, Buffer, size);
-	
-	Unlock();
+int DIP::Read_Unencrypted(void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (!Buffer) throw "Null Buffer";
 
-	if (Ret == 2) throw "Ioctl error (DI_Read)";
+	return Split_Read(Cluster_Cache::Unencrypted, Buffer, size, offset);
+}
 
-	return ((Ret == 1) ? 0 : -Ret);
+/*******************************************************************************
+ * Split_Read: Read into a buffer the drive may not be able to DMA into
+ * -----------------------------------------------------------------------------
+ * An aligned buffer at a word offset is read in place, as before.  Otherwise
+ * the aligned body of the buffer is still read in place, and only the head
+ * up to the first cache line and the tail after the last one go through
+ * the bounce buffer.  If the buffer and the offset are misaligned against
+ * each other the body can't be DMAed either, and everything is bounced.
+ *
+ * Return Values:
+ *	returns result of Ioctl command
+ *
+ ******************************************************************************/
+
+int DIP::Split_Read(int Type, void* Buffer, unsigned int size, unsigned int offset)
+{
+	unsigned long Address = reinterpret_cast<unsigned long>(Buffer);
+
+	if (!(Address & 0x1f) && !(offset & 3)) return Cached_Read(Type, Buffer, size, offset);
+	if (!Bounce) throw "Buffer alignment error";
+
+	unsigned int Head = (0x20 - (Address & 0x1f)) & 0x1f;
+	if (Head > size) Head = size;
+
+	if ((offset + Head) & 3) return Bounce_Read(Type, Buffer, size, offset);
+
+	unsigned int	Body	= (size - Head) & ~0x1f;
+	byte*			Out		= (byte*)Buffer;
+	int				Ret		= 0;
+
+	if (Head)				Ret = Bounce_Read(Type, Out, Head, offset);
+	if (Ret >= 0 && Body)	Ret = Cached_Read(Type, Out + Head, Body, offset + Head);
+	if (Ret >= 0 && Head + Body < size) Ret = Bounce_Read(Type, Out + Head + Body, size - Head - Body, offset + Head + Body);
+
+	return Ret;
 }
 
 /*******************************************************************************
- * Read_Unencrypted: Read from the disc into a buffer
+ * Bounce_Read: Read through the bounce buffer and copy out
  * -----------------------------------------------------------------------------
+ * The drive reads whole cache lines from a word offset, so up to a line
+ * past the end of the range is read too.
+ *
  * Return Values:
  *	returns result of Ioctl command
  *
  ******************************************************************************/
 
-int DIP::Read_Unencrypted(void* Buffer, unsigned int size, unsigned int offset)
+int DIP::Bounce_Read(int Type, void* Buffer, unsigned int size, unsigned int offset)
 {
-	if (!Buffer) throw "Null Buffer";
-	if (reinterpret_cast<unsigned int>(Buffer) & 0x1f) throw "Buffer alignment error";
+	byte* Out = (byte*)Buffer;
 
-	memset(Command, 0, 0x20);
-	Command[0] = Ioctl::DI_ReadUnencrypted << 24;
-	Command[1] = size;
-	Command[2] = offset >> 2;
+	while (size > 0)
+	{
+		unsigned int Start	= offset & ~3;
+		unsigned int Skip	= offset - Start;
+		unsigned int Length	= (size < Bounce_Size - Skip) ? size : Bounce_Size - Skip;
+		unsigned int Fetch	= (Skip + Length + 0x1f) & ~0x1f;
 
-	Lock();
+		int Ret = Cached_Read(Type, Bounce, Fetch, Start);
+		if (Ret < 0) return Ret;
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_ReadUnencrypted, Command, 0x20, Buffer, size);
+		memcpy(Out, Bounce + Skip, Length);
+		Bounced += Length;
 
-	Unlock();
+		Out		+= Length;
+		offset	+= Length;
+		size	-= Length;
+	}
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Cached_Read: Serve a read cluster by cluster through the cache
+ * -----------------------------------------------------------------------------
+ * Large reads go straight to the drive.  If filling a cluster fails (e.g. the
+ * cluster runs past the end of the disc) the rest is read directly.
+ *
+ * Return Values:
+ *	returns result of Ioctl command
+ *
+ ******************************************************************************/
+
+int DIP::Cached_Read(int Type, void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (!Cache.Caches(Type, size)) return Raw_Read(Type, Buffer, size, offset);
+
+	unsigned int	Cluster	= Cache.Cluster_Size(Type);
+	byte*			Out		= (byte*)Buffer;
+
+	while (size > 0)
+	{
+		unsigned int Start	= offset - (offset % Cluster);
+		unsigned int Skip	= offset - Start;
+		unsigned int Length	= (size < Cluster - Skip) ? size : Cluster - Skip;
+
+		byte* Data = Cache.Find(Type, Partition, Offset_Base, Start);
+
+		if (!Data)
+		{
+			Data = Cache.Insert(Type, Partition, Offset_Base, Start);
 
-	if (Ret == 2) throw "Ioctl error (DI_ReadUnencrypted)";
+			if (Raw_Read(Type, Data, Cluster, Start) < 0) return Raw_Read(Type, Out, size, offset);
+
+			Cache.Commit(Data);
+		}
+
+		memcpy(Out, Data + Skip, Length);
+
+		Out		+= Length;
+		offset	+= Length;
+		size	-= Length;
+	}
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Raw_Read: Issue DI_Read or DI_ReadUnencrypted
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns result of Ioctl command
+ *
+ ******************************************************************************/
+
+int DIP::Raw_Read(int Type, void* Buffer, unsigned int size, unsigned int offset)
+{
+	int Command_ID = (Type == Cluster_Cache::Encrypted) ? Ioctl::DI_Read : Ioctl::DI_ReadUnencrypted;
+
+	Request* Block = Acquire();
+
+	Block->Command[0] = Command_ID << 24;
+	Block->Command[1] = size;
+	Block->Command[2] = offset >> 2;
+
+	int Ret = Send(Command_ID, Block, Buffer, size);
+
+	Release(Block);
+
+	if (Ret == 2) throw (Type == Cluster_Cache::Encrypted) ? "Ioctl error (DI_Read)" : "Ioctl error (DI_ReadUnencrypted)";
 
 	return ((Ret == 1) ? 0 : -Ret);
 }
@@ -235,17 +465,20 @@ int DIP::Read_Unencrypted(void* Buffer, unsigned int size, unsigned int offset)
 
 int DIP::Wait_CoverClose()
 {
-	memset(Command, 0, 0x20);
-	Command[0] = Ioctl::DI_WaitCoverClose << 24;
+	Request* Block = Acquire();
 
-	Lock();
+	Block->Command[0] = Ioctl::DI_WaitCoverClose << 24;
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_WaitCoverClose, Command, 0x20, Output, 0x20);
-	
-	Unlock();
+	int Ret = Send(Ioctl::DI_WaitCoverClose, Block);
 
+	Release(Block);
+	
 	if (Ret == 2) throw "Ioctl error (DI_WaitCoverClose)";
 
+	// A different disc may have been inserted
+	Cache.Flush();
+	Spin.Removed();
+
 	return ((Ret == 1) ? 0 : -Ret);
 }
 
@@ -259,17 +492,17 @@ int DIP::Wait_CoverClose()
 
 int DIP::Verify_Cover(bool *Inserted)
 {
-	memset(Command, 0, 0x20);
-	Command[0] = Ioctl::DI_VerifyCover << 24;
+	Request* Block = Acquire();
 
-	Lock();
+	Block->Command[0] = Ioctl::DI_VerifyCover << 24;
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_VerifyCover, Command, 0x20, Output, 0x20);
+	int Ret = Send(Ioctl::DI_VerifyCover, Block);
 
-	Unlock();
+	if (Ret == 1) *Inserted = !((bool)*Block->Output);
+	if (Ret == 1 && !*Inserted) Spin.Removed();
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_VerifyCover)";
-	if (Ret == 1) *Inserted = !((bool)*Output);
 
 	return ((Ret == 1) ? 0 : -Ret);
 }
@@ -277,6 +510,8 @@ int DIP::Verify_Cover(bool *Inserted)
 /*******************************************************************************
  * Reset: Resets the drive's hardware
  * -----------------------------------------------------------------------------
+ * Skipped while the same disc spins, identified under the same IOS.
+ *
  * Return Values:
  *	returns result of Ioctl command
  *
@@ -284,17 +519,35 @@ int DIP::Verify_Cover(bool *Inserted)
 
 int DIP::Reset()
 {
-	Command[0] = Ioctl::DI_Reset << 24;
-	Command[1] = 1;
+	if (Spin.Skip_Reset(IOS_GetVersion())) return 0;
 
-	Lock();
+	return Send_Reset();
+}
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_Reset, Command, 0x20, Output, 0x20);
+/*******************************************************************************
+ * Send_Reset: Send DI_Reset, which spins the drive up
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns result of Ioctl command
+ *
+ ******************************************************************************/
 
-	Unlock();
+int DIP::Send_Reset()
+{
+	Request* Block = Acquire();
+
+	Block->Command[0] = Ioctl::DI_Reset << 24;
+	Block->Command[1] = 1;
+
+	int Ret = Send(Ioctl::DI_Reset, Block);
+
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_Reset)";
 
+	if (Ret == 1) Spin.Reset(IOS_GetVersion());
+	else Spin.Removed();
+
 	return ((Ret == 1) ? 0 : -Ret);
 }
 
@@ -308,15 +561,14 @@ int DIP::Reset()
 
 int DIP::Enable_DVD()
 {
-	memset(Command, 0, 0x20);
-	Command[0] = Ioctl::DI_EnableDVD << 24;
-	Command[1] = 1;
+	Request* Block = Acquire();
 
-	Lock();
+	Block->Command[0] = Ioctl::DI_EnableDVD << 24;
+	Block->Command[1] = 1;
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_EnableDVD, Command, 0x20, Output, 0x20);
+	int Ret = Send(Ioctl::DI_EnableDVD, Block);
 
-	Unlock();
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_EnableDVD)";
 
@@ -333,17 +585,17 @@ int DIP::Enable_DVD()
 
 int DIP::Set_OffsetBase(unsigned int Base)
 {
-	memset(Command, 0, 0x20);
-	Command[0] = Ioctl::DI_SetOffsetBase << 24;
-	Command[1] = Base >> 2;
+	Request* Block = Acquire();
 
-	Lock();
+	Block->Command[0] = Ioctl::DI_SetOffsetBase << 24;
+	Block->Command[1] = Base >> 2;
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_SetOffsetBase, Command, 0x20, Output, 0x20);
+	int Ret = Send(Ioctl::DI_SetOffsetBase, Block);
 
-	Unlock();
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_SetOffsetBase)";
+	if (Ret == 1) Offset_Base = Base;
 
 	return ((Ret == 1) ? 0 : -Ret);
 }
@@ -358,17 +610,16 @@ int DIP::Set_OffsetBase(unsigned int Base)
 
 int DIP::Get_OffsetBase(unsigned int* Base)
 {
-	memset(Command, 0, 0x20);
-	Command[0] = Ioctl::DI_GetOffsetBase << 24;
+	Request* Block = Acquire();
 
-	Lock();
+	Block->Command[0] = Ioctl::DI_GetOffsetBase << 24;
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_GetOffsetBase, Command, 0x20, Output, 0x20);
+	int Ret = Send(Ioctl::DI_GetOffsetBase, Block);
 
-	Unlock();
+	if (Ret == 1) *Base = *((unsigned int*)Block->Output);
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_GetOffsetBase)";
-	if (Ret == 1) *Base = *((unsigned int*)Output);
 	
 	return ((Ret == 1) ? 0 : -Ret);
 }
@@ -383,12 +634,15 @@ int DIP::Get_OffsetBase(unsigned int* Base)
 
 int DIP::Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, unsigned int Cert_Len, void* Out)
 {
-	static ioctlv	Vectors[5]		__attribute__((aligned(0x20)));
+	Prefetch_Stop();
 
-	Command[0] = Ioctl::DI_OpenPartition << 24;
-	Command[1] = Offset;
+	Request* Block = Acquire();
+	ioctlv* Vectors = Block->Vectors;
 
-	Vectors[0].data		= Command;
+	Block->Command[0] = Ioctl::DI_OpenPartition << 24;
+	Block->Command[1] = Offset;
+
+	Vectors[0].data		= Block->Command;
 	Vectors[0].len		= 0x20;
 	Vectors[1].data		= (Ticket == NULL) ? 0 : Ticket;
 	Vectors[1].len		= (Ticket == NULL) ? 0 : 0x2a4;
@@ -396,16 +650,19 @@ int DIP::Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, un
 	Vectors[2].len		= (Certificate == NULL) ? 0 : Cert_Len;
 	Vectors[3].data		= Out;
 	Vectors[3].len		= 0x49e4;
-	Vectors[4].data		= Output;
+	Vectors[4].data		= Block->Output;
 	Vectors[4].len		= 0x20;
 
-	Lock();
-
+	u64 Start = gettime();
 	int Ret = IOS_Ioctlv(Device_Handle, Ioctl::DI_OpenPartition, 3, 2, Vectors);
 
-	Unlock();
+	Stats.Record(Ioctl::DI_OpenPartition, Ret, 0, Start, gettime());
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_OpenPartition)";
+	if (Ret == 1) Partition = Offset;
+
+	Planner.Reset();
 
 	return ((Ret == 1) ? 0 : -Ret);
 }
@@ -420,15 +677,20 @@ int DIP::Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, un
 
 int DIP::Close_Partition() 
 {
-	Lock();
+	Prefetch_Stop();
 
-	Command[0] = Ioctl::DI_ClosePartition << 24;
+	Request* Block = Acquire();
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_ClosePartition, Command, 0x20, Output, 0x20);
+	Block->Command[0] = Ioctl::DI_ClosePartition << 24;
 
-	Unlock();
+	int Ret = Send(Ioctl::DI_ClosePartition, Block);
+
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_ClosePartition)";
+	if (Ret == 1) Partition = 0;
+
+	Planner.Reset();
 
 	return ((Ret == 1)? 0 : -Ret);
 }
@@ -437,6 +699,9 @@ int DIP::Close_Partition()
 /*******************************************************************************
  * Stop_Motor: Stops the drives motor.  Will require a reset to resume operation
  * -----------------------------------------------------------------------------
+ * With an idle timeout, the stop is sent by Idle once the drive has been idle
+ * that long, and dropped if a command comes first.
+ *
  * Return Values:
  *	returns result of Ioctl command
  *
@@ -444,17 +709,413 @@ int DIP::Close_Partition()
 
 int DIP::Stop_Motor()
 {
-	Command[0] = Ioctl::DI_StopMotor << 24;
-	Command[1] = 0;		// Set this to 1 to eject the disc
-	Command[2] = 0;		// This will temporarily kill the drive if set!!!
+	if (Spin.Defer_Stop()) return 0;
 
-	Lock();
+	return Send_Stop();
+}
 
-	int Ret = IOS_Ioctl(Device_Handle, Ioctl::DI_StopMotor, Command, 0x20, Output, 0x20);
+/*******************************************************************************
+ * Idle: Send a deferred stop once the idle timeout has passed
+ * -----------------------------------------------------------------------------
+ * Called by the main loop while nothing else uses the drive.
+ *
+ * Return Values:
+ *	returns true if the motor was stopped
+ *
+ ******************************************************************************/
 
-	Unlock();
+bool DIP::Idle()
+{
+	if (Device_Handle < 0 || !Spin.Stop_Due()) return false;
+
+	return (Send_Stop() == 0);
+}
+
+/*******************************************************************************
+ * Flush_Stop: Send a deferred stop now
+ * -----------------------------------------------------------------------------
+ * Called before the loader exits, Idle won't be called anymore.
+ *
+ * Return Values:
+ *	returns result of Ioctl command, 0 if there was nothing to send
+ *
+ ******************************************************************************/
+
+int DIP::Flush_Stop()
+{
+	if (Device_Handle < 0 || !Spin.Stop_Deferred()) return 0;
+
+	return Send_Stop();
+}
+
+/*******************************************************************************
+ * Send_Stop: Send DI_StopMotor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns result of Ioctl command
+ *
+ ******************************************************************************/
+
+int DIP::Send_Stop()
+{
+	// Before the block is taken, so the stop isn't counted as a command that came first
+	Spin.Stopped();
+
+	Request* Block = Acquire();
+
+	Block->Command[0] = Ioctl::DI_StopMotor << 24;
+	Block->Command[1] = 0;		// Set this to 1 to eject the disc
+	Block->Command[2] = 0;		// This will temporarily kill the drive if set!!!
+
+	int Ret = Send(Ioctl::DI_StopMotor, Block);
+
+	Release(Block);
 
 	if (Ret == 2) throw "Ioctl error (DI_StopMotor)";
 
 	return ((Ret == 1) ? 0 : -Ret);
 }
+
+
+/*******************************************************************************
+ * Read_Async: Queue a read from the disc into a buffer
+ * -----------------------------------------------------------------------------
+ * The read owns its command block until Wait_Read, so other commands can be
+ * issued meanwhile.  Only one read is tracked; Wait_Read must be called before
+ * the buffer is touched or another read is queued.
+ *
+ * Return Values:
+ *	returns result of IOS_IoctlAsync
+ *
+ ******************************************************************************/
+
+int DIP::Read_Async(void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (!Buffer) throw "Null Buffer";
+	if (reinterpret_cast<unsigned long>(Buffer) & 0x1f) throw "Buffer alignment error";
+	if (Pending_Read) throw "Asynchronous read already pending";
+
+	Request* Block = Acquire();
+
+	Block->Command[0] = Ioctl::DI_Read << 24;
+	Block->Command[1] = size;
+	Block->Command[2] = offset >> 2;
+
+	Block->Issued = gettime();
+
+	int Ret = IOS_IoctlAsync(Device_Handle, Ioctl::DI_Read, Block->Command, 0x20, Buffer, size, Async_Callback, Block);
+
+	if (Ret < 0)
+	{
+		Stats.Record(Ioctl::DI_Read, Ret, 0, Block->Issued, gettime());
+		Release(Block);
+		throw "Ioctl error (DI_Read)";
+	}
+
+	Pending_Read = Block;
+	return 0;
+}
+
+/*******************************************************************************
+ * Queue_Read: Read from the prefetched extents or through the planner, or
+ * queue the read if neither can help
+ * -----------------------------------------------------------------------------
+ * A read whose extents aren't staged yet is finished by Wait_Read.
+ *
+ * Return Values:
+ *	returns 0 if the data is in place or the read was queued
+ *
+ ******************************************************************************/
+
+int DIP::Queue_Read(void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (Deferred_Buffer) throw "Asynchronous read already pending";
+
+	Prefetch.Record(offset, size);
+
+	int First;
+	int Last = Prefetch.Find(offset, size, &First);
+
+	if (Last >= 0)
+	{
+		Deferred_Buffer	= Buffer;
+		Deferred_Size	= size;
+		Deferred_Offset	= offset;
+
+		if (Prefetch.Ready(First, Last)) return Prefetch_Serve();
+
+		Prefetch_Issue();
+		return 0;
+	}
+
+	if (Planner.Serve(Buffer, size, offset)) return 0;
+
+	return Read_Async(Buffer, size, offset);
+}
+
+/*******************************************************************************
+ * Wait_Read: Block until the queued read has completed
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns result of Ioctl command
+ *
+ ******************************************************************************/
+
+int DIP::Wait_Read()
+{
+	if (Deferred_Buffer) return Prefetch_Serve();
+	if (!Pending_Read) return -1;
+
+	Request* Block = Pending_Read;
+	Pending_Read = 0;
+
+	LWP_SemWait(Block->Done);
+
+	// Drive latency, not counting the time the read overlapped other work
+	int Ret = Block->Result;
+	Stats.Record(Ioctl::DI_Read, Ret, Block->Command[1], Block->Issued, Block->Completed);
+	Release(Block);
+
+	if (Planner.Staging()) return Planner.Complete(Ret == 1);
+	if (Ret == 2) throw "Ioctl error (DI_Read)";
+
+	return ((Ret == 1) ? 0 : -Ret);
+}
+
+/*******************************************************************************
+ * Read_Pending: Check for a queued read
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	true if an asynchronous or deferred read has not been waited for yet
+ *
+ ******************************************************************************/
+
+bool DIP::Read_Pending()
+{
+	return (Pending_Read != 0 || Deferred_Buffer != 0);
+}
+
+/*******************************************************************************
+ * Load_Plan: Start staging the sections the last boot of the disc read
+ * -----------------------------------------------------------------------------
+ * Needs the partition opened.  The reads queued from here on are recorded
+ * as the plan for the next boot.
+ *
+ * Return Values:
+ *	returns true if extents are being read
+ *
+ ******************************************************************************/
+
+bool DIP::Load_Plan(const char* Path, const dvddiskid* Disc_ID)
+{
+	Prefetch_Stop();
+
+	if (!Prefetch.Load(Path, (const byte*)Disc_ID)) return false;
+
+	Prefetch_Issue();
+	return true;
+}
+
+/*******************************************************************************
+ * Save_Plan: Stop staging, and keep the reads of this boot for the next one
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns false if the plan couldn't be written
+ *
+ ******************************************************************************/
+
+bool DIP::Save_Plan(const char* Path)
+{
+	Prefetch_Stop();
+
+	return Prefetch.Save(Path);
+}
+
+/*******************************************************************************
+ * Prefetch_Issue: Keep up to Max_Prefetch extents being read
+ * -----------------------------------------------------------------------------
+ * Extents are read in disc order, into the staging area.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void DIP::Prefetch_Issue()
+{
+	while (Prefetch_Count < Max_Prefetch)
+	{
+		Prefetch_Plan::Extent* Entry = Prefetch.Next_Extent();
+		if (!Entry) return;
+
+		Request* Block = Acquire();
+
+		Block->Command[0] = Ioctl::DI_Read << 24;
+		Block->Command[1] = Entry->Length;
+		Block->Command[2] = Entry->Start >> 2;
+
+		Block->Issued = gettime();
+
+		int Ret = IOS_IoctlAsync(Device_Handle, Ioctl::DI_Read, Block->Command, 0x20, Prefetch.Data(Entry), Entry->Length, Async_Callback, Block);
+
+		if (Ret < 0)
+		{
+			Stats.Record(Ioctl::DI_Read, Ret, 0, Block->Issued, gettime());
+			Release(Block);
+			Entry->Status = Prefetch_Plan::Extent_Failed;
+			continue;
+		}
+
+		Entry->Status = Prefetch_Plan::Extent_Reading;
+
+		Prefetching[Prefetch_Count]	= Block;
+		Prefetched[Prefetch_Count]	= Entry;
+		Prefetch_Count++;
+	}
+}
+
+/*******************************************************************************
+ * Prefetch_Wait: Block until the oldest extent being read has arrived
+ * -----------------------------------------------------------------------------
+ * An extent that couldn't be read is only marked; its sections are read
+ * directly when the apploader asks for them.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void DIP::Prefetch_Wait()
+{
+	if (!Prefetch_Count) return;
+
+	Request*				Block = Prefetching[0];
+	Prefetch_Plan::Extent*	Entry = Prefetched[0];
+
+	Prefetch_Count--;
+	for (unsigned int i = 0; i < Prefetch_Count; i++)
+	{
+		Prefetching[i]	= Prefetching[i + 1];
+		Prefetched[i]	= Prefetched[i + 1];
+	}
+
+	LWP_SemWait(Block->Done);
+
+	int Ret = Block->Result;
+	Stats.Record(Ioctl::DI_Read, Ret, Block->Command[1], Block->Issued, Block->Completed);
+	Release(Block);
+
+	if (Ret != 1)
+	{
+		Entry->Status = Prefetch_Plan::Extent_Failed;
+		return;
+	}
+
+	Entry->Status = Prefetch_Plan::Extent_Ready;
+	Prefetch.Reads++;
+	Prefetch.Staged_Bytes += Entry->Length;
+}
+
+/*******************************************************************************
+ * Prefetch_Serve: Finish the deferred read
+ * -----------------------------------------------------------------------------
+ * Waits for its extents, then copies it out of the staging area, or reads
+ * it directly if they couldn't be staged.
+ *
+ * Return Values:
+ *	returns result of the read
+ *
+ ******************************************************************************/
+
+int DIP::Prefetch_Serve()
+{
+	void*			Buffer	= Deferred_Buffer;
+	unsigned int	Size	= Deferred_Size;
+	unsigned int	Offset	= Deferred_Offset;
+
+	Deferred_Buffer = 0;
+
+	int First;
+	int Last = Prefetch.Find(Offset, Size, &First);
+
+	while (Last >= 0 && !Prefetch.Ready(First, Last) && !Prefetch.Failed(First, Last))
+	{
+		Prefetch_Issue();
+		if (!Prefetch_Count) break;
+
+		Prefetch_Wait();
+	}
+
+	// The drive moves on to the next extents while the section is used
+	Prefetch_Issue();
+
+	if (Last >= 0 && Prefetch.Ready(First, Last))
+	{
+		Prefetch.Copy(Buffer, Size, Offset, First);
+		return 0;
+	}
+
+	return Read(Buffer, Size, Offset);
+}
+
+/*******************************************************************************
+ * Prefetch_Stop: Wait for the extents being read and drop the staged data
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void DIP::Prefetch_Stop()
+{
+	if (Deferred_Buffer) Prefetch_Serve();
+
+	while (Prefetch_Count) Prefetch_Wait();
+
+	Prefetch.Reset();
+}
+
+/*******************************************************************************
+ * Async_Callback: IPC completion handler for asynchronous commands
+ * -----------------------------------------------------------------------------
+ * Runs in interrupt context, so it only records the result in the command
+ * block and wakes its owner.
+ *
+ * Return Values:
+ *	returns 0
+ *
+ ******************************************************************************/
+
+s32 DIP::Async_Callback(s32 Result, void* Userdata)
+{
+	Request* Block = (Request*)Userdata;
+
+	Block->Result = Result;
+	Block->Completed = gettime();
+	LWP_SemPost(Block->Done);
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Log_Statistics: Write the cache and planner counters to the log
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void DIP::Log_Statistics()
+{
+	Logger* Log = Logger::Instance();
+
+	Log->Write("Cluster cache: %u hits, %u misses\r\n", Cache.Hits, Cache.Misses);
+	Log->Write("Read planner: %u sections, %u ioctls saved\r\n", Planner.Requests, Planner.Saved);
+	Log->Write("Bounce buffer: %u bytes copied\r\n", Bounced);
+	Log->Write("Drive motor: %u spin-ups, %u avoided, %u resets skipped, %u stops sent\r\n",
+		Spin.Spin_Ups, Spin.Spin_Ups_Avoided, Spin.Resets_Skipped, Spin.Stops);
+	Log->Write("Prefetch plan: %s, %u of %u planned sections served, %u bytes staged in %u reads\r\n",
+		Prefetch.Status, Prefetch.Served, Prefetch.Planned, Prefetch.Staged_Bytes, Prefetch.Reads);
+
+	Stats.Log();
+}
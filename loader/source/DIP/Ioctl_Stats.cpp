@@ -0,0 +1,228 @@
+/*******************************************************************************
+ * Ioctl_Stats.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class that keeps per-command counters and
+ *	latency histograms for the /dev/di ioctls
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+#include <string.h>
+#include <ogc/lwp_watchdog.h>
+
+#include "Ioctl_Stats.h"
+#include "Ioctl.h"
+#include "Logger.h"
+
+//--------------------------------------
+// Command names
+
+namespace
+{
+	struct Command_Name
+	{
+		int			Command;
+		const char*	Name;
+	};
+
+	const Command_Name Names[Ioctl_Stats::Commands] =
+	{
+		{ Ioctl::DI_Inquiry,			"DI_Inquiry" },
+		{ Ioctl::DI_ReadID,				"DI_ReadID" },
+		{ Ioctl::DI_Read,				"DI_Read" },
+		{ Ioctl::DI_WaitCoverClose,		"DI_WaitCoverClose" },
+		{ Ioctl::DI_Reset,				"DI_Reset" },
+		{ Ioctl::DI_OpenPartition,		"DI_OpenPartition" },
+		{ Ioctl::DI_ClosePartition,		"DI_ClosePartition" },
+		{ Ioctl::DI_ReadUnencrypted,	"DI_ReadUnencrypted" },
+		{ Ioctl::DI_VerifyCover,		"DI_VerifyCover" },
+		{ Ioctl::DI_StopMotor,			"DI_StopMotor" },
+		{ Ioctl::DI_EnableDVD,			"DI_EnableDVD" },
+		{ Ioctl::DI_SetOffsetBase,		"DI_SetOffsetBase" },
+		{ Ioctl::DI_GetOffsetBase,		"DI_GetOffsetBase" }
+	};
+}
+
+//--------------------------------------
+// Ioctl_Stats Class
+
+/*******************************************************************************
+ * Ioctl_Stats: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Ioctl_Stats::Ioctl_Stats()
+{
+	Reset();
+}
+
+/*******************************************************************************
+ * ~Ioctl_Stats: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Ioctl_Stats::~Ioctl_Stats() {}
+
+/*******************************************************************************
+ * Reset: Clear all counters
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Ioctl_Stats::Reset()
+{
+	memset(Table, 0, sizeof(Table));
+
+	for (int i = 0; i < Commands; i++)
+	{
+		Table[i].Name		= Names[i].Name;
+		Table[i].Command	= Names[i].Command;
+	}
+}
+
+/*******************************************************************************
+ * Lookup: Find the counters of a command
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the counters, 0 for a command that isn't tracked
+ *
+ ******************************************************************************/
+
+Ioctl_Stats::Counters* Ioctl_Stats::Lookup(int Command)
+{
+	for (int i = 0; i < Commands; i++)
+	{
+		if (Table[i].Command == Command) return &Table[i];
+	}
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Find: Counters of a command, for callers outside the DIP class
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the counters, 0 for a command that isn't tracked
+ *
+ ******************************************************************************/
+
+const Ioctl_Stats::Counters* Ioctl_Stats::Find(int Command) const
+{
+	return const_cast<Ioctl_Stats*>(this)->Lookup(Command);
+}
+
+/*******************************************************************************
+ * Get: Counters by position, to walk all commands
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the counters, 0 past the last command
+ *
+ ******************************************************************************/
+
+const Ioctl_Stats::Counters* Ioctl_Stats::Get(unsigned int Index) const
+{
+	return (Index < Commands) ? &Table[Index] : 0;
+}
+
+/*******************************************************************************
+ * Bucket_Limit: Upper latency bound of a histogram bucket
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the bound in us, 0 for the last (open) bucket
+ *
+ ******************************************************************************/
+
+unsigned int Ioctl_Stats::Bucket_Limit(unsigned int Bucket)
+{
+	return (Bucket + 1 < Buckets) ? (16u << Bucket) : 0;
+}
+
+/*******************************************************************************
+ * Record: Account one completed command
+ * -----------------------------------------------------------------------------
+ * Result is what IOS returned: 1 is success, 2 a drive error and negative
+ * values IPC failures.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Ioctl_Stats::Record(int Command, int Result, unsigned int Bytes, u64 Start, u64 End)
+{
+	Counters* Entry = Lookup(Command);
+	if (!Entry) return;
+
+	unsigned int Time = (End > Start) ? (unsigned int)ticks_to_microsecs(End - Start) : 0;
+
+	unsigned int Bucket = 0;
+	while (Bucket + 1 < Buckets && Time >= Bucket_Limit(Bucket)) Bucket++;
+
+	Entry->Calls++;
+	Entry->Histogram[Bucket]++;
+	Entry->Total_Time += Time;
+
+	if (Time > Entry->Max_Time) Entry->Max_Time = Time;
+
+	if (Result == 1)	Entry->Bytes += Bytes;
+	else				Entry->Errors++;
+}
+
+/*******************************************************************************
+ * Log: Write the counters of every command used to the log
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Ioctl_Stats::Log() const
+{
+	Logger* Log = Logger::Instance();
+
+	for (int i = 0; i < Commands; i++)
+	{
+		const Counters* Entry = &Table[i];
+		if (!Entry->Calls) continue;
+
+		Log->Write("%s: %u calls, %u errors, %llu bytes, avg %llu us, max %u us\r\n",
+			Entry->Name, Entry->Calls, Entry->Errors, (unsigned long long)Entry->Bytes,
+			(unsigned long long)(Entry->Total_Time / Entry->Calls), Entry->Max_Time);
+
+		// One line of "<limit:count" pairs, empty buckets left out
+		char Line[256] = "";
+		int Length = 0;
+
+		for (int Bucket = 0; Bucket < Buckets; Bucket++)
+		{
+			if (!Entry->Histogram[Bucket]) continue;
+
+			unsigned int Limit = Bucket_Limit(Bucket);
+
+			if (Limit)	Length += snprintf(Line + Length, sizeof(Line) - Length, " <%uus:%u", Limit, Entry->Histogram[Bucket]);
+			else		Length += snprintf(Line + Length, sizeof(Line) - Length, " more:%u", Entry->Histogram[Bucket]);
+
+			if (Length >= (int)sizeof(Line)) break;
+		}
+
+		Log->Write("  latency%s\r\n", Line);
+	}
+}
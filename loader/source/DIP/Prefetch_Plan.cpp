@@ -0,0 +1,452 @@
+/*******************************************************************************
+ * Prefetch_Plan.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class that learns which sections the
+ *	apploader reads, and stages them ahead of it on the next boot
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+#include <string.h>
+#include <ogc/system.h>
+
+#include "Prefetch_Plan.h"
+#include "Storage.h"
+
+//--------------------------------------
+// Plan file
+
+namespace
+{
+	Prefetch_File::Record	Records[Prefetch_File::Max_Records];
+	dword					Record_Count;
+
+	void Swap_Record(Prefetch_File::Record* Entry)
+	{
+		Entry->Count = BE32(Entry->Count);
+
+		for (unsigned int i = 0; i < Prefetch_File::Max_Sections; i++)
+		{
+			Entry->Sections[i].Offset	= BE32(Entry->Sections[i].Offset);
+			Entry->Sections[i].Size		= BE32(Entry->Sections[i].Size);
+		}
+	}
+
+	// Reads every record into Records, in host byte order
+	bool Read_Records(const char* Path)
+	{
+		Prefetch_File::Header	Head;
+		FILE*					fp		= Storage::Instance()->OpenFile(Path, "rb");
+		bool					Result	= false;
+
+		Record_Count = 0;
+		if (fp == NULL) return false;
+
+		if (fread(&Head, 1, sizeof(Head), fp) == sizeof(Head)
+			&& memcmp(Head.Signature, Prefetch_File::Signature, sizeof(Head.Signature)) == 0
+			&& Head.Version == Prefetch_File::Version
+			&& BE32(Head.Count) <= Prefetch_File::Max_Records)
+		{
+			dword Count = BE32(Head.Count);
+
+			if (fread(Records, sizeof(Prefetch_File::Record), Count, fp) == Count)
+			{
+				for (dword i = 0; i < Count; i++)
+				{
+					Swap_Record(&Records[i]);
+					if (Records[i].Count > Prefetch_File::Max_Sections) Records[i].Count = 0;
+				}
+
+				Record_Count	= Count;
+				Result			= true;
+			}
+		}
+
+		fclose(fp);
+		return Result;
+	}
+
+	bool Write_Records(const char* Path)
+	{
+		FILE* fp = Storage::Instance()->OpenFile(Path, "wb");
+		if (fp == NULL) return false;
+
+		Prefetch_File::Header Head;
+		memset(&Head, 0, sizeof(Head));
+		memcpy(Head.Signature, Prefetch_File::Signature, sizeof(Head.Signature));
+
+		Head.Version	= Prefetch_File::Version;
+		Head.Count		= BE32(Record_Count);
+
+		bool Result = (fwrite(&Head, 1, sizeof(Head), fp) == sizeof(Head));
+
+		for (dword i = 0; Result && i < Record_Count; i++)
+		{
+			Prefetch_File::Record Entry = Records[i];
+			Swap_Record(&Entry);
+
+			Result = (fwrite(&Entry, 1, sizeof(Entry), fp) == sizeof(Entry));
+		}
+
+		return (fclose(fp) == 0) && Result;
+	}
+}
+
+//--------------------------------------
+// Prefetch_Plan Class
+
+/*******************************************************************************
+ * Prefetch_Plan: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Prefetch_Plan::Prefetch_Plan()
+{
+	Staging		= 0;
+	Known		= false;
+	Status		= "not loaded";
+	Planned		= 0;
+	Served		= 0;
+	Reads		= 0;
+	Staged_Bytes = 0;
+
+	memset(&Loaded, 0, sizeof(Loaded));
+	memset(&Current, 0, sizeof(Current));
+	Reset();
+}
+
+/*******************************************************************************
+ * ~Prefetch_Plan: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Prefetch_Plan::~Prefetch_Plan() {}
+
+/*******************************************************************************
+ * Reset: Forget the staged data
+ * -----------------------------------------------------------------------------
+ * Must be called whenever the partition changes, once no extent is being
+ * read.  The plan and the reads recorded so far are kept.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Prefetch_Plan::Reset()
+{
+	Extent_Count	= 0;
+	Next			= 0;
+}
+
+/*******************************************************************************
+ * Load: Start a boot of a disc with the plan its last boot left
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if there are extents to read
+ *
+ ******************************************************************************/
+
+bool Prefetch_Plan::Load(const char* Path, const byte* ID)
+{
+	memcpy(Disc_ID, ID, sizeof(Disc_ID));
+	Known = true;
+
+	Reset();
+	Loaded.Count	= 0;
+	Current.Count	= 0;
+	Planned			= 0;
+	Served			= 0;
+	Reads			= 0;
+	Staged_Bytes	= 0;
+
+	if (!Read_Records(Path))
+	{
+		Status = "not found";
+		return false;
+	}
+
+	for (dword i = 0; i < Record_Count && !Loaded.Count; i++)
+	{
+		if (memcmp(Records[i].Disc_ID, Disc_ID, sizeof(Disc_ID)) == 0) Loaded = Records[i];
+	}
+
+	if (!Loaded.Count)
+	{
+		Status = "no plan for the disc";
+		return false;
+	}
+
+	if (!Staging) Staging = (byte*)SYS_AllocArena2MemLo(Staging_Size, 0x20);
+
+	if (!Staging)
+	{
+		Status = "no staging memory";
+		return false;
+	}
+
+	Build();
+
+	Status = "used";
+	return (Extent_Count != 0);
+}
+
+/*******************************************************************************
+ * Build: Turn the loaded plan into extents
+ * -----------------------------------------------------------------------------
+ * Sections are sorted by disc offset and merged across small gaps, so the
+ * drive sweeps the partition once.  Long extents are split so the first
+ * sections are staged early.  What doesn't fit the staging area is read
+ * when the apploader asks for it.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Prefetch_Plan::Build()
+{
+	Prefetch_File::Section	Sorted[Prefetch_File::Max_Sections];
+	unsigned int			Count = 0;
+
+	for (dword i = 0; i < Loaded.Count; i++)
+	{
+		Prefetch_File::Section Entry = Loaded.Sections[i];
+		if (!Entry.Size || (Entry.Offset & 3)) continue;
+
+		unsigned int j = Count++;
+		for (; j > 0 && Sorted[j - 1].Offset > Entry.Offset; j--) Sorted[j] = Sorted[j - 1];
+		Sorted[j] = Entry;
+	}
+
+	dword Used = 0;
+
+	for (unsigned int i = 0; i < Count; )
+	{
+		dword Start	= Sorted[i].Offset;
+		dword End	= Start + Sorted[i].Size;
+
+		for (i++; i < Count && Sorted[i].Offset <= End + Max_Gap; i++)
+		{
+			if (Sorted[i].Offset + Sorted[i].Size > End) End = Sorted[i].Offset + Sorted[i].Size;
+		}
+
+		dword Length = (End - Start + 0x1f) & ~0x1f;
+		if (Used + Length > Staging_Size) continue;
+
+		for (dword Done = 0; Done < Length; Done += Max_Transfer)
+		{
+			Extent* Entry = &Extents[Extent_Count++];
+
+			Entry->Start	= Start + Done;
+			Entry->Length	= (Length - Done < Max_Transfer) ? Length - Done : (dword)Max_Transfer;
+			Entry->Staging	= Used + Done;
+			Entry->Status	= Extent_Idle;
+		}
+
+		Used += Length;
+	}
+
+	int First;
+
+	for (unsigned int i = 0; i < Count; i++)
+	{
+		if (Find(Sorted[i].Offset, Sorted[i].Size, &First) >= 0) Planned++;
+	}
+}
+
+/*******************************************************************************
+ * Save: Remember the reads of this boot as the disc's plan
+ * -----------------------------------------------------------------------------
+ * The file is only rewritten when the reads differ from the plan, so a disc
+ * booted as planned doesn't cost an SD write.  The disc's record moves to
+ * the front; the last one is dropped when the file is full.
+ *
+ * Return Values:
+ *	returns false if the file couldn't be written
+ *
+ ******************************************************************************/
+
+bool Prefetch_Plan::Save(const char* Path)
+{
+	if (!Known || !Current.Count) return true;
+
+	memcpy(Current.Disc_ID, Disc_ID, sizeof(Disc_ID));
+
+	if (Current.Count == Loaded.Count
+		&& memcmp(Current.Sections, Loaded.Sections, Current.Count * sizeof(Prefetch_File::Section)) == 0) return true;
+
+	Read_Records(Path);
+
+	// Drop the disc's old record, then shift the rest down to make room at the front
+	dword Kept = 0;
+
+	for (dword i = 0; i < Record_Count; i++)
+	{
+		if (memcmp(Records[i].Disc_ID, Disc_ID, sizeof(Disc_ID)) == 0) continue;
+		Records[Kept++] = Records[i];
+	}
+
+	if (Kept == Prefetch_File::Max_Records) Kept--;
+
+	memmove(&Records[1], &Records[0], Kept * sizeof(Prefetch_File::Record));
+	Records[0]		= Current;
+	Record_Count	= Kept + 1;
+
+	Loaded = Current;
+
+	return Write_Records(Path);
+}
+
+/*******************************************************************************
+ * Record: Note a read of the apploader
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Prefetch_Plan::Record(unsigned int Offset, unsigned int Size)
+{
+	if (Current.Count >= Prefetch_File::Max_Sections) return;
+
+	Current.Sections[Current.Count].Offset	= Offset;
+	Current.Sections[Current.Count].Size	= Size;
+	Current.Count++;
+}
+
+/*******************************************************************************
+ * Next_Extent: Take the next extent to read, in disc order
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the extent, or 0 once every extent was taken
+ *
+ ******************************************************************************/
+
+Prefetch_Plan::Extent* Prefetch_Plan::Next_Extent()
+{
+	if (Next >= Extent_Count) return 0;
+
+	return &Extents[Next++];
+}
+
+/*******************************************************************************
+ * Find: Look for the extents holding a read
+ * -----------------------------------------------------------------------------
+ * A read may span several extents of a split one; they are contiguous on
+ * the disc and in the staging area.
+ *
+ * Return Values:
+ *	returns the index of the last extent, -1 if the read isn't planned;
+ *	First is set to the index of the first one
+ *
+ ******************************************************************************/
+
+int Prefetch_Plan::Find(unsigned int Offset, unsigned int Size, int* First)
+{
+	if (!Size) return -1;
+
+	for (unsigned int i = 0; i < Extent_Count; i++)
+	{
+		if (Offset < Extents[i].Start || Offset - Extents[i].Start >= Extents[i].Length) continue;
+
+		unsigned int Last = i;
+
+		while (Offset + Size > Extents[Last].Start + Extents[Last].Length)
+		{
+			if (Last + 1 >= Extent_Count) return -1;
+
+			const Extent* Following = &Extents[Last + 1];
+			if (Following->Start != Extents[Last].Start + Extents[Last].Length) return -1;
+			if (Following->Staging != Extents[Last].Staging + Extents[Last].Length) return -1;
+
+			Last++;
+		}
+
+		*First = i;
+		return Last;
+	}
+
+	return -1;
+}
+
+/*******************************************************************************
+ * Ready: Check that extents were staged
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if every extent from First to Last was read successfully
+ *
+ ******************************************************************************/
+
+bool Prefetch_Plan::Ready(int First, int Last)
+{
+	for (int i = First; i <= Last; i++)
+	{
+		if (Extents[i].Status != Extent_Ready) return false;
+	}
+
+	return true;
+}
+
+/*******************************************************************************
+ * Failed: Check for extents that couldn't be read
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if a read of an extent from First to Last failed
+ *
+ ******************************************************************************/
+
+bool Prefetch_Plan::Failed(int First, int Last)
+{
+	for (int i = First; i <= Last; i++)
+	{
+		if (Extents[i].Status == Extent_Failed) return true;
+	}
+
+	return false;
+}
+
+/*******************************************************************************
+ * Copy: Serve a read out of the staging area
+ * -----------------------------------------------------------------------------
+ * The extents holding it must be Ready.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Prefetch_Plan::Copy(void* Buffer, unsigned int Size, unsigned int Offset, int First)
+{
+	memcpy(Buffer, Data(&Extents[First]) + (Offset - Extents[First].Start), Size);
+	Served++;
+}
+
+/*******************************************************************************
+ * Data: Where an extent is staged
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the start of its data in MEM2
+ *
+ ******************************************************************************/
+
+byte* Prefetch_Plan::Data(const Extent* Entry)
+{
+	return Staging + Entry->Staging;
+}
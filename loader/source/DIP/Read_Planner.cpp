@@ -0,0 +1,163 @@
+/*******************************************************************************
+ * Read_Planner.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class that coalesces small sequential
+ *	partition reads into larger transfers
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+#include <ogc/system.h>
+
+#include "Read_Planner.h"
+#include "DIP.h"
+
+//--------------------------------------
+// Read_Planner Class
+
+/*******************************************************************************
+ * Read_Planner: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Read_Planner::Read_Planner()
+{
+	Window			= 0;
+	Staged_Address	= 0;
+	Staged_Size		= 0;
+
+	Reset();
+}
+
+/*******************************************************************************
+ * ~Read_Planner: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Read_Planner::~Read_Planner() {}
+
+/*******************************************************************************
+ * Initialize: Reserve the staging window in MEM2
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	true if the planner can coalesce reads
+ *
+ ******************************************************************************/
+
+bool Read_Planner::Initialize()
+{
+	if (!Window) Window = (byte*)SYS_AllocArena2MemLo(Window_Size, 0x20);
+	return (Window != 0);
+}
+
+/*******************************************************************************
+ * Reset: Forget the staged data and clear the counters
+ * -----------------------------------------------------------------------------
+ * Must be called whenever the partition or offset base changes.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Read_Planner::Reset()
+{
+	Requests		= 0;
+	Saved			= 0;
+	Window_Start	= 0;
+	Window_Length	= 0;
+	Last_End		= 0xffffffff;
+}
+
+/*******************************************************************************
+ * Serve: Satisfy a partition read from the staging window
+ * -----------------------------------------------------------------------------
+ * A small request that continues right where the previous one ended starts a
+ * sequential run, so the window is refilled from its offset and the following
+ * requests of the run are copied out of it without touching the drive.  The
+ * refill is queued with Read_Async; Complete copies the request out of it once
+ * Wait_Read has it.
+ *
+ * Return Values:
+ *	true if the data is in place or queued, false if the caller has to read it
+ *
+ ******************************************************************************/
+
+bool Read_Planner::Serve(void* Address, unsigned int Size, unsigned int Offset)
+{
+	bool Sequential	= (Offset == Last_End);
+
+	Requests++;
+	Last_End = Offset + Size;
+
+	// Already staged
+	if (Window_Length > 0 && Offset >= Window_Start && Offset + Size <= Window_Start + Window_Length)
+	{
+		memcpy(Address, Window + (Offset - Window_Start), Size);
+		Saved++;
+		return true;
+	}
+
+	if (!Window || !Sequential || Size > Max_Small_Read) return false;
+
+	// Stage the rest of the run with a single transfer
+	Window_Length = 0;
+	if (DIP::Instance()->Read_Async(Window, Window_Size, Offset) < 0) return false;
+
+	Window_Start	= Offset;
+	Staged_Address	= Address;
+	Staged_Size		= Size;
+
+	return true;
+}
+
+/*******************************************************************************
+ * Staging: Check for a refill queued by Serve
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	true if the read Wait_Read waits for is the window's
+ *
+ ******************************************************************************/
+
+bool Read_Planner::Staging() const
+{
+	return (Staged_Address != 0);
+}
+
+/*******************************************************************************
+ * Complete: Finish the request that queued the refill
+ * -----------------------------------------------------------------------------
+ * If the window couldn't be read, the request is read on its own.
+ *
+ * Return Values:
+ *	returns 0 if the data is in place, or the result of the read
+ *
+ ******************************************************************************/
+
+int Read_Planner::Complete(bool Success)
+{
+	void* Address = Staged_Address;
+	Staged_Address = 0;
+
+	if (!Success) return DIP::Instance()->Read(Address, Staged_Size, Window_Start);
+
+	Window_Length = Window_Size;
+	memcpy(Address, Window, Staged_Size);
+	return 0;
+}
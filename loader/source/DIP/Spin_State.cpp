@@ -0,0 +1,247 @@
+/*******************************************************************************
+ * Spin_State.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class that keeps track of the drive's motor
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <ogc/lwp_watchdog.h>
+
+#include "Spin_State.h"
+
+//--------------------------------------
+// Spin_State Class
+
+/*******************************************************************************
+ * Spin_State: Default constructor
+ * -----------------------------------------------------------------------------
+ * The motor's state at start up is unknown, it's taken as stopped.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Spin_State::Spin_State()
+{
+	Idle_Timeout		= 0;
+	Spin_Ups			= 0;
+	Spin_Ups_Avoided	= 0;
+	Resets_Skipped		= 0;
+	Stops				= 0;
+	Motor				= false;
+	Ready				= false;
+	Stop_Pending		= false;
+	Skipped				= false;
+	Reset_IOS			= -1;
+	Last_Access			= 0;
+}
+
+/*******************************************************************************
+ * ~Spin_State: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Spin_State::~Spin_State() {}
+
+/*******************************************************************************
+ * Access: Note a command
+ * -----------------------------------------------------------------------------
+ * A deferred stop is dropped, the drive would have been spun up again.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Spin_State::Access()
+{
+	Last_Access = gettime();
+
+	if (Stop_Pending)
+	{
+		Stop_Pending = false;
+		Spin_Ups_Avoided++;
+	}
+}
+
+/*******************************************************************************
+ * Reset: Note a reset, which spins the drive up
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Spin_State::Reset(int IOS)
+{
+	if (!Motor) Spin_Ups++;
+
+	Motor		= true;
+	Ready		= false;
+	Skipped		= false;
+	Reset_IOS	= IOS;
+}
+
+/*******************************************************************************
+ * Identified: Note the disc ID was read
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Spin_State::Identified()
+{
+	if (Motor) Ready = true;
+}
+
+/*******************************************************************************
+ * Removed: Note there's no disc, or a new one may have been inserted
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Spin_State::Removed()
+{
+	Motor			= false;
+	Ready			= false;
+	Stop_Pending	= false;
+}
+
+/*******************************************************************************
+ * Stopped: Note the motor was stopped
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Spin_State::Stopped()
+{
+	Stops++;
+
+	Motor			= false;
+	Ready			= false;
+	Stop_Pending	= false;
+}
+
+/*******************************************************************************
+ * Closed: Note the handle was closed
+ * -----------------------------------------------------------------------------
+ * Every IOS reload goes through it, and a freshly booted IOS needs a reset
+ * even if its version is the one the drive was reset under.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Spin_State::Closed()
+{
+	Ready = false;
+}
+
+/*******************************************************************************
+ * Skip_Reset: Check whether a reset is needed
+ * -----------------------------------------------------------------------------
+ * A new IOS has to see a reset before it reads the disc; Closed makes sure of
+ * that, the IOS version is only checked as well.
+ *
+ * Return Values:
+ *	returns true if the same disc spins, identified under the same IOS
+ *
+ ******************************************************************************/
+
+bool Spin_State::Skip_Reset(int IOS)
+{
+	if (!Motor || !Ready || IOS != Reset_IOS) return false;
+
+	Resets_Skipped++;
+	Skipped = true;
+	return true;
+}
+
+/*******************************************************************************
+ * Defer_Stop: Leave a stop to the idle timeout
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if deferred, false if it should be sent now
+ *
+ ******************************************************************************/
+
+bool Spin_State::Defer_Stop()
+{
+	if (!Idle_Timeout) return false;
+
+	Stop_Pending	= true;
+	Last_Access		= gettime();
+	return true;
+}
+
+/*******************************************************************************
+ * Stop_Due: Check the deferred stop
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the drive was idle for Idle_Timeout since it was deferred
+ *
+ ******************************************************************************/
+
+bool Spin_State::Stop_Due()
+{
+	return (Stop_Pending && diff_msec(Last_Access, gettime()) >= Idle_Timeout);
+}
+
+/*******************************************************************************
+ * Stop_Deferred: Check for a deferred stop
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if a stop is waiting for the idle timeout
+ *
+ ******************************************************************************/
+
+bool Spin_State::Stop_Deferred() const
+{
+	return Stop_Pending;
+}
+
+/*******************************************************************************
+ * Spinning: Check the motor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the motor is known to spin
+ *
+ ******************************************************************************/
+
+bool Spin_State::Spinning() const
+{
+	return Motor;
+}
+
+/*******************************************************************************
+ * Reset_Skipped: Check how the last reset went
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if it was skipped
+ *
+ ******************************************************************************/
+
+bool Spin_State::Reset_Skipped() const
+{
+	return Skipped;
+}
@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * AES.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of an AES-128 CBC decryptor (FIPS-197)
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+
+#include "AES.h"
+
+//--------------------------------------
+// AES Class
+
+bool AES::Tables_Ready = false;
+byte AES::Sbox[256];
+byte AES::Inv_Sbox[256];
+byte AES::Mul9[256];
+byte AES::Mul11[256];
+byte AES::Mul13[256];
+byte AES::Mul14[256];
+
+static byte Multiply(byte a, byte b)
+{
+	byte Result = 0;
+
+	while (b)
+	{
+		if (b & 1) Result ^= a;
+		a = (byte)((a << 1) ^ ((a & 0x80) ? 0x1b : 0));
+		b >>= 1;
+	}
+
+	return Result;
+}
+
+static inline byte Rotate(byte x, int n)
+{
+	return (byte)((x << n) | (x >> (8 - n)));
+}
+
+/*******************************************************************************
+ * AES: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+AES::AES()
+{
+	if (!Tables_Ready) Build_Tables();
+	memset(Round_Keys, 0, sizeof(Round_Keys));
+}
+
+/*******************************************************************************
+ * ~AES: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+AES::~AES() {}
+
+/*******************************************************************************
+ * Build_Tables: Generate the S-boxes and InvMixColumns products
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void AES::Build_Tables()
+{
+	byte p = 1, q = 1;
+
+	// Walk the multiplicative group with generator 3; q tracks the inverse of p
+	do
+	{
+		p = (byte)(p ^ (p << 1) ^ ((p & 0x80) ? 0x1b : 0));
+
+		q ^= (byte)(q << 1);
+		q ^= (byte)(q << 2);
+		q ^= (byte)(q << 4);
+		if (q & 0x80) q ^= 0x09;
+
+		byte x = (byte)(q ^ Rotate(q, 1) ^ Rotate(q, 2) ^ Rotate(q, 3) ^ Rotate(q, 4));
+		Sbox[p] = x ^ 0x63;
+	}
+	while (p != 1);
+
+	Sbox[0] = 0x63;
+
+	for (int i = 0; i < 256; i++)
+	{
+		Inv_Sbox[Sbox[i]]	= (byte)i;
+		Mul9[i]				= Multiply((byte)i, 9);
+		Mul11[i]			= Multiply((byte)i, 11);
+		Mul13[i]			= Multiply((byte)i, 13);
+		Mul14[i]			= Multiply((byte)i, 14);
+	}
+
+	Tables_Ready = true;
+}
+
+/*******************************************************************************
+ * Set_Key: Expand a 128-bit key
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void AES::Set_Key(const byte* Key)
+{
+	byte Rcon = 1;
+
+	memcpy(Round_Keys, Key, 16);
+
+	for (int i = 16; i < 176; i += 4)
+	{
+		byte t[4];
+		memcpy(t, Round_Keys + i - 4, 4);
+
+		if (i % 16 == 0)
+		{
+			byte First = t[0];
+			t[0] = Sbox[t[1]] ^ Rcon;
+			t[1] = Sbox[t[2]];
+			t[2] = Sbox[t[3]];
+			t[3] = Sbox[First];
+
+			Rcon = (byte)((Rcon << 1) ^ ((Rcon & 0x80) ? 0x1b : 0));
+		}
+
+		for (int j = 0; j < 4; j++) Round_Keys[i + j] = Round_Keys[i + j - 16] ^ t[j];
+	}
+}
+
+/*******************************************************************************
+ * Decrypt_Block: Decrypt a single 16-byte block
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void AES::Decrypt_Block(const byte* In, byte* Out) const
+{
+	byte State[16], Temp[16];
+
+	for (int i = 0; i < 16; i++) State[i] = In[i] ^ Round_Keys[160 + i];
+
+	for (int Round = 9; Round >= 0; Round--)
+	{
+		// InvShiftRows and InvSubBytes
+		for (int c = 0; c < 4; c++)
+		{
+			for (int r = 0; r < 4; r++)
+			{
+				Temp[r + 4 * c] = Inv_Sbox[State[r + 4 * ((c - r + 4) & 3)]];
+			}
+		}
+
+		// AddRoundKey
+		for (int i = 0; i < 16; i++) Temp[i] ^= Round_Keys[Round * 16 + i];
+
+		if (Round == 0)
+		{
+			memcpy(State, Temp, 16);
+			break;
+		}
+
+		// InvMixColumns
+		for (int c = 0; c < 4; c++)
+		{
+			const byte* s = Temp + 4 * c;
+
+			State[4 * c + 0] = Mul14[s[0]] ^ Mul11[s[1]] ^ Mul13[s[2]] ^ Mul9[s[3]];
+			State[4 * c + 1] = Mul9[s[0]] ^ Mul14[s[1]] ^ Mul11[s[2]] ^ Mul13[s[3]];
+			State[4 * c + 2] = Mul13[s[0]] ^ Mul9[s[1]] ^ Mul14[s[2]] ^ Mul11[s[3]];
+			State[4 * c + 3] = Mul11[s[0]] ^ Mul13[s[1]] ^ Mul9[s[2]] ^ Mul14[s[3]];
+		}
+	}
+
+	memcpy(Out, State, 16);
+}
+
+/*******************************************************************************
+ * Decrypt: CBC-decrypt a buffer (In and Out may be the same buffer)
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void AES::Decrypt(const byte* IV, const byte* In, byte* Out, unsigned int size)
+{
+	byte Chain[16], Next[16];
+
+	memcpy(Chain, IV, 16);
+
+	for (unsigned int Pos = 0; Pos + 16 <= size; Pos += 16)
+	{
+		memcpy(Next, In + Pos, 16);
+		Decrypt_Block(In + Pos, Out + Pos);
+
+		for (int i = 0; i < 16; i++) Out[Pos + i] ^= Chain[i];
+
+		memcpy(Chain, Next, 16);
+	}
+}
@@ -0,0 +1,388 @@
+/*******************************************************************************
+ * Disc_Image.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a disc source reading a raw (1:1) Wii disc
+ *	image from a file
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+#include <sys/types.h>
+
+#include "Disc_Image.h"
+#include "Configuration.h"
+#include "Storage.h"
+
+//--------------------------------------
+// Partition header layout
+
+namespace Partition_Header
+{
+	const dword Title_Key		= 0x1bf;	// Encrypted title key (16 bytes)
+	const dword Title_ID		= 0x1dc;	// Title ID, IV for the title key (8 bytes)
+	const dword Key_Index		= 0x1f1;	// 0 = common key, 1 = korean key
+	const dword TMD_Size		= 0x2a4;
+	const dword TMD_Offset		= 0x2a8;	// >> 2
+	const dword Data_Offset		= 0x2b8;	// >> 2
+	const dword Data_Size		= 0x2bc;	// >> 2
+	const dword Size			= 0x2c0;
+}
+
+static inline dword Read_BE32(const byte* p)
+{
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+//--------------------------------------
+// Disc_Image Class
+
+/*******************************************************************************
+ * Disc_Image: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Disc_Image::Disc_Image()
+{
+	memset(Path, 0, sizeof(Path));
+
+	File			= NULL;
+	Offset_Base		= 0;
+	Partition_Open	= false;
+	Data_Offset		= 0;
+	Data_Size		= 0;
+	Cluster_Index	= ~0ULL;
+}
+
+/*******************************************************************************
+ * ~Disc_Image: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Disc_Image::~Disc_Image()
+{
+	Close();
+}
+
+/*******************************************************************************
+ * Open: Select the image file and open it
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	true if the image could be opened
+ *
+ ******************************************************************************/
+
+bool Disc_Image::Open(const char* Path)
+{
+	Close();
+
+	strncpy(this->Path, Path, sizeof(this->Path) - 1);
+	return Initialize();
+}
+
+/*******************************************************************************
+ * Initialize: (Re)open the image, e.g. after FAT was remounted
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	true on success, false on error
+ *
+ ******************************************************************************/
+
+bool Disc_Image::Initialize()
+{
+	if (File) return true;
+	if (!Path[0]) return false;
+
+	File = Storage::Instance()->OpenFile(Path, "rb");
+	return (File != NULL);
+}
+
+/*******************************************************************************
+ * Close: Close the image file
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Disc_Image::Close()
+{
+	if (File) fclose(File);
+
+	File			= NULL;
+	Offset_Base		= 0;
+	Partition_Open	= false;
+	Cluster_Index	= ~0ULL;
+}
+
+/*******************************************************************************
+ * Read_Raw: Read bytes from the image
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 0 on success, -1 on error
+ *
+ ******************************************************************************/
+
+int Disc_Image::Read_Raw(void* Buffer, unsigned int size, qword offset)
+{
+	if (!File) return -1;
+	if (fseeko(File, (off_t)offset, SEEK_SET) != 0) return -1;
+
+	return (fread(Buffer, 1, size, File) == size) ? 0 : -1;
+}
+
+/*******************************************************************************
+ * Read_DiscID: Read the disc identifier
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 0 on success, -1 on error
+ *
+ ******************************************************************************/
+
+int Disc_Image::Read_DiscID(dvddiskid* Disc_ID)
+{
+	if (!Disc_ID) throw "Null Disc_ID pointer";
+
+	return Read_Raw(Disc_ID, 0x20, 0);
+}
+
+/*******************************************************************************
+ * Read_Unencrypted: Read from the image into a buffer
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 0 on success, -1 on error
+ *
+ ******************************************************************************/
+
+int Disc_Image::Read_Unencrypted(void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (!Buffer) throw "Null Buffer";
+
+	return Read_Raw(Buffer, size, offset);
+}
+
+/*******************************************************************************
+ * Read: Read decrypted data from the opened partition
+ * -----------------------------------------------------------------------------
+ * Offsets are in user data space, like DI_Read: every 0x8000 byte cluster on
+ * disc holds 0x7c00 bytes of data behind its hashes.
+ *
+ * Return Values:
+ *	returns 0 on success, -1 on error
+ *
+ ******************************************************************************/
+
+int Disc_Image::Read(void* Buffer, unsigned int size, unsigned int offset)
+{
+	if (!Buffer) return -1;
+	if (!Partition_Open) return -1;
+
+	byte* Out = (byte*)Buffer;
+
+	while (size > 0)
+	{
+		qword			Index	= offset / Cluster_Data;
+		unsigned int	Skip	= offset % Cluster_Data;
+		unsigned int	Length	= (size < Cluster_Data - Skip) ? size : Cluster_Data - Skip;
+
+		if (!Load_Cluster(Index)) return -1;
+
+		memcpy(Out, Cluster + Cluster_Header + Skip, Length);
+
+		Out		+= Length;
+		offset	+= Length;
+		size	-= Length;
+	}
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Disc_Offset: Find where a partition read offset is stored in the image
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the image offset of the raw cluster holding the data
+ *
+ ******************************************************************************/
+
+qword Disc_Image::Disc_Offset(unsigned int offset) const
+{
+	return Data_Offset + (offset / Cluster_Data) * (qword)Cluster_Size;
+}
+
+/*******************************************************************************
+ * Load_Cluster: Read and decrypt a partition cluster
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	true if Cluster holds the decrypted cluster
+ *
+ ******************************************************************************/
+
+bool Disc_Image::Load_Cluster(qword Index)
+{
+	if (Index == Cluster_Index) return true;
+	if ((Index + 1) * Cluster_Size > Data_Size) return false;
+
+	Cluster_Index = ~0ULL;
+	if (Read_Raw(Cluster, Cluster_Size, Data_Offset + Index * Cluster_Size) < 0) return false;
+
+	// The user data IV is stored (encrypted) in the hash block
+	Title_Key.Decrypt(Cluster + 0x3d0, Cluster + Cluster_Header, Cluster + Cluster_Header, Cluster_Data);
+
+	Cluster_Index = Index;
+	return true;
+}
+
+/*******************************************************************************
+ * Load_CommonKey: Read the common key from storage
+ * -----------------------------------------------------------------------------
+ * The key isn't distributed with SoftChip; it has to be dumped from the
+ * console by the user.
+ *
+ * Return Values:
+ *	true if a key was read
+ *
+ ******************************************************************************/
+
+bool Disc_Image::Load_CommonKey(byte* Key)
+{
+	FILE* fp = Storage::Instance()->OpenFile(ConfigData::Common_KeyFile, "rb");
+	if (fp == NULL) return false;
+
+	bool Result = (fread(Key, 1, 16, fp) == 16);
+	fclose(fp);
+
+	return Result;
+}
+
+/*******************************************************************************
+ * Open_Partition: Opens a partition for reading
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 0 on success, -1 on error
+ *
+ ******************************************************************************/
+
+int Disc_Image::Open_Partition(unsigned int Offset, void* Ticket, void* Certificate, unsigned int Cert_Len, void* Out)
+{
+	byte Header[Partition_Header::Size];
+	qword Base = (qword)Offset << 2;
+
+	Partition_Open	= false;
+	Cluster_Index	= ~0ULL;
+
+	if (Read_Raw(Header, sizeof(Header), Base) < 0) return -1;
+
+	// Title key, decrypted with the common key
+	byte Common_Key[16], Key[16], IV[16];
+
+	if (Header[Partition_Header::Key_Index] != 0) return -1;
+	if (!Load_CommonKey(Common_Key)) return -1;
+
+	memset(IV, 0, sizeof(IV));
+	memcpy(IV, Header + Partition_Header::Title_ID, 8);
+
+	AES Common;
+	Common.Set_Key(Common_Key);
+	Common.Decrypt(IV, Header + Partition_Header::Title_Key, Key, 16);
+	Title_Key.Set_Key(Key);
+
+	// TMD, returned like the drive does
+	unsigned int TMD_Size = Read_BE32(Header + Partition_Header::TMD_Size);
+	qword TMD_Offset = (qword)Read_BE32(Header + Partition_Header::TMD_Offset) << 2;
+
+	if (Out)
+	{
+		if (TMD_Size > Max_TMD_Size) TMD_Size = Max_TMD_Size;
+		if (Read_Raw(Out, TMD_Size, Base + TMD_Offset) < 0) return -1;
+	}
+
+	Data_Offset		= Base + ((qword)Read_BE32(Header + Partition_Header::Data_Offset) << 2);
+	Data_Size		= (qword)Read_BE32(Header + Partition_Header::Data_Size) << 2;
+	Partition_Open	= true;
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Close_Partition: Closes the opened partition
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 0
+ *
+ ******************************************************************************/
+
+int Disc_Image::Close_Partition()
+{
+	Partition_Open	= false;
+	Cluster_Index	= ~0ULL;
+	return 0;
+}
+
+/*******************************************************************************
+ * Set_OffsetBase / Get_OffsetBase: Kept for Get_OffsetBase only
+ * -----------------------------------------------------------------------------
+ * Unencrypted reads are absolute and partition reads are relative to the
+ * opened partition, so the base doesn't move any read.
+ *
+ * Return Values:
+ *	returns 0
+ *
+ ******************************************************************************/
+
+int Disc_Image::Set_OffsetBase(unsigned int Base)
+{
+	Offset_Base = Base;
+	return 0;
+}
+
+int Disc_Image::Get_OffsetBase(unsigned int* Base)
+{
+	*Base = Offset_Base;
+	return 0;
+}
+
+/*******************************************************************************
+ * Drive commands: There's no cover or motor, so these just succeed
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns 0, or -1 if the image isn't open
+ *
+ ******************************************************************************/
+
+int Disc_Image::Verify_Cover(bool *Inserted)
+{
+	*Inserted = (File != NULL);
+	return 0;
+}
+
+int Disc_Image::Wait_CoverClose()
+{
+	return (File != NULL) ? 0 : -1;
+}
+
+int Disc_Image::Reset()
+{
+	Cluster_Index = ~0ULL;
+	return (File != NULL) ? 0 : -1;
+}
+
+int Disc_Image::Stop_Motor()
+{
+	return 0;
+}
@@ -0,0 +1,439 @@
+/*******************************************************************************
+ * Disc_Probe.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class that opens the disc on a background
+ *	thread while the main menu is shown
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+
+#include "Disc_Probe.h"
+#include "Buffer_Pool.h"
+#include "Profiler.h"
+
+//--------------------------------------
+// Disc_Probe Class
+
+/*******************************************************************************
+ * Disc_Probe: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Disc_Probe::Disc_Probe()
+{
+	Header		= 0;
+	Ticket		= 0;
+	TMD			= 0;
+	Error		= 0;
+	Activity	= 0;
+	Steps_Done	= 0;
+	Started_At	= 0;
+	Finished_At	= 0;
+	Marks		= 0;
+	Disc		= 0;
+	Thread		= LWP_THREAD_NULL;
+	Status		= Stage_Idle;
+	Cancelled	= false;
+
+	memset(&Disc_ID, 0, sizeof(Disc_ID));
+	memset(&Partition, 0, sizeof(Partition));
+}
+
+/*******************************************************************************
+ * ~Disc_Probe: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Disc_Probe::~Disc_Probe() {}
+
+/*******************************************************************************
+ * Initialize: Take the buffers from the pool
+ * -----------------------------------------------------------------------------
+ * They are kept for every boot, as the partition's ticket and TMD are needed
+ * up to the jump, so the first call must be outside any Buffer_Scope.
+ *
+ * Return Values:
+ *	true if the buffers are there
+ *
+ ******************************************************************************/
+
+bool Disc_Probe::Initialize()
+{
+	Buffer_Pool* Pool = Buffer_Pool::Instance();
+
+	if (!Header) Header = (Wii_Disc::Header*)Pool->Alloc(sizeof(Wii_Disc::Header));
+	if (!Ticket) Ticket = (byte*)Pool->Alloc(Ticket_Size);
+	if (!TMD) TMD = (byte*)Pool->Alloc(TMD_Size);
+
+	return (Header && Ticket && TMD);
+}
+
+/*******************************************************************************
+ * Start: Open the disc on a background thread
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the thread was started
+ *
+ ******************************************************************************/
+
+bool Disc_Probe::Start(Disc_Source* Source)
+{
+	if (Status != Stage_Idle || !Initialize()) return false;
+
+	Disc		= Source;
+	Error		= 0;
+	Activity	= 0;
+	Steps_Done	= 0;
+	Cancelled	= false;
+	Status		= Stage_Running;
+	Marks		= 0;
+	Started_At	= Profiler::Instance()->Now();
+
+	if (LWP_CreateThread(&Thread, Entry, this, 0, Stack_Size, Priority) < 0)
+	{
+		Thread = LWP_THREAD_NULL;
+		Status = Stage_Idle;
+		return false;
+	}
+
+	return true;
+}
+
+/*******************************************************************************
+ * Started: Check for a thread started since the last Claim or Cancel
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the probe isn't idle
+ *
+ ******************************************************************************/
+
+bool Disc_Probe::Started()
+{
+	return (Status != Stage_Idle);
+}
+
+/*******************************************************************************
+ * Poll: Check on the thread without waiting for it
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the stage it reached, Stage_Running while it runs
+ *
+ ******************************************************************************/
+
+Disc_Probe::Stage Disc_Probe::Poll()
+{
+	return Status;
+}
+
+/*******************************************************************************
+ * Stop: Ask the thread to stop after its current command
+ * -----------------------------------------------------------------------------
+ * A command the drive never answers can't be stopped, so this doesn't wait.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Disc_Probe::Stop()
+{
+	Cancelled = true;
+}
+
+/*******************************************************************************
+ * Wait: Wait for the thread to finish
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the stage it reached
+ *
+ ******************************************************************************/
+
+Disc_Probe::Stage Disc_Probe::Wait()
+{
+	if (Thread != LWP_THREAD_NULL)
+	{
+		LWP_JoinThread(Thread, 0);
+		Thread = LWP_THREAD_NULL;
+	}
+
+	return Status;
+}
+
+/*******************************************************************************
+ * Claim: Take over what the thread did
+ * -----------------------------------------------------------------------------
+ * The caller owns the opened partition, and the probe can be started again.
+ *
+ * Return Values:
+ *	returns the stage the thread reached
+ *
+ ******************************************************************************/
+
+Disc_Probe::Stage Disc_Probe::Claim()
+{
+	bool Ran = (Status != Stage_Idle);
+	Stage Reached = Wait();
+
+	if (Ran)
+	{
+		Record_Steps(Finished_At);
+		Profiler::Instance()->Record("Disc_Probe", Started_At, Finished_At);
+	}
+
+	Status = Stage_Idle;
+	return Reached;
+}
+
+/*******************************************************************************
+ * Cancel: Stop the thread after its current command
+ * -----------------------------------------------------------------------------
+ * Needed before the IOS is reloaded, or anything else uses the disc.  A thread
+ * still in a command isn't waited for, as the drive may never answer: it's left
+ * to finish on its own, and the IOS must not be reloaded meanwhile.
+ *
+ * Return Values:
+ *	returns false if the thread is still running
+ *
+ ******************************************************************************/
+
+bool Disc_Probe::Cancel()
+{
+	Stop();
+
+	if (Status == Stage_Running) return false;
+
+	if (Wait() == Stage_Opened) Disc->Close_Partition();
+
+	Status = Stage_Idle;
+	return true;
+}
+
+/*******************************************************************************
+ * Open: Open the disc on the caller's thread
+ * -----------------------------------------------------------------------------
+ * Used when the thread couldn't, after the load has waited for a disc.
+ *
+ * Return Values:
+ *	returns void, throws on error
+ *
+ ******************************************************************************/
+
+void Disc_Probe::Open(Disc_Source* Source)
+{
+	if (!Initialize()) throw "Out of I/O buffers";
+
+	Disc		= Source;
+	Cancelled	= false;
+	Steps_Done	= 0;
+	Marks		= 0;
+
+	try
+	{
+		Steps();
+	}
+	catch (const char* Message)
+	{
+		Record_Steps(Profiler::Instance()->Now());
+		throw;
+	}
+
+	Record_Steps(Profiler::Instance()->Now());
+}
+
+/*******************************************************************************
+ * Steps: Everything Load_Disc does up to the apploader, but the output
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void, throws on error
+ *
+ ******************************************************************************/
+
+void Disc_Probe::Steps()
+{
+	Report("Spinning up the disc");
+	Disc->Reset();
+
+	Report("Reading the disc ID");
+	memset(&Disc_ID, 0, sizeof(Disc_ID));
+	Disc->Read_DiscID(&Disc_ID);
+
+	if (*(dword*)&Disc_ID == 0x10001 || *(dword*)&Disc_ID == 0x10000) throw "Disc is decrypted";
+
+	Report("Reading the disc header");
+	Disc->Read_Unencrypted(Header, sizeof(Wii_Disc::Header), 0);
+
+	// Boot partition
+	Report("Reading the partition table");
+
+	dword						Count		= 0;
+	Wii_Disc::Partition_Info*	Partitions	= Wii_Disc::Read_Partitions(Disc, &Count);
+
+	if (!Partitions) throw "Error reading partition table";
+
+	memset(&Partition, 0, sizeof(Partition));
+
+	for (dword i = 0; i < Count; i++)
+	{
+		if (Partitions[i].Type == 0)
+		{
+			Partition = Partitions[i];
+			break;
+		}
+	}
+
+	Buffer_Pool::Instance()->Free(Partitions);
+
+	if (!Partition.Offset) throw "Wrong Offset";
+
+	Disc->Set_OffsetBase(Partition.Offset << 2);
+
+	Report("Reading the ticket");
+	memset(Ticket, 0, Ticket_Size);
+	Disc->Read_Unencrypted(Ticket, Ticket_Size, Partition.Offset << 2);
+
+	Report("Opening the partition");
+	memset(TMD, 0, TMD_Size);
+
+	if (Disc->Open_Partition(Partition.Offset, 0,0,0, TMD) < 0) throw "Open Error";
+
+	Mark(0);
+	Activity = 0;
+	Steps_Done = Steps_Total;
+}
+
+/*******************************************************************************
+ * Check: Stop between commands once cancelled
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void, throws if cancelled
+ *
+ ******************************************************************************/
+
+void Disc_Probe::Check()
+{
+	if (Cancelled) throw "Cancelled";
+}
+
+/*******************************************************************************
+ * Report: Start the next command, unless cancelled
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void, throws if cancelled
+ *
+ ******************************************************************************/
+
+void Disc_Probe::Report(const char* Name)
+{
+	Check();
+
+	if (Activity) Steps_Done++;
+	Activity = Name;
+
+	Mark(Name);
+}
+
+/*******************************************************************************
+ * Mark: Note the time a step starts, 0 ends the last one
+ * -----------------------------------------------------------------------------
+ * The profiler is only used from the main thread, so the steps are kept here
+ * until Record_Steps.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Disc_Probe::Mark(const char* Name)
+{
+	if (Marks >= Steps_Total + 2) return;
+
+	Mark_Names[Marks]	= Name;
+	Mark_Times[Marks]	= Profiler::Instance()->Now();
+	Marks++;
+}
+
+/*******************************************************************************
+ * Record_Steps: Add the steps to the boot timeline
+ * -----------------------------------------------------------------------------
+ * Called on the main thread, once the steps are done.  A step that wasn't
+ * ended, as the thread failed in it, ends at End.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Disc_Probe::Record_Steps(u64 End)
+{
+	for (unsigned int i = 0; i < Marks; i++)
+	{
+		if (Mark_Names[i]) Profiler::Instance()->Record(Mark_Names[i], Mark_Times[i], (i + 1 < Marks) ? Mark_Times[i + 1] : End);
+	}
+
+	Marks = 0;
+}
+
+/*******************************************************************************
+ * Entry: Body of the thread
+ * -----------------------------------------------------------------------------
+ * A missing disc isn't waited for; the load asks for one.  The motor is left
+ * to the idle timeout, the load opens the disc again if it was stopped.
+ *
+ * Return Values:
+ *	returns 0
+ *
+ ******************************************************************************/
+
+void* Disc_Probe::Entry(void* Argument)
+{
+	Disc_Probe* Probe = (Disc_Probe*)Argument;
+	Stage Reached = Stage_Opened;
+
+	try
+	{
+		bool Inserted = false;
+
+		Probe->Mark("Verify_Cover");
+		if (Probe->Disc->Verify_Cover(&Inserted) < 0) throw "Verify_Cover failed";
+
+		if (Inserted) Probe->Steps();
+		else Reached = Stage_No_Disc;
+	}
+	catch (const char* Message)
+	{
+		Probe->Error	= Message;
+		Reached			= Stage_Failed;
+	}
+
+	// Until the load uses it, the drive stops after the idle timeout as after Load_IOS
+	if (Reached != Stage_No_Disc && !Probe->Cancelled)
+	{
+		try
+		{
+			Probe->Disc->Stop_Motor();
+		}
+		catch (const char* Message) {}
+	}
+
+	Probe->Finished_At	= Profiler::Instance()->Now();
+	Probe->Status		= Reached;
+
+	return 0;
+}
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <time.h>
 
 #include "Logger.h"
 #include "Configuration.h"
@@ -116,3 +117,54 @@ void Logger::Write(const char* Message, ...)
     vfprintf(LogFile, Message, argp);
     va_end(argp);
 }
+
+/*******************************************************************************
+ * OpenTrace: Create a trace file (replaces an existing one)
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns bool
+ *
+ ******************************************************************************/
+
+bool Logger::OpenTrace(const char* Filename)
+{
+	// Logging Activated?
+	if (!Configuration::Instance()->Data.Logging) return false;
+
+	CloseTrace();
+
+	TraceFile = Storage::Instance()->OpenFile(Filename, "wb");
+	return TraceFile != NULL;
+}
+
+/*******************************************************************************
+ * CloseTrace: Closes the trace file
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Logger::CloseTrace()
+{
+	if (TraceFile) fclose(TraceFile);
+	TraceFile = NULL;
+}
+
+/*******************************************************************************
+ * Trace: Write to the trace file as is (no time tag)
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Logger::Trace(const char* Message, ...)
+{
+	if (TraceFile == NULL) return;
+
+	va_list argp;
+	va_start(argp, Message);
+	vfprintf(TraceFile, Message, argp);
+	va_end(argp);
+}
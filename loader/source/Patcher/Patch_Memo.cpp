@@ -0,0 +1,308 @@
+/*******************************************************************************
+ * Patch_Memo.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the part of the Patcher class keeping the patch memo.  A game's
+ *	record is only used if main.dol's header has the same checksum, and
+ *	every site is checked against the rule's pattern before it is written,
+ *	so a stale record costs a search, never a bad patch.
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Patcher.h"
+#include "Storage.h"
+#include "FNV.h"
+
+//--------------------------------------
+// Memo file
+
+namespace
+{
+	Patch_Memo::Record	Records[Patch_Memo::Max_Records];
+	dword				Record_Count;
+
+	// Only rules writing once have a single site to remember
+	inline bool Memorable(const Patcher::Rule* Entry)
+	{
+		return Entry->Write && Entry->Limit == 1;
+	}
+
+	void Swap_Record(Patch_Memo::Record* Entry)
+	{
+		Entry->Checksum	= BE32(Entry->Checksum);
+		Entry->Count	= BE32(Entry->Count);
+
+		for (unsigned int i = 0; i < Patch_Memo::Max_Sites; i++)
+		{
+			Entry->Sites[i].Key		= BE32(Entry->Sites[i].Key);
+			Entry->Sites[i].Offset	= BE32(Entry->Sites[i].Offset);
+		}
+	}
+
+	// Reads every record into Records, in host byte order
+	bool Read_Records(const char* Path)
+	{
+		Patch_Memo::Header	Head;
+		FILE*				fp		= Storage::Instance()->OpenFile(Path, "rb");
+		bool				Result	= false;
+
+		Record_Count = 0;
+		if (fp == NULL) return false;
+
+		if (fread(&Head, 1, sizeof(Head), fp) == sizeof(Head)
+			&& memcmp(Head.Signature, Patch_Memo::Signature, sizeof(Head.Signature)) == 0
+			&& Head.Version == Patch_Memo::Version
+			&& BE32(Head.Count) <= Patch_Memo::Max_Records)
+		{
+			dword Count = BE32(Head.Count);
+
+			if (fread(Records, sizeof(Patch_Memo::Record), Count, fp) == Count)
+			{
+				for (dword i = 0; i < Count; i++)
+				{
+					Swap_Record(&Records[i]);
+					if (Records[i].Count > Patch_Memo::Max_Sites) Records[i].Count = 0;
+				}
+
+				Record_Count	= Count;
+				Result			= true;
+			}
+		}
+
+		fclose(fp);
+		return Result;
+	}
+
+	bool Write_Records(const char* Path)
+	{
+		FILE* fp = Storage::Instance()->OpenFile(Path, "wb");
+		if (fp == NULL) return false;
+
+		Patch_Memo::Header Head;
+		memset(&Head, 0, sizeof(Head));
+		memcpy(Head.Signature, Patch_Memo::Signature, sizeof(Head.Signature));
+
+		Head.Version	= Patch_Memo::Version;
+		Head.Count		= BE32(Record_Count);
+
+		bool Result = (fwrite(&Head, 1, sizeof(Head), fp) == sizeof(Head));
+
+		for (dword i = 0; Result && i < Record_Count; i++)
+		{
+			Patch_Memo::Record Entry = Records[i];
+			Swap_Record(&Entry);
+
+			Result = (fwrite(&Entry, 1, sizeof(Entry), fp) == sizeof(Entry));
+		}
+
+		return (fclose(fp) == 0) && Result;
+	}
+}
+
+//--------------------------------------
+// Patcher Class
+
+/*******************************************************************************
+ * Rule_Key: Identify a rule's pattern across boots
+ * -----------------------------------------------------------------------------
+ * The value written is left out, so a site stays valid when e.g. the
+ * language option changes.
+ *
+ * Return Values:
+ *	returns an FNV-1a hash of the name, pattern and target of the rule
+ *
+ ******************************************************************************/
+
+dword Patcher::Rule_Key(const Rule* Entry)
+{
+	dword Key = FNV::Offset_Basis;
+
+	for (const char* Name = Entry->Name; *Name; Name++)
+	{
+		Key = FNV::Mix(Key, (byte)*Name);
+	}
+
+	for (unsigned int i = 0; i < Entry->Length; i++)
+	{
+		Key = FNV::Mix(Key, Entry->Match[i]);
+		Key = FNV::Mix(Key, Entry->Match_Mask[i]);
+	}
+
+	Key = FNV::Mix(Key, (dword)Entry->Word);
+	Key = FNV::Mix(Key, Entry->Segments);
+
+	return Key;
+}
+
+/*******************************************************************************
+ * Load_Memo: Use the sites found by a previous boot of the game
+ * -----------------------------------------------------------------------------
+ * Rules with a site are no longer searched for; the site is checked and
+ * patched by Scan when its section is loaded.  Needs the checksum from
+ * Set_DOL, so without main.dol's header everything is searched for.
+ *
+ * Return Values:
+ *	returns true if a record for the game was used
+ *
+ ******************************************************************************/
+
+bool Patcher::Load_Memo(const char* Path)
+{
+	Memo_Used	= 0;
+	Memo_Missed	= 0;
+
+	if (!DOL_Checksum)
+	{
+		Memo_Status = "no main.dol header";
+		return false;
+	}
+
+	if (!Read_Records(Path))
+	{
+		Memo_Status = "not found";
+		return false;
+	}
+
+	const Patch_Memo::Record* Record = 0;
+
+	for (dword i = 0; i < Record_Count && !Record; i++)
+	{
+		if (memcmp(Records[i].Game_ID, Game_ID, sizeof(Game_ID)) == 0 && Records[i].Checksum == DOL_Checksum) Record = &Records[i];
+	}
+
+	if (!Record)
+	{
+		Memo_Status = "no record for the game";
+		return false;
+	}
+
+	for (dword Site = 0; Site < Record->Count; Site++)
+	{
+		for (unsigned int i = 0; i < Rule_Count; i++)
+		{
+			Rule* Entry = &Rules[i];
+
+			if (!Memorable(Entry) || Entry->Memo != Memo_None) continue;
+			if (Rule_Key(Entry) != Record->Sites[Site].Key) continue;
+
+			Entry->Site	= Record->Sites[Site].Offset;
+			Entry->Memo	= (Entry->Site == Patch_Memo::No_Site) ? Memo_Absent : Memo_Site;
+
+			Memo_Used++;
+			break;
+		}
+	}
+
+	Memo_Status = "used";
+	return true;
+}
+
+/*******************************************************************************
+ * Apply_Memo: Patch the memo sites in a section
+ * -----------------------------------------------------------------------------
+ * A site whose words no longer match the pattern is dropped, and the rule
+ * is searched for from this section on.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Patcher::Apply_Memo(dword* Words, unsigned int Count, dword Offset)
+{
+	for (unsigned int Index = 0; Index < Rule_Count; Index++)
+	{
+		Rule* Entry = &Rules[Index];
+
+		if (Entry->Memo != Memo_Site || Entry->Hits) continue;
+		if (Entry->Site < Offset || Entry->Site - Offset >= Count * 4) continue;
+
+		unsigned int	i		= (Entry->Site - Offset) / 4;
+		int				Target	= (int)i + Entry->Word;
+		bool			Same	= (i + Entry->Length <= Count) && Target >= 0 && Target < (int)Count
+								&& Pattern_Search::Compare(Words + i, Entry->Match, Entry->Match_Mask, Entry->Length);
+
+		if (!Same)
+		{
+			Entry->Memo	= Memo_None;
+			Entry->Site	= Patch_Memo::No_Site;
+			Memo_Missed++;
+			continue;
+		}
+
+		Write(Entry, &Words[Target]);
+		Entry->Hits++;
+	}
+}
+
+/*******************************************************************************
+ * Save_Memo: Remember the sites found by this boot
+ * -----------------------------------------------------------------------------
+ * The file is only rewritten when the boot searched for something, so a
+ * game booted from its memo doesn't cost an SD write.  The game's record
+ * moves to the front; the last one is dropped when the file is full.
+ *
+ * Return Values:
+ *	returns false if the file couldn't be written
+ *
+ ******************************************************************************/
+
+bool Patcher::Save_Memo(const char* Path)
+{
+	if (!DOL_Checksum) return true;
+
+	Patch_Memo::Record	Record;
+	bool				Searched = false;
+
+	memset(&Record, 0, sizeof(Record));
+	memcpy(Record.Game_ID, Game_ID, sizeof(Game_ID));
+	Record.Checksum = DOL_Checksum;
+
+	for (unsigned int i = 0; i < Rule_Count && Record.Count < Patch_Memo::Max_Sites; i++)
+	{
+		const Rule* Entry = &Rules[i];
+
+		if (!Memorable(Entry)) continue;
+		if (Entry->Memo == Memo_None) Searched = true;
+
+		// A memo site that wasn't loaded this time is neither confirmed nor disproved
+		if (Entry->Memo == Memo_Site && !Entry->Hits) continue;
+
+		Record.Sites[Record.Count].Key		= Rule_Key(Entry);
+		Record.Sites[Record.Count].Offset	= Entry->Hits ? Entry->Site : (dword)Patch_Memo::No_Site;
+		Record.Count++;
+	}
+
+	if (!Searched) return true;
+
+	Read_Records(Path);
+
+	// Drop the game's old record, then shift the rest down to make room at the front
+	dword Kept = 0;
+
+	for (dword i = 0; i < Record_Count; i++)
+	{
+		if (memcmp(Records[i].Game_ID, Game_ID, sizeof(Game_ID)) == 0) continue;
+		Records[Kept++] = Records[i];
+	}
+
+	if (Kept == Patch_Memo::Max_Records) Kept--;
+
+	memmove(&Records[1], &Records[0], Kept * sizeof(Patch_Memo::Record));
+	Records[0]		= Record;
+	Record_Count	= Kept + 1;
+
+	return Write_Records(Path);
+}
@@ -0,0 +1,708 @@
+/*******************************************************************************
+ * Patcher.cpp
+ *
+ * Copyright (c) 2009 Requiem (requiem@century-os.com)
+ * Copyright (c) 2009 luccax
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class patching the game's sections in memory
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+#include <string.h>
+#include <ogc/conf.h>
+
+#include "Patcher.h"
+#include "WiiDisc.h"
+#include "Logger.h"
+#include "Storage.h"
+#include "FNV.h"
+
+//--------------------------------------
+// Patcher Class
+
+/*******************************************************************************
+ * Patcher: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Patcher::Patcher()
+{
+	Cfg = Configuration::Instance();
+
+	Rule_Count		= 0;
+	Segment_Count	= 0;
+	Loaded			= 0;
+	Scanned			= 0;
+
+	Database_Count	= 0;
+	Database_Status	= "not loaded";
+
+	DOL_Checksum	= 0;
+	Memo_Used		= 0;
+	Memo_Missed		= 0;
+	Memo_Status		= "not used";
+
+	memset(Game_ID, 0, sizeof(Game_ID));
+
+	memset(Heads, -1, sizeof(Heads));
+	Search.Clear();
+}
+
+/*******************************************************************************
+ * ~Patcher: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Patcher::~Patcher() {}
+
+/*******************************************************************************
+ * Add_Rule: Add a pattern to the table
+ * -----------------------------------------------------------------------------
+ * Match_Mask gives the bits compared in each word, or is 0 to compare them
+ * all.  The first word is always compared whole, as it is hashed.
+ *
+ * Return Values:
+ *	returns the rule index, -1 if the table is full
+ *
+ ******************************************************************************/
+
+int Patcher::Add_Rule(const char* Name, int Patch, unsigned int Segments, const dword* Match, const dword* Match_Mask, unsigned int Length, int Requires)
+{
+	if (Rule_Count >= Max_Rules || Length == 0 || Length > Max_Words) return -1;
+
+	int Index	= Rule_Count++;
+	Rule* Entry	= &Rules[Index];
+
+	memset(Entry, 0, sizeof(Rule));
+
+	for (unsigned int i = 0; i < Length; i++)
+	{
+		Entry->Match_Mask[i]	= (Match_Mask && i > 0) ? Match_Mask[i] : 0xffffffff;
+		Entry->Match[i]			= Match[i] & Entry->Match_Mask[i];
+	}
+
+	Entry->Name		= Name;
+	Entry->Patch	= Patch;
+	Entry->Segments	= Segments;
+	Entry->Length	= Length;
+	Entry->Requires	= Requires;
+	Entry->Memo		= Memo_None;
+	Entry->Site		= Patch_Memo::No_Site;
+
+	// Rules sharing a first word (or its hash) are chained
+	unsigned int Slot	= Hash(Match[0]);
+	Entry->Next			= Heads[Slot];
+	Heads[Slot]			= Index;
+
+	Search.Add(Match[0]);
+
+	return Index;
+}
+
+/*******************************************************************************
+ * Set_Write: Make a rule rewrite one of its words when it matches
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Patcher::Set_Write(int Index, int Word, dword Value, dword Mask, unsigned int Limit)
+{
+	if (Index < 0) return;
+
+	Rule* Entry = &Rules[Index];
+
+	Entry->Write	= true;
+	Entry->Word		= Word;
+	Entry->Value	= Value;
+	Entry->Mask		= Mask;
+	Entry->Limit	= Limit;
+}
+
+/*******************************************************************************
+ * Prepare: Compile the patches enabled in the configuration
+ * -----------------------------------------------------------------------------
+ * Language: 0x88610008 (lbz r3,8(r1)) following the check of the system
+ * language becomes li r3,<language>.  Country strings: the console's region
+ * string (e.g. "\x01US\0") is changed to the disc's region.  The language
+ * patch is code, so only looked for in text sections; the strings are data.
+ * The database rules for the game follow.
+ *
+ * Return Values:
+ *	returns true if there is anything to patch
+ *
+ ******************************************************************************/
+
+bool Patcher::Prepare(const char* Disc_ID)
+{
+	char Region = Disc_ID[3];
+
+	Rule_Count		= 0;
+	Segment_Count	= 0;
+	Loaded			= 0;
+	Scanned			= 0;
+
+	DOL_Checksum	= 0;
+	Memo_Used		= 0;
+	Memo_Missed		= 0;
+	Memo_Status		= "not used";
+
+	memset(Game_ID, 0, sizeof(Game_ID));
+	memcpy(Game_ID, Disc_ID, 6);
+
+	memset(Heads, -1, sizeof(Heads));
+	Search.Clear();
+
+	// Game's language
+	if (Cfg->Data.Language != -1)
+	{
+		int Language = Cfg->Data.Language;
+
+		if (Language == -2)
+		{
+			switch (Region)
+			{
+				case Wii_Disc::Regions::NTSC_Japan:	Language = 0; break;
+				case Wii_Disc::Regions::NTSC_USA:	Language = 1; break;
+				default:							Language = -1;
+			}
+		}
+
+		if (Language >= 0)
+		{
+			static const dword Trigger[3]	= { 0x7C600775, 0x40820010, 0x38000000 };
+			static const dword Target[1]	= { 0x88610008 };
+
+			int Check = Add_Rule("Language check", Patch_Language, Segment_Text, Trigger, 0, 3, -1);
+			Set_Write(Add_Rule("Language", Patch_Language, Segment_Text, Target, 0, 1, Check), 0, 0x38600000 | Language, 0xffffffff, 1);
+		}
+	}
+
+	// Country strings
+	if (Cfg->Data.Country_String_Patching)
+	{
+		dword Search;
+
+		switch (CONF_GetRegion())
+		{
+			case CONF_REGION_JP:	Search = 0x004A5000; break;		// "\0JP\0"
+			case CONF_REGION_EU:	Search = 0x02455500; break;		// "\2EU\0"
+			case CONF_REGION_KR:	Search = 0x044B5200; break;		// "\4KR\0"
+			case CONF_REGION_CN:	Search = 0x05434E00; break;		// "\5CN\0"
+			case CONF_REGION_US:
+			default:				Search = 0x01555300;			// "\1US\0"
+		}
+
+		dword Replace;
+
+		switch (Region)
+		{
+			case Wii_Disc::Regions::NTSC_Japan:
+				Replace = 0x004A5000;		// JP
+				break;
+
+			case Wii_Disc::Regions::PAL_Default:
+			case Wii_Disc::Regions::PAL_France:
+			case Wii_Disc::Regions::PAL_Germany:
+			case Wii_Disc::Regions::Euro_X:
+			case Wii_Disc::Regions::Euro_Y:
+				Replace = 0x00455500;		// EU
+				break;
+
+			case Wii_Disc::Regions::NTSC_USA:
+			default:
+				Replace = 0x00555300;		// US
+		}
+
+		Set_Write(Add_Rule("Country strings", Patch_Country_Strings, Segment_Data, &Search, 0, 1, -1), 0, Replace, 0x00ffff00, 1);
+	}
+
+	// 002 protection (disabled, the option isn't in the menu)
+	/*
+	if (Cfg->Data.Remove_002)
+	{
+		static const dword Protection[3] = { 0x2C000000, 0x40820214, 0x3C608000 };
+		Set_Write(Add_Rule("002 protection", Patch_002, Segment_Text, Protection, 0, 3, -1), 1, 0x48000214, 0xffffffff, 1);
+	}
+	*/
+
+	Add_Database(Disc_ID);
+
+	return Rule_Count > 0;
+}
+
+/*******************************************************************************
+ * Add_Database: Compile the database entries matching a game
+ * -----------------------------------------------------------------------------
+ * An entry is left out if its game or region doesn't match, or if the
+ * entry it requires was left out.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Patcher::Add_Database(const char* Disc_ID)
+{
+	int Compiled[Patch_Database::Max_Entries];
+
+	for (unsigned int i = 0; i < Database_Count; i++)
+	{
+		const Patch_Database::Entry* Entry = &Database[i];
+
+		Compiled[i] = -1;
+
+		const char*	ID_End		= (const char*)memchr(Entry->Game_ID, 0, Patch_Database::ID_Length);
+		size_t		ID_Length	= ID_End ? ID_End - Entry->Game_ID : Patch_Database::ID_Length;
+
+		if (strncmp(Disc_ID, Entry->Game_ID, ID_Length) != 0) continue;
+		if (Entry->Regions[0] && !memchr(Entry->Regions, Disc_ID[3], Patch_Database::Regions_Length)) continue;
+		if (Entry->Requires >= 0 && Compiled[(int)Entry->Requires] < 0) continue;
+
+		// The entry is packed, so its words are copied out rather than pointed to
+		dword Pattern[Max_Words], Pattern_Mask[Max_Words];
+		memcpy(Pattern, Entry->Pattern, sizeof(Pattern));
+		memcpy(Pattern_Mask, Entry->Pattern_Mask, sizeof(Pattern_Mask));
+
+		int Requires	= (Entry->Requires >= 0) ? Compiled[(int)Entry->Requires] : -1;
+		int Index		= Add_Rule(Entry->Name, Patch_Custom, Entry->Segments, Pattern, Pattern_Mask, Entry->Length, Requires);
+
+		if (Entry->Flags & Patch_Database::Flag_Write) Set_Write(Index, Entry->Target, Entry->Value, Entry->Mask, Entry->Limit);
+
+		Compiled[i] = Index;
+	}
+}
+
+/*******************************************************************************
+ * Load_Database: Read the patch database
+ * -----------------------------------------------------------------------------
+ * Done once at startup; Prepare compiles the entries for each game.  A
+ * missing file just means no database patches.
+ *
+ * Return Values:
+ *	returns true if the database was read and every entry is valid
+ *
+ ******************************************************************************/
+
+bool Patcher::Load_Database(const char* Path)
+{
+	Patch_Database::Header	Head;
+	FILE*					fp		= NULL;
+	bool					Result	= false;
+
+	Database_Count = 0;
+
+	try
+	{
+		fp = Storage::Instance()->OpenFile(Path, "rb");
+		if (fp == NULL)
+		{
+			throw "not found";
+		}
+
+		if (fread(&Head, 1, sizeof(Head), fp) != sizeof(Head))
+		{
+			throw "read error";
+		}
+
+		if (memcmp(Head.Signature, Patch_Database::Signature, sizeof(Head.Signature)) != 0)
+		{
+			throw "invalid signature";
+		}
+
+		if (Head.Version != Patch_Database::Version)
+		{
+			throw "unknown version";
+		}
+
+		dword Count = BE32(Head.Count);
+
+		if (Count > Patch_Database::Max_Entries)
+		{
+			throw "too many entries";
+		}
+
+		if (fread(Database, sizeof(Patch_Database::Entry), Count, fp) != Count)
+		{
+			throw "read error";
+		}
+
+		for (dword i = 0; i < Count; i++)
+		{
+			Patch_Database::Entry* Entry = &Database[i];
+
+			for (int Word = 0; Word < Patch_Database::Max_Words; Word++)
+			{
+				Entry->Pattern[Word]		= BE32(Entry->Pattern[Word]);
+				Entry->Pattern_Mask[Word]	= BE32(Entry->Pattern_Mask[Word]);
+			}
+
+			Entry->Value	= BE32(Entry->Value);
+			Entry->Mask		= BE32(Entry->Mask);
+
+			const char* Error = Check_Entry(Entry, i);
+			if (Error) throw Error;
+		}
+
+		Database_Count	= Count;
+		Database_Status	= "loaded";
+		Result			= true;
+	}
+	catch (const char* Message)
+	{
+		Database_Status = Message;
+	}
+
+	if (fp) fclose(fp);
+	return Result;
+}
+
+/*******************************************************************************
+ * Check_Entry: Validate a database entry, in host byte order
+ * -----------------------------------------------------------------------------
+ * Shared with the host build's compiler, so the loader never accepts a file
+ * the compiler wouldn't have written.
+ *
+ * Return Values:
+ *	returns 0 if the entry is valid, otherwise what is wrong with it
+ *
+ ******************************************************************************/
+
+const char* Patcher::Check_Entry(const Patch_Database::Entry* Entry, unsigned int Index)
+{
+	if (!memchr(Entry->Name, 0, Patch_Database::Name_Length))		return "name too long";
+	if (Entry->Length == 0 || Entry->Length > Max_Words)				return "bad pattern length";
+	if (Entry->Pattern_Mask[0] != 0xffffffff)							return "first word of the pattern has a mask";
+	if (Entry->Segments == 0 || (Entry->Segments & ~Segment_Any))		return "bad segments";
+	if (Entry->Flags & ~Patch_Database::Flag_Write)						return "unknown flags";
+	if (Entry->Requires >= (int)Index || Entry->Requires < -1)			return "requires a later entry";
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Set_DOL: Restrict the scans to main.dol's sections
+ * -----------------------------------------------------------------------------
+ * Offset is the DOL's offset into the partition, in bytes.  Sections are
+ * then recognized by their offset on disc, as the apploader loads them, so
+ * the FST, bi2 and anything else it loads are skipped.
+ *
+ * Return Values:
+ *	returns false if the header can't be used; everything is scanned then
+ *
+ ******************************************************************************/
+
+bool Patcher::Set_DOL(const Wii_Disc::DOL_Header* Header, dword Offset)
+{
+	Segment_Count	= 0;
+	DOL_Checksum	= 0;
+
+	if (!Header) return false;
+
+	for (int i = 0; i < Wii_Disc::DOL_Header::Sections; i++)
+	{
+		if (Header->Size[i] == 0) continue;
+
+		// Ranges must keep the words of a section aligned
+		if ((Header->Offset[i] | Header->Size[i]) & 3)
+		{
+			Segment_Count = 0;
+			return false;
+		}
+
+		Segment* Entry = &Segments[Segment_Count++];
+
+		Entry->Start	= Offset + Header->Offset[i];
+		Entry->End		= Entry->Start + Header->Size[i];
+		Entry->Type		= (i < Wii_Disc::DOL_Header::Text_Sections) ? Segment_Text : Segment_Data;
+	}
+
+	if (Segment_Count == 0) return false;
+
+	// FNV-1a of the layout, to tell whether the memo of the game still applies
+	dword Checksum = FNV::Offset_Basis;
+
+	for (int i = 0; i < Wii_Disc::DOL_Header::Sections; i++)
+	{
+		Checksum = FNV::Mix(Checksum, Header->Offset[i]);
+		Checksum = FNV::Mix(Checksum, Header->Address[i]);
+		Checksum = FNV::Mix(Checksum, Header->Size[i]);
+	}
+
+	Checksum = FNV::Mix(Checksum, Header->BSS_Address);
+	Checksum = FNV::Mix(Checksum, Header->BSS_Size);
+	Checksum = FNV::Mix(Checksum, Header->Entry_Point);
+	Checksum = FNV::Mix(Checksum, Offset);
+
+	DOL_Checksum = Checksum ? Checksum : 1;
+
+	return true;
+}
+
+/*******************************************************************************
+ * Scan: Apply the compiled patches to a section
+ * -----------------------------------------------------------------------------
+ * Offset is where the section comes from in the partition, in bytes.  Sites
+ * from the memo are patched first.  Then only the parts of the section
+ * holding a DOL section with rules left to search for are searched, or all
+ * of it if main.dol's layout is unknown.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Patcher::Scan(void* Address, int Size, dword Offset)
+{
+	if (Size < 4) return;
+
+	Loaded += Size;
+
+	if (Memo_Used) Apply_Memo((dword*)Address, Size / 4, Offset);
+
+	if (!Searching()) return;
+
+	if (Segment_Count == 0)
+	{
+		Scan_Range((dword*)Address, Size / 4, Segment_Any, Offset);
+		return;
+	}
+
+	dword End = Offset + Size;
+
+	for (unsigned int i = 0; i < Segment_Count; i++)
+	{
+		const Segment* Entry = &Segments[i];
+
+		if (Entry->End <= Offset || Entry->Start >= End) continue;
+		if (!Searching(Entry->Type)) continue;
+
+		dword First	= (Entry->Start > Offset) ? Entry->Start : Offset;
+		dword Last	= (Entry->End < End) ? Entry->End : End;
+
+		Scan_Range((dword*)((byte*)Address + (First - Offset)), (Last - First) / 4, Entry->Type, First);
+	}
+}
+
+/*******************************************************************************
+ * Scan_Range: Apply the rules for a segment type to a run of words
+ * -----------------------------------------------------------------------------
+ * One pass over the words.  The search kernel stops at each word some
+ * rule starts with, which then looks up the rules for its hash.  A rule
+ * requiring another one only matches after it in the same run.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Patcher::Scan_Range(dword* Words, unsigned int Count, unsigned int Type, dword Offset)
+{
+	bool Matched[Max_Rules];
+	memset(Matched, 0, sizeof(Matched));
+
+	Scanned += Count * 4;
+
+	for (unsigned int i = Search.Next(Words, 0, Count); i < Count; i = Search.Next(Words, i + 1, Count))
+	{
+		if (!Match(Words, i, Count, Type, Offset, Matched)) return;
+	}
+}
+
+/*******************************************************************************
+ * Match: Try the rules for the word at an index, and apply the ones matching
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns false once nothing is left to patch in this type of segment
+ *
+ ******************************************************************************/
+
+bool Patcher::Match(dword* Words, unsigned int i, unsigned int Count, unsigned int Type, dword Offset, bool* Matched)
+{
+	dword Value = BE32(Words[i]);
+
+	for (int Index = Heads[Hash(Value)]; Index >= 0; Index = Rules[Index].Next)
+	{
+		Rule* Entry = &Rules[Index];
+
+		if (Entry->Match[0] != Value || i + Entry->Length > Count) continue;
+		if (!(Entry->Segments & Type) || Entry->Memo != Memo_None) continue;
+		if (Entry->Requires >= 0 && !Matched[Entry->Requires]) continue;
+		if (Entry->Write && Entry->Limit && Entry->Hits >= Entry->Limit) continue;
+
+		if (!Pattern_Search::Compare(Words + i + 1, Entry->Match + 1, Entry->Match_Mask + 1, Entry->Length - 1)) continue;
+
+		// The target may be before the match, but not outside the run
+		int Target_Word = (int)i + Entry->Word;
+		if (Entry->Write && (Target_Word < 0 || Target_Word >= (int)Count)) continue;
+
+		Entry->Hits++;
+		Matched[Index] = true;
+
+		if (!Entry->Write) continue;
+
+		if (Entry->Site == Patch_Memo::No_Site) Entry->Site = Offset + i * 4;
+
+		Write(Entry, &Words[Target_Word]);
+
+		// Stop as soon as every limited patch is done
+		if (Entry->Hits == Entry->Limit && !Searching(Type)) return false;
+	}
+
+	return true;
+}
+
+/*******************************************************************************
+ * Write: Rewrite the target of a rule
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Patcher::Write(Rule* Entry, dword* Target)
+{
+	*Target = BE32((BE32(*Target) & ~Entry->Mask) | (Entry->Value & Entry->Mask));
+}
+
+/*******************************************************************************
+ * Open: Check if a rule can still write
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true unless the rule is a trigger, is done, or the memo says its
+ *	pattern isn't there
+ *
+ ******************************************************************************/
+
+bool Patcher::Open(const Rule* Entry) const
+{
+	return Entry->Write && (!Entry->Limit || Entry->Hits < Entry->Limit) && Entry->Memo != Memo_Absent;
+}
+
+/*******************************************************************************
+ * Pending: Check if any patch still has to be applied
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if a rule for one of the segment types can still write
+ *
+ ******************************************************************************/
+
+bool Patcher::Pending(unsigned int Type) const
+{
+	for (unsigned int i = 0; i < Rule_Count; i++)
+	{
+		if ((Rules[i].Segments & Type) && Open(&Rules[i])) return true;
+	}
+
+	return false;
+}
+
+/*******************************************************************************
+ * Searching: Check if any patch still has to be searched for
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if a rule for one of the segment types can still write and
+ *	has no site in the memo
+ *
+ ******************************************************************************/
+
+bool Patcher::Searching(unsigned int Type) const
+{
+	for (unsigned int i = 0; i < Rule_Count; i++)
+	{
+		if ((Rules[i].Segments & Type) && Rules[i].Memo == Memo_None && Open(&Rules[i])) return true;
+	}
+
+	return false;
+}
+
+/*******************************************************************************
+ * Enabled: Check if a patch was compiled by Prepare
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the patch has rules
+ *
+ ******************************************************************************/
+
+bool Patcher::Enabled(Patch_ID Patch) const
+{
+	for (unsigned int i = 0; i < Rule_Count; i++)
+	{
+		if (Rules[i].Patch == Patch) return true;
+	}
+
+	return false;
+}
+
+/*******************************************************************************
+ * Applied: Count the writes done by a patch
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the number of writes since Prepare
+ *
+ ******************************************************************************/
+
+unsigned int Patcher::Applied(Patch_ID Patch) const
+{
+	unsigned int Count = 0;
+
+	for (unsigned int i = 0; i < Rule_Count; i++)
+	{
+		if (Rules[i].Patch == Patch && Rules[i].Write) Count += Rules[i].Hits;
+	}
+
+	return Count;
+}
+
+/*******************************************************************************
+ * Get_Rule: Access a compiled rule and its hit count
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the rule, 0 past the last one
+ *
+ ******************************************************************************/
+
+const Patcher::Rule* Patcher::Get_Rule(unsigned int Index) const
+{
+	return (Index < Rule_Count) ? &Rules[Index] : 0;
+}
+
+/*******************************************************************************
+ * Log_Statistics: Write the hit count of every rule and the bytes scanned
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Patcher::Log_Statistics() const
+{
+	Logger* Log = Logger::Instance();
+
+	for (unsigned int i = 0; i < Rule_Count; i++)
+	{
+		Log->Write("Patch rule %s: %u hits\r\n", Rules[i].Name, Rules[i].Hits);
+	}
+
+	Log->Write("Patch database: %s, %u entries\r\n", Database_Status, Database_Count);
+	Log->Write("Patch memo: %s, %u sites used, %u stale\r\n", Memo_Status, Memo_Used, Memo_Missed);
+
+	Log->Write("Patch scan: %llu of %llu loaded bytes (%s)\r\n",
+		(unsigned long long)Scanned, (unsigned long long)Loaded, Segment_Count ? "main.dol sections" : "everything");
+}
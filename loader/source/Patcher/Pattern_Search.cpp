@@ -0,0 +1,386 @@
+/*******************************************************************************
+ * Pattern_Search.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of the word pattern search kernel
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+
+#include "Pattern_Search.h"
+
+// The vector paths only exist in the host build
+#if defined(__x86_64__) || defined(__i386__)
+#define PATTERN_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+//--------------------------------------
+// Pattern_Search Class
+
+/*******************************************************************************
+ * Pattern_Search: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Pattern_Search::Pattern_Search()
+{
+	Default = Best_Path();
+	Clear();
+}
+
+/*******************************************************************************
+ * ~Pattern_Search: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Pattern_Search::~Pattern_Search() {}
+
+/*******************************************************************************
+ * Clear: Remove every key
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Pattern_Search::Clear()
+{
+	memset(Table, 0, sizeof(Table));
+	Key_Count = 0;
+}
+
+/*******************************************************************************
+ * Add: Search for a word
+ * -----------------------------------------------------------------------------
+ * Keys are kept as stored in memory, so no path has to byte swap the words
+ * it reads.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Pattern_Search::Add(dword Key)
+{
+	dword Raw = BE32(Key);
+
+	for (unsigned int i = 0; i < Key_Count && i < Max_Keys; i++)
+	{
+		if (Keys[i] == Raw) return;
+	}
+
+	Table[Raw & ((1 << Table_Bits) - 1)] = 1;
+
+	if (Key_Count < Max_Keys) Keys[Key_Count] = Raw;
+	if (Key_Count <= Max_Keys) Key_Count++;
+}
+
+/*******************************************************************************
+ * Is_Key: Check a word that passed the table
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the word is a key, or might be one when there are too
+ *	many keys to compare
+ *
+ ******************************************************************************/
+
+bool Pattern_Search::Is_Key(dword Raw) const
+{
+	if (Key_Count > Max_Keys) return true;
+
+	for (unsigned int i = 0; i < Key_Count; i++)
+	{
+		if (Keys[i] == Raw) return true;
+	}
+
+	return false;
+}
+
+/*******************************************************************************
+ * Next: Find the next word equal to a key, with the fastest path
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns its index (at least Start), or Count if there is none
+ *
+ ******************************************************************************/
+
+unsigned int Pattern_Search::Next(const dword* Words, unsigned int Start, unsigned int Count) const
+{
+	return Next(Default, Words, Start, Count);
+}
+
+/*******************************************************************************
+ * Next: Find the next word equal to a key, with a given path
+ * -----------------------------------------------------------------------------
+ * All paths return the same index.  With more than Max_Keys keys, words
+ * only matching a key's low bits are returned too.
+ *
+ * Return Values:
+ *	returns its index (at least Start), or Count if there is none
+ *
+ ******************************************************************************/
+
+unsigned int Pattern_Search::Next(Path Kernel, const dword* Words, unsigned int Start, unsigned int Count) const
+{
+	if (Key_Count > Max_Keys) Kernel = Path_Scalar;
+
+	switch (Kernel)
+	{
+		case Path_AVX2:		return Next_AVX2(Words, Start, Count);
+		case Path_SSE2:		return Next_SSE2(Words, Start, Count);
+		default:			return Next_Scalar(Words, Start, Count);
+	}
+}
+
+/*******************************************************************************
+ * Next_Scalar: Table driven search, a cache line at a time
+ * -----------------------------------------------------------------------------
+ * Broadway has no 64 bit registers, so instead of wider loads a whole 32
+ * byte line is tested with one branch.  Lines are prefetched ahead of the
+ * scan (__builtin_prefetch is dcbt on the console, which never faults).
+ *
+ * Return Values:
+ *	returns the index of the next key, or Count if there is none
+ *
+ ******************************************************************************/
+
+unsigned int Pattern_Search::Next_Scalar(const dword* Words, unsigned int Start, unsigned int Count) const
+{
+	unsigned int i = Start;
+
+	// One word at a time up to the start of a line
+	for (; i < Count && ((unsigned long)(Words + i) & (Line_Words * 4 - 1)); i++)
+	{
+		if (Candidate(Words[i]) && Is_Key(Words[i])) return i;
+	}
+
+	for (; i + Line_Words <= Count; i += Line_Words)
+	{
+		const dword* Line = Words + i;
+
+		__builtin_prefetch(Line + Prefetch_Lines * Line_Words);
+
+		if (!(Candidate(Line[0]) | Candidate(Line[1]) | Candidate(Line[2]) | Candidate(Line[3])
+			| Candidate(Line[4]) | Candidate(Line[5]) | Candidate(Line[6]) | Candidate(Line[7]))) continue;
+
+		for (unsigned int j = 0; j < Line_Words; j++)
+		{
+			if (Candidate(Line[j]) && Is_Key(Line[j])) return i + j;
+		}
+	}
+
+	for (; i < Count; i++)
+	{
+		if (Candidate(Words[i]) && Is_Key(Words[i])) return i;
+	}
+
+	return Count;
+}
+
+/*******************************************************************************
+ * Next_SSE2: Compare 16 words against every key per step
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the index of the next key, or Count if there is none
+ *
+ ******************************************************************************/
+
+unsigned int Pattern_Search::Next_SSE2(const dword* Words, unsigned int Start, unsigned int Count) const
+{
+#if defined(PATTERN_SEARCH_X86) && defined(__SSE2__)
+	if (Key_Count == 0) return Count;
+
+	__m128i Key[Max_Keys];
+	for (unsigned int k = 0; k < Key_Count; k++) Key[k] = _mm_set1_epi32((int)Keys[k]);
+
+	unsigned int i = Start;
+
+	// 16 words per step, so the loop over the keys is paid once per 4 blocks
+	for (; i + 16 <= Count; i += 16)
+	{
+		const __m128i* Block = (const __m128i*)(Words + i);
+
+		__m128i A = _mm_loadu_si128(Block), B = _mm_loadu_si128(Block + 1), C = _mm_loadu_si128(Block + 2), D = _mm_loadu_si128(Block + 3);
+		__m128i Equal_A = _mm_setzero_si128(), Equal_B = Equal_A, Equal_C = Equal_A, Equal_D = Equal_A;
+
+		for (unsigned int k = 0; k < Key_Count; k++)
+		{
+			Equal_A = _mm_or_si128(Equal_A, _mm_cmpeq_epi32(A, Key[k]));
+			Equal_B = _mm_or_si128(Equal_B, _mm_cmpeq_epi32(B, Key[k]));
+			Equal_C = _mm_or_si128(Equal_C, _mm_cmpeq_epi32(C, Key[k]));
+			Equal_D = _mm_or_si128(Equal_D, _mm_cmpeq_epi32(D, Key[k]));
+		}
+
+		int Bits = _mm_movemask_ps(_mm_castsi128_ps(Equal_A))
+				| (_mm_movemask_ps(_mm_castsi128_ps(Equal_B)) << 4)
+				| (_mm_movemask_ps(_mm_castsi128_ps(Equal_C)) << 8)
+				| (_mm_movemask_ps(_mm_castsi128_ps(Equal_D)) << 12);
+
+		if (Bits) return i + __builtin_ctz(Bits);
+	}
+
+	for (; i < Count; i++)
+	{
+		if (Is_Key(Words[i])) return i;
+	}
+
+	return Count;
+#else
+	return Next_Scalar(Words, Start, Count);
+#endif
+}
+
+/*******************************************************************************
+ * Next_AVX2: Compare 32 words against every key per step
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the index of the next key, or Count if there is none
+ *
+ ******************************************************************************/
+
+#ifdef PATTERN_SEARCH_X86
+__attribute__((target("avx2")))
+#endif
+unsigned int Pattern_Search::Next_AVX2(const dword* Words, unsigned int Start, unsigned int Count) const
+{
+#ifdef PATTERN_SEARCH_X86
+	if (Key_Count == 0) return Count;
+
+	__m256i Key[Max_Keys];
+	for (unsigned int k = 0; k < Key_Count; k++) Key[k] = _mm256_set1_epi32((int)Keys[k]);
+
+	unsigned int i = Start;
+
+	// 32 words per step, as in Next_SSE2
+	for (; i + 32 <= Count; i += 32)
+	{
+		const __m256i* Block = (const __m256i*)(Words + i);
+
+		__m256i A = _mm256_loadu_si256(Block), B = _mm256_loadu_si256(Block + 1), C = _mm256_loadu_si256(Block + 2), D = _mm256_loadu_si256(Block + 3);
+		__m256i Equal_A = _mm256_setzero_si256(), Equal_B = Equal_A, Equal_C = Equal_A, Equal_D = Equal_A;
+
+		for (unsigned int k = 0; k < Key_Count; k++)
+		{
+			Equal_A = _mm256_or_si256(Equal_A, _mm256_cmpeq_epi32(A, Key[k]));
+			Equal_B = _mm256_or_si256(Equal_B, _mm256_cmpeq_epi32(B, Key[k]));
+			Equal_C = _mm256_or_si256(Equal_C, _mm256_cmpeq_epi32(C, Key[k]));
+			Equal_D = _mm256_or_si256(Equal_D, _mm256_cmpeq_epi32(D, Key[k]));
+		}
+
+		unsigned int Bits = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(Equal_A))
+						| ((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(Equal_B)) << 8)
+						| ((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(Equal_C)) << 16)
+						| ((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(Equal_D)) << 24);
+
+		if (Bits) return i + __builtin_ctz(Bits);
+	}
+
+	for (; i < Count; i++)
+	{
+		if (Is_Key(Words[i])) return i;
+	}
+
+	return Count;
+#else
+	return Next_Scalar(Words, Start, Count);
+#endif
+}
+
+/*******************************************************************************
+ * Compare: Compare words (as stored) with a pattern under a mask
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if every word matches
+ *
+ ******************************************************************************/
+
+bool Pattern_Search::Compare(const dword* Words, const dword* Pattern, const dword* Mask, unsigned int Length)
+{
+	for (unsigned int i = 0; i < Length; i++)
+	{
+		if ((BE32(Words[i]) & Mask[i]) != Pattern[i]) return false;
+	}
+
+	return true;
+}
+
+/*******************************************************************************
+ * Supported: Check if a path can run here
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the path was built in and the CPU has it
+ *
+ ******************************************************************************/
+
+bool Pattern_Search::Supported(Path Kernel)
+{
+	switch (Kernel)
+	{
+		case Path_Scalar:
+			return true;
+
+#ifdef PATTERN_SEARCH_X86
+#ifdef __SSE2__
+		case Path_SSE2:
+			return true;
+#endif
+		case Path_AVX2:
+			return __builtin_cpu_supports("avx2");
+#endif
+
+		default:
+			return false;
+	}
+}
+
+/*******************************************************************************
+ * Best_Path: Pick the widest path the CPU has
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the path Next uses by default
+ *
+ ******************************************************************************/
+
+Pattern_Search::Path Pattern_Search::Best_Path()
+{
+	if (Supported(Path_AVX2)) return Path_AVX2;
+	if (Supported(Path_SSE2)) return Path_SSE2;
+
+	return Path_Scalar;
+}
+
+/*******************************************************************************
+ * Path_Name: Name of a path, for the host benchmark
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the name
+ *
+ ******************************************************************************/
+
+const char* Pattern_Search::Path_Name(Path Kernel)
+{
+	switch (Kernel)
+	{
+		case Path_Scalar:	return "scalar";
+		case Path_SSE2:		return "SSE2";
+		case Path_AVX2:		return "AVX2";
+		default:			return "unknown";
+	}
+}
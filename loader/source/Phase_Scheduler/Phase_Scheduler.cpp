@@ -0,0 +1,148 @@
+/*******************************************************************************
+ * Phase_Scheduler.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class that keeps track of the phase
+ *	SoftChip::Run is in
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <ogc/video.h>
+#include <ogc/lwp_watchdog.h>
+
+#include "Phase_Scheduler.h"
+#include "Console.h"
+
+//--------------------------------------
+// Phase_Scheduler Class
+
+/*******************************************************************************
+ * Phase_Scheduler: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Phase_Scheduler::Phase_Scheduler()
+{
+	Ticks				= 0;
+	Current				= -1;
+	Current_Step		= 0;
+	Deadline			= 0;
+	Last_Activity		= 0;
+}
+
+/*******************************************************************************
+ * ~Phase_Scheduler: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Phase_Scheduler::~Phase_Scheduler() {}
+
+/*******************************************************************************
+ * Enter: Start a tick of a phase
+ * -----------------------------------------------------------------------------
+ * A phase other than the last one starts over at step 0.
+ *
+ * Return Values:
+ *	returns true on the first tick of the phase
+ *
+ ******************************************************************************/
+
+bool Phase_Scheduler::Enter(int Phase)
+{
+	if (Phase == Current) return false;
+
+	Current			= Phase;
+	Last_Activity	= 0;
+
+	Go(0);
+	return true;
+}
+
+/*******************************************************************************
+ * Go: Move the phase on to a step
+ * -----------------------------------------------------------------------------
+ * The timeout counts from now, a step may go to itself to restart it.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Phase_Scheduler::Go(int Step, unsigned int Timeout)
+{
+	Current_Step	= Step;
+	Deadline		= Timeout ? gettime() + millisecs_to_ticks(Timeout) : 0;
+}
+
+/*******************************************************************************
+ * Step: Step of the current phase
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the step
+ *
+ ******************************************************************************/
+
+int Phase_Scheduler::Step()
+{
+	return Current_Step;
+}
+
+/*******************************************************************************
+ * Expired: Check the step's timeout
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns true if the step has a timeout and it has passed
+ *
+ ******************************************************************************/
+
+bool Phase_Scheduler::Expired()
+{
+	return (Deadline && gettime() >= Deadline);
+}
+
+/*******************************************************************************
+ * Report: Show what the phase is doing
+ * -----------------------------------------------------------------------------
+ * Called every tick, a line is printed each time the activity changes.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Phase_Scheduler::Report(const char* Activity, unsigned int Percent)
+{
+	if (!Activity || Activity == Last_Activity) return;
+
+	Last_Activity = Activity;
+	Console::Instance()->Print("%s... (%u%%)\n", Activity, Percent);
+}
+
+/*******************************************************************************
+ * Tick: End the tick
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Phase_Scheduler::Tick()
+{
+	VIDEO_WaitVSync();
+	Ticks++;
+}
@@ -0,0 +1,168 @@
+/*******************************************************************************
+ * Profiler.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains the boot timeline profiler
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <ogc/lwp_watchdog.h>
+
+#include "Profiler.h"
+#include "Logger.h"
+
+extern "C" void settime(u64);
+
+//--------------------------------------
+// Profiler Class
+
+/*******************************************************************************
+ * Profiler: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Profiler::Profiler()
+{
+	Enabled	= false;
+	Offset	= 0;
+
+	Clear();
+}
+
+/*******************************************************************************
+ * ~Profiler: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+Profiler::~Profiler() {}
+
+/*******************************************************************************
+ * Now: Current time on the profiler's clock
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns timebase ticks
+ *
+ ******************************************************************************/
+
+u64 Profiler::Now()
+{
+	return gettime() + Offset;
+}
+
+/*******************************************************************************
+ * Set_Time: Set the timebase without breaking running timers
+ * -----------------------------------------------------------------------------
+ * Load_Disc sets the timebase to the wall clock for the game, which would
+ * otherwise put a jump in the middle of the trace.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Profiler::Set_Time(u64 Ticks)
+{
+	u64 Before = gettime();
+	settime(Ticks);
+
+	// Wraps around when the clock goes forward, which the addition in Now undoes
+	Offset += Before - gettime();
+}
+
+/*******************************************************************************
+ * Record: Add an event to the ring
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Profiler::Record(const char* Name, u64 Start, u64 End)
+{
+	if (!Enabled) return;
+
+	Event* Entry = &Events[Next];
+
+	Entry->Name		= Name;
+	Entry->Start	= Start;
+	Entry->End		= End;
+
+	Next = (Next + 1) % Ring_Size;
+	if (Count < Ring_Size) Count++;
+}
+
+/*******************************************************************************
+ * Clear: Drop all recorded events
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void Profiler::Clear()
+{
+	Next	= 0;
+	Count	= 0;
+}
+
+/*******************************************************************************
+ * Dump: Write the recorded events as a Chrome trace through the Logger
+ * -----------------------------------------------------------------------------
+ * Times are in microseconds from the earliest event.  Nesting is shown by
+ * the viewer from the times, so every event is on the same thread.
+ *
+ * Return Values:
+ *	returns false if disabled or the file can't be created
+ *
+ ******************************************************************************/
+
+bool Profiler::Dump(const char* Filename)
+{
+	if (!Enabled || Count == 0) return false;
+
+	Logger* Log = Logger::Instance();
+	if (!Log->OpenTrace(Filename)) return false;
+
+	unsigned int First = (Next + Ring_Size - Count) % Ring_Size;
+
+	u64 Origin = Events[First].Start;
+
+	for (unsigned int i = 0; i < Count; i++)
+	{
+		u64 Start = Events[(First + i) % Ring_Size].Start;
+		if (Start < Origin) Origin = Start;
+	}
+
+	Log->Trace("{\"traceEvents\":[\n");
+
+	for (unsigned int i = 0; i < Count; i++)
+	{
+		const Event* Entry = &Events[(First + i) % Ring_Size];
+
+		Log->Trace("{\"name\":\"%s\",\"cat\":\"boot\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":1}%s\n",
+			Entry->Name,
+			(unsigned long long)ticks_to_microsecs(Entry->Start - Origin),
+			(unsigned long long)ticks_to_microsecs(Entry->End - Entry->Start),
+			(i + 1 < Count) ? "," : "");
+	}
+
+	Log->Trace("],\"displayTimeUnit\":\"ms\"}\n");
+	Log->CloseTrace();
+
+	return true;
+}
@@ -23,12 +23,43 @@
 #include "WiiDisc.h"
 #include "Apploader.h"
 #include "cIOS.h"
+#include "IOS_Inventory.h"
 
 #include "SoftChip.h"
 
 // static void Silent_Report(const char* Args, ...){}		// Blank apploader reporting function
 
-extern "C" void settime(u64);
+namespace
+{
+	// A cleared DMA buffer from the pool, for the current Buffer_Scope
+	void* Boot_Buffer(unsigned int Length)
+	{
+		void* Buffer = Buffer_Pool::Instance()->Alloc(Length);
+		if (!Buffer) throw "Out of I/O buffers";
+
+		memset(Buffer, 0, Length);
+		return Buffer;
+	}
+
+	// Choices of the "Stop the drive after" option, in minutes
+	const byte Spin_Down_Minutes[] = { 0, 1, 5, 15 };
+	const int Spin_Down_Choices = sizeof(Spin_Down_Minutes) / sizeof(Spin_Down_Minutes[0]);
+
+	// Choices of the "Disc cache" option, in 32 KiB clusters
+	const byte Cache_Sizes[] = { 0, 8, 16, 32, 64 };
+	const int Cache_Choices = sizeof(Cache_Sizes) / sizeof(Cache_Sizes[0]);
+
+	// Name of an IOS in the IOS menu, with its revision once known
+	string IOS_Label(const IOS_Inventory::Entry& Entry)
+	{
+		char Buffer[32];
+
+		if (Entry.Known) sprintf(Buffer, "IOS%u (Rev %u) ", Entry.Title, Entry.Revision);
+		else sprintf(Buffer, "IOS%u ", Entry.Title);
+
+		return string(Buffer);
+	}
+}
 
 //--------------------------------------
 // SoftChip Class
@@ -44,19 +75,32 @@ extern "C" void settime(u64);
 SoftChip::SoftChip()
 {
 	// Classes
-    DI						= DIP::Instance();
+    Drive					= DIP::Instance();
+    DI						= Drive;
     Controls				= Input::Instance();
 	Out						= Console::Instance();
 	Cfg						= Configuration::Instance();
 	Log						= Logger::Instance();
 	SD						= Storage::Instance();
+	Patch					= Patcher::Instance();
+	Prof					= Profiler::Instance();
+	Cache					= Coherency::Instance();
+	Pool					= Buffer_Pool::Instance();
+	Bundle					= Boot_Bundle::Instance();
+	Probe					= Disc_Probe::Instance();
+	Scheduler				= Phase_Scheduler::Instance();
 
 	// Flags
     Standby_Flag			= false;
     Reset_Flag				= false;
 	Skip_AutoBoot			= false;
+	Image_Selected			= false;
+	Image_Used				= false;
 	Log->ShowTime			= true;
 
+	// Menus
+	oLang = oPCS = oMode = oIOS = oLRI = oSAM = oBoot = oSlnt = oLogg = oSpin = oImg = oCach = oSelect = 0;
+
 	// Video
     framebuffer				= 0;
     vmode					= 0;
@@ -124,6 +168,18 @@ SoftChip::SoftChip()
 		//Out->Print("Configuration loaded.\n\n");
 	}
 
+	// Patch database, compiled for each game by Patcher::Prepare
+	Patch->Load_Database(ConfigData::Default_PatchFile);
+
+	// Boot timeline, written next to the log
+	Prof->Enabled = Cfg->Data.Logging;
+
+	// The drive keeps spinning between the phases
+	Drive->Spin.Idle_Timeout = Cfg->Data.Spin_Down * 60000;
+
+	// Reserved when DIP is initialized
+	Drive->Cache.Size = Cfg->Data.Cache_Clusters;
+
 	// Save IOS Position
 	Cursor_IOS = Out->Save_Cursor();
 
@@ -144,6 +200,10 @@ SoftChip::~SoftChip(){}
 /*******************************************************************************
  * Run: Heart of SoftChip's Logic
  * -----------------------------------------------------------------------------
+ * Ticks once per frame: the input is read, and the phase does one step's work
+ * without waiting for a key or the drive.  Only reloading the IOS and loading
+ * the game, up to the jump, take longer than a frame.
+ *
  * Return Values:
  *	returns void
  *
@@ -153,65 +213,348 @@ void SoftChip::Run()
 {
 	while (true)
 	{
-		if (NextPhase == Phase_IOS)
+		// Power and Reset buttons
+		VerifyFlags();
+
+		// Input
+		Controls->Scan();
+
+		Scheduler->Enter(NextPhase);
+
+		switch (NextPhase)
 		{
-			// Load IOS
-			Load_IOS();
+			case Phase_IOS:
+				// Load IOS
+				Load_IOS();
+				break;
+
+			case Phase_Menu:
+				Tick_Menu();
+				break;
+
+			case Phase_SelectIOS:
+				// Select another IOS
+				if (Scheduler->Step() == Step_Enter)
+				{
+					Show_IOSMenu();
+					Scheduler->Go(Step_Input);
+				}
+				else Update_IOSMenu();
+				break;
+
+			case Phase_Play:
+				Tick_Play();
+				break;
+
+			case Phase_Show_Disclaimer:
+				Tick_Disclaimer();
+				break;
 		}
 
-		if (NextPhase == Phase_Menu)
-		{
+		// Stop the motor once the drive has been idle long enough
+		if (Probe->Poll() != Disc_Probe::Stage_Running) Drive->Idle();
+
+		Scheduler->Tick();
+	}
+
+	Exit_Loader();
+}
+
+/*******************************************************************************
+ * Preflight_IOS: Read the IOS the game requests, before the IOS is loaded
+ * -----------------------------------------------------------------------------
+ * Uses the IOS the loader runs under.  Without a disc, the game's IOS is
+ * loaded after the disc is opened, as before.
+ *
+ * Return Values:
+ *	returns true if the IOS was read
+ *
+ ******************************************************************************/
+
+bool SoftChip::Preflight_IOS(byte* IOS)
+{
+	Scoped_Timer Timer("Preflight_IOS");
+
+	try
+	{
+		bool Inserted = false;
+
+		if (!DI->Initialize()) return false;
+		if (DI->Verify_Cover(&Inserted) < 0 || !Inserted) return false;
+
+		static dvddiskid Disc_ID __attribute__((aligned(0x20)));
+
+		DI->Reset();
+		if (DI->Read_DiscID(&Disc_ID) < 0) return false;
+
+		if (!Wii_Disc::Read_Requested_IOS(DI, IOS)) return false;
+	}
+	catch (const char* Message)
+	{
+		return false;
+	}
+
+	Out->SetColor(Color_Green, false);
+	Out->Print("[+] The game requests IOS %u\n", *IOS);
+
+	return true;
+}
+
+/*******************************************************************************
+ * Tick_Menu: One frame of the Main Menu phase
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void SoftChip::Tick_Menu()
+{
+	switch (Scheduler->Step())
+	{
+		case Step_Enter:
+			// Spin up and open the disc while the menu or the countdown is shown
+			if (!Probe->Started())
+			{
+				Bundle->Begin();
+				Probe->Start(DI);
+			}
+
 			// Handle Autoboot
-			if (Skip_AutoBoot || !Cfg->Data.AutoBoot || Reset_Flag || Controls->Wait_ButtonPress(&Controls->Menu, 2))
+			if (Skip_AutoBoot || !Cfg->Data.AutoBoot || Reset_Flag)
 			{
 				Show_Menu();
+				Scheduler->Go(Step_Input);
 			}
 			else
 			{
-				NextPhase = Phase_Play;
+				Scheduler->Go(Step_Countdown, Autoboot_Delay);
 			}
 
 			// AutoBoot Done
 			Skip_AutoBoot = true;
 			Reset_Flag = false;
-		}
-
-		if (NextPhase == Phase_SelectIOS)
-		{
-			// Select another IOS
-			Show_IOSMenu();
-		}
+			break;
 
-		if (NextPhase == Phase_Play)
-		{
-			// Handle Silent
-			Out->SetSilent(Cfg->Data.Silent);
+		case Step_Countdown:
+			if (Controls->Menu.Active)
+			{
+				Show_Menu();
+				Scheduler->Go(Step_Input);
+			}
+			else if (Scheduler->Expired())
+			{
+				NextPhase = Phase_Play;
+			}
+			break;
 
-			// Initialize Default Logger
-			Log->OpenLog(ConfigData::Default_LogFile);
-			Log->Write("---------------------\r\n");
-			Log->Write("Loading Disc...\r\n");
+		case Step_Input:
+			Update_Menu();
+			break;
+	}
+}
 
-			// Run Game
-			Load_Disc();
-		}
+/*******************************************************************************
+ * Tick_Disclaimer: One frame of the Disclaimer phase
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
 
-		if (NextPhase == Phase_Show_Disclaimer)
-		{
+void SoftChip::Tick_Disclaimer()
+{
+	switch (Scheduler->Step())
+	{
+		case Step_Enter:
 			Out->Print_Disclaimer();
 			Out->SetColor(Color_White, false);
-			Controls->Press_AnyKey("Press any key to view help screen ...");
+			Out->Print("Press any key to view help screen ...");
+			Scheduler->Go(Step_Help);
+			break;
+
+		case Step_Help:
+			if (!Controls->Any.Active) break;
+
 			Out->Print_Help();
 			Out->SetColor(Color_White, false);
-			Controls->Press_AnyKey("Press any key to return ...");
+			Out->Print("Press any key to return ...");
+			Scheduler->Go(Step_Return);
+			break;
+
+		case Step_Return:
+			if (!Controls->Any.Active) break;
+
 			Out->SetColor(Color_White, false);
 			Out->Reprint();
 
 			NextPhase = Phase_Menu;
-		}
+			break;
 	}
+}
 
-	Exit_Loader();
+/*******************************************************************************
+ * Tick_Play: One frame of the Play phase
+ * -----------------------------------------------------------------------------
+ * Waits for the probe thread to open the disc, asks for a disc if there's
+ * none, and gives up on a drive that doesn't answer.  (B) returns to the menu
+ * meanwhile.  The load itself starts once the thread is done.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void SoftChip::Tick_Play()
+{
+	switch (Scheduler->Step())
+	{
+		case Step_Enter:
+			// Handle Silent
+			Out->SetSilent(Cfg->Data.Silent);
+
+			// The disc image was switched on or off in the menu, once the probe of the other source is done
+			if (Cfg->Data.Use_Image != Image_Selected)
+			{
+				if (!Probe->Cancel())
+				{
+					Scheduler->Go(Step_Probe, Probe_Timeout);
+					break;
+				}
+
+				Select_Source();
+			}
+
+			// Probe again if it ended without a disc, a disc may have been inserted since
+			if (Probe->Started() && Probe->Poll() != Disc_Probe::Stage_Running && Probe->Poll() != Disc_Probe::Stage_Opened)
+			{
+				Probe->Claim();
+			}
+
+			if (!Probe->Started())
+			{
+				Bundle->Begin();
+				Probe->Start(DI);
+			}
+
+			Scheduler->Go(Step_Probe, Probe_Timeout);
+			break;
+
+		case Step_Probe:
+			// The probe was of the other source, the source is switched now
+			if (Cfg->Data.Use_Image != Image_Selected && Probe->Poll() != Disc_Probe::Stage_Running)
+			{
+				Scheduler->Go(Step_Enter);
+				break;
+			}
+
+			switch (Probe->Poll())
+			{
+				case Disc_Probe::Stage_Running:
+					if (Controls->Cancel.Active)
+					{
+						// It stops after the command being sent
+						Probe->Stop();
+						NextPhase = Phase_Menu;
+					}
+					else if (Scheduler->Expired())
+					{
+						Out->SetSilent(false);
+						Out->PrintErr("[-] The drive isn't answering (%s).\n", Probe->Activity ? Probe->Activity : "Verify_Cover");
+						Out->Print("Press the (B) button to return to the main menu.\n");
+						Scheduler->Go(Step_Hung);
+					}
+					else
+					{
+						Scheduler->Report(Probe->Activity, Probe->Steps_Done * 100 / Disc_Probe::Steps_Total);
+					}
+					break;
+
+				case Disc_Probe::Stage_No_Disc:
+					Ask_Disc();
+					break;
+
+				default:
+					// The probe may have been reading from SD, it's done
+					Cfg->Save(ConfigData::Default_ConfigFile);
+
+					// Initialize Default Logger
+					Log->OpenLog(ConfigData::Default_LogFile);
+					Prof->Enabled = Cfg->Data.Logging;
+					Log->Write("---------------------\r\n");
+					Log->Write("Loading Disc...\r\n");
+
+					// Run Game
+					Load_Disc();
+					break;
+			}
+			break;
+
+		case Step_No_Disc:
+			if (Controls->Cancel.Active)
+			{
+				Probe->Stop();
+				NextPhase = Phase_Menu;
+				break;
+			}
+
+			// A probe is running
+			if (Probe->Poll() == Disc_Probe::Stage_Running) break;
+
+			// It found a disc, or failed: it's loaded, or the load shows why
+			if (Probe->Poll() != Disc_Probe::Stage_No_Disc && Probe->Poll() != Disc_Probe::Stage_Idle)
+			{
+				Scheduler->Go(Step_Probe, Probe_Timeout);
+				break;
+			}
+
+			if (Scheduler->Expired())
+			{
+				Probe->Claim();
+				Bundle->Begin();
+				Probe->Start(DI);
+				Scheduler->Go(Step_No_Disc, Disc_Retry);
+			}
+			break;
+
+		case Step_Hung:
+			// A late answer continues the load
+			if (Probe->Poll() != Disc_Probe::Stage_Running)
+			{
+				Scheduler->Go(Step_Probe, Probe_Timeout);
+			}
+			else if (Controls->Cancel.Active)
+			{
+				Probe->Stop();
+				NextPhase = Phase_Menu;
+			}
+			else if (Controls->Exit.Active)
+			{
+				Exit_Loader();
+			}
+			break;
+
+		case Step_Failed:
+			// Return to IOS Loading, if another IOS was loaded, because it was requested, this is needed
+			if (Controls->Any.Active) NextPhase = Phase_IOS;
+			break;
+	}
+}
+
+/*******************************************************************************
+ * Ask_Disc: Ask for a disc, the Play phase probes again until there's one
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void SoftChip::Ask_Disc()
+{
+	Out->SetSilent(false);
+	Out->Print("Please insert a Disc.\n");
+	Out->Print("Press the (B) button to return to the main menu.\n");
+	Scheduler->Go(Step_No_Disc, Disc_Retry);
 }
 
 /*******************************************************************************
@@ -224,6 +567,21 @@ void SoftChip::Run()
 
 void SoftChip::Load_IOS()
 {
+	Scoped_Timer Timer("Load_IOS");
+
+	// Whatever the probe opened goes away with the IOS, it may be reading from SD
+	if (!Probe->Cancel())
+	{
+		// The IOS can't be reloaded under a command the drive hasn't answered
+		Out->PrintErr("[-] The drive isn't answering, the IOS can't be reloaded.\n");
+		NextPhase = Phase_Menu;
+		return;
+	}
+
+	// The game's IOS, so it's loaded right away instead of after the disc is opened
+	byte Requested	= 0;
+	bool Preflight	= Cfg->Data.Load_requested_IOS && Preflight_IOS(&Requested);
+
 	// Release FAT and Wiimotes
 	SD->Release_FAT();
 	Controls->Terminate();
@@ -234,9 +592,10 @@ void SoftChip::Load_IOS()
 	try
 	{
 		// Close it or the game will hang after the second Load_IOS()
-		DI->Close();
+		if (DI != Drive) DI->Close();
+		Drive->Close();
 
-		IOS_Version = Cfg->Data.IOS;
+		IOS_Version = Preflight ? Requested : Cfg->Data.IOS;
 		
 		if (IOS_Version == IOS_GetVersion())
 		{
@@ -244,12 +603,23 @@ void SoftChip::Load_IOS()
 			IOS_Loaded = true;
 		} else
 		{
+			Scoped_Timer Reload_Timer("IOS_ReloadIOS");
 			IOS_Loaded = !(IOS_ReloadIOS(IOS_Version) < 0);
 		}
 
+		// The game's IOS may not be installed, the selected one comes first then
+		if (!IOS_Loaded && Preflight && IOS_Version != Cfg->Data.IOS)
+		{
+			Out->PrintErr("Error Loading IOS %d!\n", IOS_Version);
+			Out->PrintErr("Trying the selected IOS %d...\n", Cfg->Data.IOS);
+
+			IOS_Version = Cfg->Data.IOS;
+			IOS_Loaded = (IOS_Version == IOS_GetVersion()) || !(IOS_ReloadIOS(IOS_Version) < 0);
+		}
+
 		if (!IOS_Loaded)
 		{
-			Out->PrintErr("Error Loading IOS %d!\n", Cfg->Data.IOS);
+			Out->PrintErr("Error Loading IOS %d!\n", IOS_Version);
 			Out->PrintErr("Trying Default IOS %d...\n", Default_IOS);
 
 			IOS_Version = Default_IOS;
@@ -267,14 +637,14 @@ void SoftChip::Load_IOS()
 			throw "Error Loading IOS";
 		}
 
-		if (!DI->Initialize())
+		if (!Drive->Initialize())
 		{
 			Out->PrintErr("[-] Error Initializing DIP-Module.\n");
 			throw "Error Initializing DIP";
 		}
 
-		// Stop Motor
-		DI->Stop_Motor();
+		// Stop Motor, unless the preflight spun the disc up for the probe
+		if (!Preflight) Drive->Stop_Motor();
 
 		// Continue
 		NextPhase = Phase_Menu;
@@ -286,8 +656,11 @@ void SoftChip::Load_IOS()
 	}
 
 	// Re-Init FAT and Wiimotes
-	SD->Initialize_FAT();
-	Controls->Initialize();
+	{
+		Scoped_Timer FAT_Timer("Initialize_FAT");
+		SD->Initialize_FAT();
+		Controls->Initialize();
+	}
 
 	// Verify FAT
 	if (!SD->Verify_FAT())
@@ -296,12 +669,105 @@ void SoftChip::Load_IOS()
 		Out->Print("[Warning] No Storage Device was found. Configuration won't be saved.\n");
 	}
 
+	// The drive, or the disc image if enabled
+	Select_Source();
+
 	// Reset Color and Save Menu Position
 	Out->Print("\n");
 	Out->SetColor(Color_White, false);
 	Cursor_Menu = Out->Save_Cursor();
 }
 
+/*******************************************************************************
+ * Select_Source: Choose what the loader reads the game from
+ * -----------------------------------------------------------------------------
+ * The disc image is only used if enabled in the menu.  Only the loader reads
+ * it, the game reads the disc in the drive, so Verify_Image refuses an image
+ * that isn't the game in the drive.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void SoftChip::Select_Source()
+{
+	Disc_Source* Source = Drive;
+
+	Image_Selected	= Cfg->Data.Use_Image;
+	Image_Used		= false;
+
+	if (!Image_Selected)
+	{
+		Disc_Image::Instance()->Close();
+	}
+	else if (Disc_Image::Instance()->Open(ConfigData::Default_ImageFile))
+	{
+		Source		= Disc_Image::Instance();
+		Image_Used	= true;
+
+		Out->SetColor(Color_Yellow, false);
+		Out->Print("[Warning] Loading the game from the disc image %s\n", ConfigData::Default_ImageFile);
+		Out->Print("[Warning] The game still reads the disc in the drive, it has to be the same game.\n");
+	}
+	else
+	{
+		Out->SetColor(Color_Yellow, false);
+		Out->Print("[Warning] No disc image in %s, loading from the drive.\n", ConfigData::Default_ImageFile);
+	}
+
+	// Serve boots from their bundles on SD, if the folder was created
+	if (Bundle->Open(ConfigData::Bundle_Folder, Source))
+	{
+		Source = Bundle;
+		Out->SetColor(Color_Green, false);
+		Out->Print("[+] Using boot bundles in %s\n", ConfigData::Bundle_Folder);
+	}
+
+	Out->SetColor(Color_White, false);
+	DI = Source;
+}
+
+/*******************************************************************************
+ * Verify_Image: Check the drive holds the disc image's game
+ * -----------------------------------------------------------------------------
+ * The game is started on the drive's disc, so it's reset and identified under
+ * the IOS the game gets, and its ID has to be the one in Memory::Disc_ID.
+ *
+ * Return Values:
+ *	returns void, throws if the disc doesn't match
+ *
+ ******************************************************************************/
+
+void SoftChip::Verify_Image()
+{
+	static dvddiskid Drive_ID __attribute__((aligned(0x20)));
+	bool Inserted = false;
+
+	Out->Print("Checking the disc in the drive...\n");
+
+	if (Drive->Verify_Cover(&Inserted) < 0) throw "Verify_Cover failed";
+
+	if (!Inserted)
+	{
+		Out->PrintErr("[-] The disc image needs the game's disc in the drive.\n");
+		throw "No disc for the disc image";
+	}
+
+	memset(&Drive_ID, 0, sizeof(Drive_ID));
+
+	if (Drive->Reset() < 0 || Drive->Read_DiscID(&Drive_ID) < 0) throw "Error reading the drive's disc ID";
+
+	// Game code, maker code, disc number and version
+	if (memcmp(&Drive_ID, (void*)Memory::Disc_ID, 8) != 0)
+	{
+		Out->PrintErr("[-] The disc in the drive isn't the disc image's game.\n");
+		throw "Disc image doesn't match the disc";
+	}
+
+	Out->Print("[+] The disc in the drive matches the disc image.\n");
+}
+
 /*******************************************************************************
  * Show_Menu: SoftChip Main Menu
  * -----------------------------------------------------------------------------
@@ -312,9 +778,17 @@ void SoftChip::Load_IOS()
 
 void SoftChip::Show_Menu()
 {
-	std::string Languages[]	= { "Auto Force Language", "System Default", "Japanese", "English", "German", "French", "Spanish", "Italian", "Dutch", "S. Chinese", "T. Chinese", "Korean" };
-	std::string VModes[] = { "Force Wii Region", "Disc Region(default)" };
-	std::string BoolOption[] = { "Disabled", "Enabled" };
+	static std::string Languages[]	= { "Auto Force Language", "System Default", "Japanese", "English", "German", "French", "Spanish", "Italian", "Dutch", "S. Chinese", "T. Chinese", "Korean" };
+	static std::string VModes[] = { "Force Wii Region", "Disc Region(default)" };
+	static std::string BoolOption[] = { "Disabled", "Enabled" };
+	static std::string SpinDown[] = { "At once", "1 minute", "5 minutes", "15 minutes" };
+	static std::string CacheSize[] = { "Disabled", "256 KiB", "512 KiB", "1 MiB", "2 MiB" };
+
+	int Spin_Down = 0;
+	while (Spin_Down < Spin_Down_Choices - 1 && Spin_Down_Minutes[Spin_Down] < Cfg->Data.Spin_Down) Spin_Down++;
+
+	int Cache_Size = 0;
+	while (Cache_Size < Cache_Choices - 1 && Cache_Sizes[Cache_Size] < Cfg->Data.Cache_Clusters) Cache_Size++;
 
 	// Restore Menu Position
 	Out->Restore_Cursor(Cursor_Menu);
@@ -330,67 +804,87 @@ void SoftChip::Show_Menu()
 	Out->SetColor(Color_White, false);
 
 	Out->CreateMenu();
-	Console::Option *oLang = Out->CreateOption("Game's Language: ", Languages, 12, Cfg->Data.Language + 2);
-	Console::Option *oPCS  = Out->CreateOption("Patch Country Strings: ", BoolOption, 2, Cfg->Data.Country_String_Patching);
-	Console::Option *oMode = Out->CreateOption("Set Video Mode using: ", VModes, 2, !Cfg->Data.SysVMode);
+	oLang = Out->CreateOption("Game's Language: ", Languages, 12, Cfg->Data.Language + 2);
+	oPCS  = Out->CreateOption("Patch Country Strings: ", BoolOption, 2, Cfg->Data.Country_String_Patching);
+	oMode = Out->CreateOption("Set Video Mode using: ", VModes, 2, !Cfg->Data.SysVMode);
 	//Console::Option *o002  = Out->CreateOption("Remove 002 Protection: ", BoolOption, 2, Cfg->Data.Remove_002);
-	Console::Option *oIOS  = Out->CreateOption("Fake IOS version: ", BoolOption, 2, Cfg->Data.Fake_IOS_Version);
-	Console::Option *oLRI  = Out->CreateOption("Load requested IOS: ", BoolOption, 2, Cfg->Data.Load_requested_IOS);
-	Console::Option *oSAM  = Out->CreateOption("Sam & Max fix: ", BoolOption, 2, Cfg->Data.SamNMaxFix);
+	oIOS  = Out->CreateOption("Fake IOS version: ", BoolOption, 2, Cfg->Data.Fake_IOS_Version);
+	oLRI  = Out->CreateOption("Load requested IOS: ", BoolOption, 2, Cfg->Data.Load_requested_IOS);
+	oSAM  = Out->CreateOption("Sam & Max fix: ", BoolOption, 2, Cfg->Data.SamNMaxFix);
 	
-	Console::Option *oBoot = Out->CreateOption("Autoboot: ", BoolOption, 2, Cfg->Data.AutoBoot);
-	Console::Option *oSlnt = Out->CreateOption("Silent: ", BoolOption, 2, Cfg->Data.Silent);
-	Console::Option *oLogg = Out->CreateOption("Logging: ", BoolOption, 2, Cfg->Data.Logging);
+	oBoot = Out->CreateOption("Autoboot: ", BoolOption, 2, Cfg->Data.AutoBoot);
+	oSlnt = Out->CreateOption("Silent: ", BoolOption, 2, Cfg->Data.Silent);
+	oLogg = Out->CreateOption("Logging: ", BoolOption, 2, Cfg->Data.Logging);
+	oSpin = Out->CreateOption("Stop the drive after: ", SpinDown, Spin_Down_Choices, Spin_Down);
+	oImg  = Out->CreateOption("Load from the disc image: ", BoolOption, 2, Cfg->Data.Use_Image);
+	oCach = Out->CreateOption("Disc cache: ", CacheSize, Cache_Choices, Cache_Size);
+}
 
-    while (true)
-    {
-        // Input
-		Controls->Scan();
+/*******************************************************************************
+ * Update_Menu: Handle one frame of input of the Main Menu
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
 
-		// Return to HBC
-        if (Controls->Exit.Active)
-		{
-			Out->Print("Returning...\n");
-			Cfg->Save(ConfigData::Default_ConfigFile);
-            Exit_Loader();
-		}
+void SoftChip::Update_Menu()
+{
+	// Return to HBC
+	if (Controls->Exit.Active)
+	{
+		Out->Print("Returning...\n");
 
-		// Run Game
-        if (Controls->Accept.Active)
-        {
-			Cfg->Save(ConfigData::Default_ConfigFile);
-            NextPhase = Phase_Play;
-			return;
-        }
+		// A probe stuck on the drive is left behind
+		Probe->Cancel();
+		Cfg->Save(ConfigData::Default_ConfigFile);
+		Exit_Loader();
+	}
 
-		// Select IOS
-		if (Controls->Plus.Active)
+	// Run Game, the probe is waited for by the Play phase
+	if (Controls->Accept.Active)
+	{
+		NextPhase = Phase_Play;
+		return;
+	}
+
+	// Select IOS
+	if (Controls->Plus.Active)
+	{
+		// The IOS menu uses the pool, and likely reloads the IOS
+		if (!Probe->Cancel())
 		{
-			NextPhase = Phase_SelectIOS;
+			Out->PrintErr("[-] The drive is busy (%s), try again once it's done.\n", Probe->Activity ? Probe->Activity : "Verify_Cover");
 			return;
 		}
 
-		if (Controls->Info.Active)
-		{
-			NextPhase = Phase_Show_Disclaimer;
-			return;
-		}		
+		NextPhase = Phase_SelectIOS;
+		return;
+	}
 
-		// Update Menu
-		Out->UpdateMenu(Controls);
-		Cfg->Data.Language = oLang->Index - 2;
-		Cfg->Data.SysVMode = !oMode->Index;
-		Cfg->Data.AutoBoot = oBoot->Index;
-		Cfg->Data.Silent = oSlnt->Index;
-		Cfg->Data.Logging = oLogg->Index;
-		//Cfg->Data.Remove_002 = o002->Index;
-		Cfg->Data.Fake_IOS_Version = oIOS->Index;
-		Cfg->Data.Load_requested_IOS = oLRI->Index;
-		Cfg->Data.Country_String_Patching = oPCS->Index;
-		Cfg->Data.SamNMaxFix = oSAM->Index;
-		VerifyFlags();
-        VIDEO_WaitVSync();
-    }
+	if (Controls->Info.Active)
+	{
+		NextPhase = Phase_Show_Disclaimer;
+		return;
+	}		
+
+	// Update Menu
+	Out->UpdateMenu(Controls);
+	Cfg->Data.Language = oLang->Index - 2;
+	Cfg->Data.SysVMode = !oMode->Index;
+	Cfg->Data.AutoBoot = oBoot->Index;
+	Cfg->Data.Silent = oSlnt->Index;
+	Cfg->Data.Logging = oLogg->Index;
+	//Cfg->Data.Remove_002 = o002->Index;
+	Cfg->Data.Fake_IOS_Version = oIOS->Index;
+	Cfg->Data.Load_requested_IOS = oLRI->Index;
+	Cfg->Data.Country_String_Patching = oPCS->Index;
+	Cfg->Data.SamNMaxFix = oSAM->Index;
+	Cfg->Data.Spin_Down = Spin_Down_Minutes[oSpin->Index];
+	Drive->Spin.Idle_Timeout = Cfg->Data.Spin_Down * 60000;
+	Cfg->Data.Use_Image = oImg->Index;
+	Cfg->Data.Cache_Clusters = Cache_Sizes[oCach->Index];
+	Drive->Cache.Size = Cfg->Data.Cache_Clusters;
 }
 
 /*******************************************************************************
@@ -408,21 +902,15 @@ void SoftChip::Show_IOSMenu()
 
 	dword i, Count = 0;
 	dword Cfg_IOS = 0;
-	char Buffer[32];
-
-	signed_blob *TMD = NULL;
-	tmd *t = NULL;
-	u32 TMD_size = 0;
-	u64 title_id = 0;
-	int ret;
 
 	// Get a list of Valid IOSes
 	cIOS *IOS = cIOS::Instance();
+	IOS_Inventory *Inventory = IOS_Inventory::Instance();
 	IOS->List_SysTitles();
 
-	// Declare Lists
-	string List[IOS->SysTitles.size()];
-	char nList[IOS->SysTitles.size()];
+	// Declare Lists, kept for the ticks of the menu
+	IOS_Names.clear();
+	IOS_Numbers.clear();
 	
 	// Fill the List
 	for (i = 0; i < IOS->SysTitles.size(); i++)
@@ -438,26 +926,17 @@ void SoftChip::Show_IOSMenu()
 
 			default:	// Valid IOS
 				if (IOS->SysTitles[i] == Cfg->Data.IOS) Cfg_IOS = Count;
-				nList[Count] = IOS->SysTitles[i];
-				
-				// Get tmd to determine the version of the IOS
-				title_id = (((u64)(1) << 32) | (IOS->SysTitles[i]));
-				ret = IOS->GetTMD(title_id, &TMD, &TMD_size);
-				
-				if (ret == 0)
-				{
-					t = (tmd*)SIGNATURE_PAYLOAD(TMD);
-					sprintf(Buffer, "IOS%u (Rev %u) ", IOS->SysTitles[i], t->title_version);
-				} else
-				{
-					sprintf(Buffer, "IOS%u ", IOS->SysTitles[i]);
-				}
-				free(TMD);
-				List[Count] = string(Buffer);
+				IOS_Numbers.push_back(IOS->SysTitles[i]);
 				Count++;
 		}
 	}
 
+	// Revisions come from the inventory, the TMDs are read as the menu is shown
+	Inventory->Update(ConfigData::Default_InventoryFile, IOS_Numbers);
+
+	for (i = 0; i < Count; i++)
+		IOS_Names.push_back(IOS_Label(Inventory->Get(i)));
+
 	// Restore Menu Position
 	Out->Restore_Cursor(Cursor_Menu);
 	Out->SetSilent(false);
@@ -472,34 +951,46 @@ void SoftChip::Show_IOSMenu()
 	Out->SetColor(Color_White, false);
 
 	Out->CreateMenu();
-	Console::Option *oIOS = Out->CreateOption("SoftChip will use: ", List, Count, Cfg_IOS);
+	oSelect = Count ? Out->CreateOption("SoftChip will use: ", &IOS_Names[0], Count, Cfg_IOS) : 0;
+}
 
-	while (true)
+/*******************************************************************************
+ * Update_IOSMenu: Handle one frame of input of the IOS Menu
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void SoftChip::Update_IOSMenu()
+{
+	IOS_Inventory *Inventory = IOS_Inventory::Instance();
+
+	// Load IOS
+	if (Controls->Accept.Active && oSelect)
 	{
-		// Update Input
-		Controls->Scan();
+		NextPhase = Phase_IOS;
+		Cfg->Data.IOS = IOS_Numbers[oSelect->Index];
+		Inventory->Save(ConfigData::Default_InventoryFile);
+		return;
+	}
+	
+	// Abort
+	if (Controls->Cancel.Active)
+	{
+		NextPhase = Phase_Menu;
+		Inventory->Save(ConfigData::Default_InventoryFile);
+		return;		
+	}
 
-		// Load IOS
-		if (Controls->Accept.Active)
-		{
-            NextPhase = Phase_IOS;
-			Cfg->Data.IOS = nList[oIOS->Index];
-			return;
-		}
-		
-		// Abort
-		if (Controls->Cancel.Active)
-		{
-			NextPhase = Phase_Menu;
-			return;		
-		}
+	// One TMD per frame: the selected IOS once a session, otherwise a stale one
+	int Index = Inventory->Next_Stale();
+	if (oSelect && !Inventory->Get(oSelect->Index).Seen) Index = oSelect->Index;
 
-		// Update Menu
-		Out->UpdateMenu(Controls);
+	if (Index >= 0 && Inventory->Refresh(Index)) IOS_Names[Index] = IOS_Label(Inventory->Get(Index));
 
-		VerifyFlags();
-        VIDEO_WaitVSync();
-    }
+	// Update Menu
+	Out->UpdateMenu(Controls);
 }
 
 /*******************************************************************************
@@ -512,53 +1003,71 @@ void SoftChip::Show_IOSMenu()
 
 void SoftChip::Load_Disc()
 {
-    static Wii_Disc::Header					Header			__attribute__((aligned(0x20)));
-    static Wii_Disc::Partition_Descriptor	Descriptor		__attribute__((aligned(0x20)));
-    static Wii_Disc::Partition_Info			Partition_Info	__attribute__((aligned(0x20)));
-	static Apploader::Header				Loader			__attribute__((aligned(0x20)));
+	u64 Load_Start = Prof->Now();
+
+	// The disc may have been opened while the menu was shown, unless the drive was stopped since
+	bool Probed		= (Probe->Claim() == Disc_Probe::Stage_Opened);
+	bool Stopped	= Probed && !Image_Used && !Drive->Spin.Spinning();
 
-    memset(&Header, 0, sizeof(Wii_Disc::Header));
-    memset(&Descriptor, 0, sizeof(Wii_Disc::Partition_Descriptor));
-    memset(&Partition_Info, 0, sizeof(Wii_Disc::Partition_Info));
+	// Set Clock, the probe's thread is done with the profiler's clock
+	Prof->Set_Time(secs_to_ticks(time(NULL) - 946684800));
 
-	// Set Clock
-	settime(secs_to_ticks(time(NULL) - 946684800));
+	if (Stopped) Probed = false;
+
+	// The probe is done with the cache, a size chosen in the menu applies from here
+	Drive->Cache.Initialize();
+
+	// Otherwise reads are recorded for the bundle from here
+	if (!Probed) Bundle->Begin();
+
+	// The probe's buffers are kept across boots, outside the boot's scope
+	Probe->Initialize();
 
     try
     {
+		// The I/O buffers of the boot come from the pool in MEM2, and go back to it if the boot fails
+		Buffer_Scope		Boot_Buffers;
+		Apploader::Header&	Loader	= *(Apploader::Header*)Boot_Buffer(sizeof(Apploader::Header));
+
 		bool Disc_Inserted = false;
 
-		if (DI->Verify_Cover(&Disc_Inserted) < 0)
-		{
-			throw "Verify_Cover failed";
-		}
-		
-		if (!Disc_Inserted)
+		// The partition is opened again after the reset
+		if (Stopped) DI->Close_Partition();
+
+		if (!Probed)
 		{
-			Out->SetSilent(false);
-			Out->Print("Please insert a Disc.\n");
-			DI->Wait_CoverClose();
+			{
+				Scoped_Timer Cover_Timer("Verify_Cover");
+
+				if (DI->Verify_Cover(&Disc_Inserted) < 0)
+				{
+					throw "Verify_Cover failed";
+				}
+			}
+
+			// Tick_Play waits for a disc, and probes again
+			if (!Disc_Inserted)
+			{
+				Ask_Disc();
+				return;
+			}
 		}
 
 		Out->Print("Loading Game...\n");
 
-		DI->Reset();
+		// Spin-up, disc ID, header, partition table, ticket and Open_Partition
+		if (!Probed) Probe->Open(DI);
 
-        // Read the discID into the memory
-		memset((dvddiskid *)(Memory::Disc_ID), 0, 0x20);
-		DI->Read_DiscID((dvddiskid *)(Memory::Disc_ID));
+		Log->Write("Disc probe: %s\r\n", Probed ? "opened while the menu was shown" : (Probe->Error ? Probe->Error : "not done"));
+
+		// Read the discID into the memory
+		memcpy((void*)Memory::Disc_ID, &Probe->Disc_ID, 0x20);
+
+		Wii_Disc::Header&			Header			= *Probe->Header;
+		Wii_Disc::Partition_Info&	Partition_Info	= Probe->Partition;
 
-		if (*(dword*)(Memory::Disc_ID) == 0x10001 || *(dword*)(Memory::Disc_ID) == 0x10000)
-		{
-			Out->PrintErr("Decrypted discs are not supported.\n\n");
-            throw "Disc is decrypted";
-		}
-		
 		// Determine the video mode to use(requires the discID in memory)
         Determine_VideoMode(*(char*)Memory::Disc_Region);
-		
-		// Read header & process info
-        DI->Read_Unencrypted(&Header, sizeof(Wii_Disc::Header), 0);
 
         char Disc_ID[8];
         memset(Disc_ID, 0, sizeof(Disc_ID));
@@ -571,52 +1080,7 @@ void SoftChip::Load_Disc()
 		Log->Write("Disc ID: %s\r\n", Disc_ID);
 		Log->Write("Disc Title: %s\r\n", Header.Title);
 
-        // Read partition descriptor and get offset to partition info
-        dword Offset = Wii_Disc::Offsets::Descriptor;
-        DI->Read_Unencrypted(&Descriptor, sizeof(Wii_Disc::Partition_Descriptor), Offset);
-
-        Offset = Descriptor.Primary_Offset << 2;
-        Out->Print("Partition Info is at: 0x%x\n", Offset);
-
-        // TODO: Support for additional partition types (secondary, tertiary, quaternary)
-		// TODO: Support for selecting which partition load
-		dword PartSize = sizeof(Wii_Disc::Partition_Info);
-		dword BufferLen = Descriptor.Primary_Count * PartSize;
-
-		// Length must be multiple of 0x20
-		BufferLen += 0x20 - (BufferLen % 0x20);
-		byte *PartBuffer = (byte*)memalign(0x20, BufferLen);
-
-		memset(PartBuffer, 0, BufferLen);
-		DI->Read_Unencrypted(PartBuffer, BufferLen, Offset);
-
-		Wii_Disc::Partition_Info *Partitions = (Wii_Disc::Partition_Info*)PartBuffer;
-
-        for (dword i = 0; i < Descriptor.Primary_Count; i++)
-        {
-			Out->Print("Found Partition (Type %u): 0x%x\n", Partitions[i].Type, Partitions[i].Offset << 2);
-
-			if (Partitions[i].Type == 0)
-			{
-				memcpy(&Partition_Info, PartBuffer + (i * PartSize), PartSize);
-				break;
-			}
-        }
-
-		Offset = Partition_Info.Offset << 2;
-		free(PartBuffer);
-
-        if (!Offset)
-		{
-			Out->PrintErr("[-] No boot partition found.\n\n");
-            throw "Wrong Offset";
-		}
-
-        Out->Print("Boot Partition is located at: 0x%x\n", Offset);
-
-        // Set Offset Base to start of partition
-        DI->Set_OffsetBase(Offset);
-        Offset = 0;
+        Out->Print("Boot Partition is located at: 0x%x\n", Partition_Info.Offset << 2);
 
         signed_blob* Certs		= 0;
         signed_blob* Ticket		= 0;
@@ -626,30 +1090,20 @@ void SoftChip::Load_Disc()
         unsigned int T_Length	= 0;
         unsigned int MD_Length	= 0;
 
-        static byte	Ticket_Buffer[0x800] __attribute__((aligned(0x20)));
-        static byte	Tmd_Buffer[0x49e4] __attribute__((aligned(0x20)));
+        byte*	Ticket_Buffer	= Probe->Ticket;
+        byte*	Tmd_Buffer		= Probe->TMD;
 
         // Get certificates from the cIOS
         cIOS::Instance()->GetCerts(&Certs, &C_Length);
 
         Out->Print("System certificates at: 0x%x\n", reinterpret_cast<dword>(Certs));
 
-        // Read the ticket buffer
-        DI->Read_Unencrypted(Ticket_Buffer, 0x800, Partition_Info.Offset << 2);
-
         // Get the ticket pointer
         Ticket		= reinterpret_cast<signed_blob*>(Ticket_Buffer);
         T_Length	= SIGNED_TIK_SIZE(Ticket);
 
         Out->Print("Ticket at: 0x%x\n", reinterpret_cast<dword>(Ticket));
 
-        // Open Partition and get the TMD buffer
-        if (DI->Open_Partition(Partition_Info.Offset, 0,0,0, Tmd_Buffer) < 0)
-        {
-            Out->PrintErr("[-] Error opening partition.\n\n");
-			throw "Open Error";
-        }
-
         // Get the TMD pointer
         Tmd = reinterpret_cast<signed_blob*>(Tmd_Buffer);
         MD_Length = SIGNED_TMD_SIZE(Tmd);
@@ -669,6 +1123,7 @@ void SoftChip::Load_Disc()
 
 			DI->Close_Partition();
 			DI->Close();
+			if (DI != Drive) Drive->Close();
 			
 			// Release FAT and Wiimotes
 			SD->Release_FAT();
@@ -684,27 +1139,27 @@ void SoftChip::Load_Disc()
 				Out->Print("Loading IOS%u successful\n", Tmd_Buffer[0x18b]);
 				Log->Write("Loading IOS%u successful\n", Tmd_Buffer[0x18b]);
 			}
+
+			// Re-Init FAT and Wiimotes (before DI, an image lives on FAT)
+			SD->Initialize_FAT();
+			Controls->Initialize();
 			
-			if (!DI->Initialize())
+			if (!Drive->Initialize() || !DI->Initialize())
 			{
 				Out->PrintErr("[-] Error Initializing DIP-Module.\n");
 				throw "Error Initializing DIP";
 			}
-
-			// Re-Init FAT and Wiimotes
-			SD->Initialize_FAT();
-			Controls->Initialize();
 			
 			if (DI->Verify_Cover(&Disc_Inserted) < 0)
 			{
 				throw "Verify_Cover failed";
 			}
 			
+			// The load starts over once there's a disc, the IOS is loaded by then
 			if (!Disc_Inserted)
 			{
-				Out->SetSilent(false);
-				Out->Print("Please insert a Disc.\n");
-				DI->Wait_CoverClose();
+				Ask_Disc();
+				return;
 			}
 
 			Out->Print("Restart Loading Game...\n");
@@ -722,6 +1177,15 @@ void SoftChip::Load_Disc()
 			Out->Print("[+] Partition opened successfully.\n");
 		}
 
+		// The game reads the drive, not the image
+		if (Image_Used) Verify_Image();
+
+		// The sections the last boot of the disc read are staged while the apploader starts
+		{
+			Scoped_Timer Plan_Timer("Load_Plan");
+			DI->Load_Plan(ConfigData::Default_PlanFile, (dvddiskid*)Memory::Disc_ID);
+		}
+
         /* Filling the memory for the apploader, it seems to have an effect on it */
 		Out->Print("Filling the memory.\n");
 
@@ -738,6 +1202,10 @@ void SoftChip::Load_Disc()
 
 		// Enable online mode in games
         memcpy((dword*)Memory::Online_Check, (dword*)Memory::Disc_ID, 4);
+
+		// The globals are also written by the apploader and before the jump
+		Cache->Clear();
+		Cache->Touch((void*)Memory::Disc_ID, Memory::Globals_End - Memory::Disc_ID);
 		
         // Read apploader header from 0x2440
         Out->Print("Reading apploader header.\n");
@@ -776,30 +1244,102 @@ void SoftChip::Load_Disc()
         void*	Address = 0;
         int		Section_Size;
         int		Partition_Offset;
-		bool	Lang_Patched = (Cfg->Data.Language == -1);
-		bool	Country_Strings_Patched = (!Cfg->Data.Country_String_Patching);
-		//bool	Removed_002 = (!Cfg->Data.Remove_002);
+
+		// All enabled patches are applied in one pass per section
+		Patch->Prepare((const char*)Memory::Disc_ID);
+
+		// Patches are only searched for in main.dol's sections, if its header is sane
+		Wii_Disc::DOL_Header*	DOL = (Wii_Disc::DOL_Header*)Boot_Buffer(sizeof(Wii_Disc::DOL_Header));
+		dword					DOL_Offset;
+
+		if (!Wii_Disc::Read_DOL_Header(DI, DOL, &DOL_Offset) || !Patch->Set_DOL(DOL, DOL_Offset))
+		{
+			Log->Write("Warning: main.dol header unusable, patching every section\r\n");
+		}
+
+		// Sites found on the last boot of the same main.dol are patched without searching
+		{
+			Scoped_Timer Memo_Timer("Load_Memo");
+			Patch->Load_Memo(ConfigData::Default_MemoFile);
+		}
 
         Out->Print("Loading.\t\t\n");
 
-        while (Load(&Address, &Section_Size, &Partition_Offset))
+		u64 Apploader_Start = Prof->Now();
+
+		// The apploader needs a section in memory before it hands out the next one,
+		// so section N+1 is queued as soon as N arrives and N is patched while it loads.
+		// Small sequential sections are coalesced by the planner and need no ioctl.
+		bool	Loading = Load(&Address, &Section_Size, &Partition_Offset);
+
+		if (Loading)
+		{
+			if (!Address) throw ("Null pointer from apploader");
+			DI->Queue_Read(Address, Section_Size, Partition_Offset << 2);
+		}
+
+        while (Loading)
         {
             Out->Print(".");
 
-            if (!Address) throw ("Null pointer from apploader");
+			if (DI->Read_Pending())
+			{
+				Scoped_Timer Wait_Timer("Wait_Read");
+				DI->Wait_Read();
+			}
+
+			void*	Section			= Address;
+			int		Section_Length	= Section_Size;
+			dword	Section_Offset	= Partition_Offset << 2;
+
+			// Queue the next section, unless it lands on the one about to be patched
+			Loading = Load(&Address, &Section_Size, &Partition_Offset);
+			if (Loading && !Address) throw ("Null pointer from apploader");
+
+			bool	Overlaps = Loading
+							&& (byte*)Address < (byte*)Section + Section_Length
+							&& (byte*)Section < (byte*)Address + Section_Size;
 
-            DI->Read(Address, Section_Size, Partition_Offset << 2);
-            DCFlushRange(Address, Section_Size);
+			if (Loading && !Overlaps) DI->Queue_Read(Address, Section_Size, Partition_Offset << 2);
 
             // main.dol Patching
-			// TODO: Search the patch offsets only in the main.dol
-			if (!Lang_Patched) Lang_Patched = Set_GameLanguage(Address, Section_Size, *(char*)Memory::Disc_Region);
-			if (!Country_Strings_Patched) Country_Strings_Patched = Patch_Country_Strings(Address, Section_Size, *(char*)Memory::Disc_Region);
-			//if (!Removed_002) Removed_002 = Remove_002_Protection(Address, Section_Size);
+			{
+				Scoped_Timer Patch_Timer("Patch");
+
+				if (Patch->Pending()) Patch->Scan(Section, Section_Length, Section_Offset);
+
+				// Flushed with everything else before the jump
+				Cache->Touch(Section, Section_Length);
+			}
+
+			if (Loading && Overlaps) DI->Queue_Read(Address, Section_Size, Partition_Offset << 2);
         }
 		Out->Print("\n");
+
+		Prof->Record("Apploader", Apploader_Start, Prof->Now());
+
+		{
+			Scoped_Timer Plan_Timer("Save_Plan");
+			if (!DI->Save_Plan(ConfigData::Default_PlanFile)) Log->Write("Warning: Prefetch plan could not be saved\r\n");
+		}
+
+		// Every read is done, keep them for the next boot of the disc
+		if (DI == Bundle)
+		{
+			Scoped_Timer Bundle_Timer("Save_Bundle");
+			Bundle->Commit();
+		}
+
+		DI->Log_Statistics();
+		Patch->Log_Statistics();
+		Pool->Log_Statistics();
+
+		{
+			Scoped_Timer Memo_Timer("Save_Memo");
+			if (!Patch->Save_Memo(ConfigData::Default_MemoFile)) Log->Write("Warning: Patch memo could not be saved\r\n");
+		}
 		
-		if ((Cfg->Data.Language != -1) && (!Lang_Patched))
+		if ((Cfg->Data.Language != -1) && (!Patch->Applied(Patcher::Patch_Language)))
 		{
 			Log->Write("Error: Did not patch the language, pattern not found\r\n");
 		}
@@ -807,7 +1347,7 @@ void SoftChip::Load_Disc()
 		/*
 		if (Cfg->Data.Remove_002)
 		{
-			if (Removed_002)
+			if (Patch->Applied(Patcher::Patch_002))
 			{
 				Log->Write("002 error removed\r\n");
 			}
@@ -836,8 +1376,13 @@ void SoftChip::Load_Disc()
         // Set Video Mode based on Configuration
         Set_VideoMode();
 
-        // Flush application memory range
-        DCFlushRange((void*)0x80000000, 0x17fffff);	// TODO: Remove these hardcoded values
+        // Flush what was written or loaded, instead of all of MEM1
+		Cache->Flush();
+		Cache->Log_Statistics();
+
+		// Write the boot timeline
+		Prof->Record("Load_Disc", Load_Start, Prof->Now());
+		Prof->Dump(ConfigData::Default_TraceFile);
 
 		// Close the logfile
 		Log->CloseLog();
@@ -847,6 +1392,7 @@ void SoftChip::Load_Disc()
 
         // Cleanup loader information
 		DI->Close();
+		if (DI != Drive) Drive->Close();
 
 		// Identify as the game
 		if (IS_VALID_SIGNATURE(Certs) 	&& IS_VALID_SIGNATURE(Tmd) 	&& IS_VALID_SIGNATURE(Ticket) 
@@ -854,6 +1400,14 @@ void SoftChip::Load_Disc()
 		{
 			int ret = ES_Identify(Certs, C_Length, Tmd, MD_Length, Ticket, T_Length, NULL);
 
+			// The copy of the chain on the SD card may be refused, the NAND's isn't
+			if (ret < 0 && cIOS::Instance()->CertsFromSD())
+			{
+				SD->Initialize_FAT();
+				if (cIOS::Instance()->RereadCerts(&Certs, &C_Length) == 0) ret = ES_Identify(Certs, C_Length, Tmd, MD_Length, Ticket, T_Length, NULL);
+				SD->Release_FAT();
+			}
+
 			if (ret < 0)
 			{
 				Out->PrintErr("Error: ES_Identify returned %d\n", ret);
@@ -885,14 +1439,17 @@ void SoftChip::Load_Disc()
         Out->PrintErr("Exception: %s\n\n", Message);
 		Log->Write("Exception: %s\r\n", Message);
 
+		// Write the boot timeline up to the failure
+		Prof->Record("Load_Disc", Load_Start, Prof->Now());
+		Prof->Dump(ConfigData::Default_TraceFile);
+		Prof->Clear();
+
 		// Stop Drive
 		DI->Stop_Motor();
 
-		// Return to IOS Loading, if another IOS was loaded, because it was requested, this is needed
-		NextPhase = Phase_IOS;
-
-		// Wait User
-		Controls->Press_AnyKey("Press Any Key to Continue...\n\n");
+		// Wait User, then return to IOS Loading
+		Out->Print("Press Any Key to Continue...\n\n");
+		Scheduler->Go(Step_Failed);
     }
 }
 
@@ -990,6 +1547,8 @@ void SoftChip::Determine_VideoMode(char Region)
 
 void SoftChip::Set_VideoMode()
 {
+	Scoped_Timer Timer("Set_VideoMode");
+
     // TODO: Some exception handling is needed here
  
     // The video mode (PAL/NTSC/MPAL) is determined by the value of 0x800000cc
@@ -1006,187 +1565,6 @@ void SoftChip::Set_VideoMode()
     if (vmode->viTVMode & VI_NON_INTERLACE) VIDEO_WaitVSync();
 }
 
-/*******************************************************************************
- * Set_GameLanguage: Patches Game's Language
- * -----------------------------------------------------------------------------
- * Return Values:
- *	returns true if patched
- *
- ******************************************************************************/
-
-bool SoftChip::Set_GameLanguage(void *Address, int Size, char Region)
-{
-	unsigned int PatchData[3]	= { 0x7C600775, 0x40820010, 0x38000000 };
-	unsigned int *Addr			= (unsigned int*)Address;
-	bool SearchTarget			= false;
-
-	while (Size >= 16)
-	{
-		if (SearchTarget)
-		{
-			if (*Addr == 0x88610008)
-			{
-				if (Cfg->Data.Language == -2)
-				{
-					switch (Region) 
-					{
-						case Wii_Disc::Regions::NTSC_Japan:
-							*Addr = (unsigned int)(0x38600000 | 0);
-							return true;
-							
-						case Wii_Disc::Regions::NTSC_USA:
-							*Addr = (unsigned int)(0x38600000 | 1);
-							return true;
-							
-						default:
-							return false;
-					}
-				} else
-				{				
-					*Addr = (unsigned int)(0x38600000 | Cfg->Data.Language);
-					return true;
-				}
-			}
-		}
-		else if (Addr[0] == PatchData[0] && Addr[1] == PatchData[1] && Addr[2] == PatchData[2])
-		{
-			SearchTarget = true;
-		}
-
-		Addr += 1;
-		Size -= 4;
-	}
-
-	return false;
-}
-
-
-/*******************************************************************************
- * Remove_002_protection: Removes the 002 copy protection
- * -----------------------------------------------------------------------------
- * Return Values:
- *	returns true if patched
- *
- ******************************************************************************/
-/*
-bool SoftChip::Remove_002_Protection(void *Address, int Size)
-{
-	unsigned int SearchPattern[3]	= { 0x2C000000, 0x40820214, 0x3C608000 };
-	unsigned int PatchData[3]		= { 0x2C000000, 0x48000214, 0x3C608000 };
-	unsigned int *Addr				= (unsigned int*)Address;
-
-	while (Size >= 12)
-	{
-		if (Addr[0] == SearchPattern[0] && Addr[1] == SearchPattern[1] && Addr[2] == SearchPattern[2])
-		{
-			*Addr = PatchData[0];
-			Addr += 1;
-			*Addr = PatchData[1];
-			Addr += 1;
-			*Addr = PatchData[2];
-			return true;
-		}
-
-		Addr += 1;
-		Size -= 4;
-	}
-
-	return false;
-}
-*/
-
-
-/*******************************************************************************
- * Patch_Country_Strings: Patches the Country Strings
- * -----------------------------------------------------------------------------
- * Return Values:
- *	returns true if patched
- *
- ******************************************************************************/
-
-bool SoftChip::Patch_Country_Strings(void *Address, int Size, char discregion)
-{
-	u8 SearchPattern[4];
-	u8 PatchData[2];
-	u8 *Addr			= (u8*)Address;
-
-	int wiiregion = CONF_GetRegion();
-
-	switch (wiiregion)
-	{
-		case CONF_REGION_JP:
-			SearchPattern[0] = 0x00;
-			SearchPattern[1] = 0x4A; // J
-			SearchPattern[2] = 0x50; // P
-			SearchPattern[3] = 0x00;
-			break;
-		case CONF_REGION_EU:
-			SearchPattern[0] = 0x02;
-			SearchPattern[1] = 0x45; // E
-			SearchPattern[2] = 0x55; // U
-			SearchPattern[3] = 0x00;
-			break;
-		case CONF_REGION_KR:
-			SearchPattern[0] = 0x04;
-			SearchPattern[1] = 0x4B; // K
-			SearchPattern[2] = 0x52; // R
-			SearchPattern[3] = 0x00;
-			break;
-		case CONF_REGION_CN:
-			SearchPattern[0] = 0x05;
-			SearchPattern[1] = 0x43; // C
-			SearchPattern[2] = 0x4E; // N
-			SearchPattern[3] = 0x00;
-			break;
-		case CONF_REGION_US:
-		default:
-			SearchPattern[0] = 0x01;
-			SearchPattern[1] = 0x55; // U
-			SearchPattern[2] = 0x53; // S
-			SearchPattern[3] = 0x00;
-	}
-
-	switch (discregion) 
-	{
-		case Wii_Disc::Regions::NTSC_Japan:
-			PatchData[0] = 0x4A; // J
-			PatchData[1] = 0x50; // P
-			break;
-
-		case Wii_Disc::Regions::PAL_Default:
-		case Wii_Disc::Regions::PAL_France:
-		case Wii_Disc::Regions::PAL_Germany:
-		case Wii_Disc::Regions::Euro_X:
-		case Wii_Disc::Regions::Euro_Y:
-			PatchData[0] = 0x45; // E
-			PatchData[1] = 0x55; // U
-			break;
-
-		case Wii_Disc::Regions::NTSC_USA:
-		default:
-			PatchData[0] = 0x55; // U
-			PatchData[1] = 0x53; // S
-	}
-
-	while (Size >= 4)
-	{
-		if (Addr[0] == SearchPattern[0] && Addr[1] == SearchPattern[1] && Addr[2] == SearchPattern[2] && Addr[3] == SearchPattern[3])
-		{
-			Addr += 1;
-			*Addr = PatchData[0];
-			Addr += 1;
-			*Addr = PatchData[1];
-			return true;
-		} else
-		{
-			Addr += 4;
-			Size -= 4;
-		}
-	}
-	return false;
-}
-
-
 /*******************************************************************************
  * Standby: Put the console in standby mode
  * -----------------------------------------------------------------------------
@@ -1245,6 +1623,13 @@ void SoftChip::VerifyFlags()
 
 void SoftChip::Exit_Loader()
 {
+	// A stop left to the idle timeout, unless the probe is stuck on the drive
+	try
+	{
+		if (Probe->Poll() != Disc_Probe::Stage_Running) Drive->Flush_Stop();
+	}
+	catch (const char* Message) {}
+
 	// DOL Version
 	if (*(dword*)Memory::Exit_Stub) exit(0);
 
@@ -17,6 +17,7 @@
 
 #include <sdcard/wiisd_io.h>
 //#include <ogc/usbstorage.h>
+#include <sys/stat.h>
 #include <stdio.h>
 
 #include "Storage.h"
@@ -130,7 +131,6 @@ bool Storage::MakeDir(const char *Path)
 		mkdir(Path, Mode);
 
 		// Re-Verify
-		closedir(dir);
 		dir = opendir(Path);
 		if (dir == NULL) return false;
 	}
@@ -0,0 +1,174 @@
+/*******************************************************************************
+ * WiiDisc.cpp
+ *
+ * Copyright (c) 2009 Requiem (requiem@century-os.com)
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains functions to parse Wii Disc information
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <string.h>
+
+#include "WiiDisc.h"
+#include "Disc_Source.h"
+#include "Buffer_Pool.h"
+
+//--------------------------------------
+// Wii_Disc Namespace
+
+/*******************************************************************************
+ * Read_Partitions: Read the primary partition table
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the table (Count entries), or 0 on error
+ *
+ ******************************************************************************/
+
+Wii_Disc::Partition_Info* Wii_Disc::Read_Partitions(Disc_Source* DI, dword* Count)
+{
+	static Partition_Descriptor Descriptor __attribute__((aligned(0x20)));
+
+	*Count = 0;
+
+	// Read partition descriptor and get offset to partition info
+	memset(&Descriptor, 0, sizeof(Partition_Descriptor));
+	if (DI->Read_Unencrypted(&Descriptor, sizeof(Partition_Descriptor), Offsets::Descriptor) < 0) return 0;
+
+	// TODO: Support for additional partition types (secondary, tertiary, quaternary)
+	dword Entries	= BE32(Descriptor.Primary_Count);
+	dword Offset	= BE32(Descriptor.Primary_Offset) << 2;
+
+	// Length must be multiple of 0x20
+	dword BufferLen = Entries * sizeof(Partition_Info);
+	BufferLen += 0x20 - (BufferLen % 0x20);
+
+	Partition_Info* Table = (Partition_Info*)Buffer_Pool::Instance()->Alloc(BufferLen);
+	if (!Table) return 0;
+
+	memset(Table, 0, BufferLen);
+
+	if (DI->Read_Unencrypted(Table, BufferLen, Offset) < 0)
+	{
+		Buffer_Pool::Instance()->Free(Table);
+		return 0;
+	}
+
+	for (dword i = 0; i < Entries; i++)
+	{
+		Table[i].Offset	= BE32(Table[i].Offset);
+		Table[i].Type	= BE32(Table[i].Type);
+	}
+
+	*Count = Entries;
+	return Table;
+}
+
+/*******************************************************************************
+ * Read_Requested_IOS: Read the IOS the game requests
+ * -----------------------------------------------------------------------------
+ * The boot partition's header gives the TMD's offset, and only the 32 bytes
+ * of the TMD holding the IOS are read.
+ *
+ * Return Values:
+ *	returns true if the boot partition and its TMD were read
+ *
+ ******************************************************************************/
+
+bool Wii_Disc::Read_Requested_IOS(Disc_Source* DI, byte* IOS)
+{
+	static byte Block[0x20] __attribute__((aligned(0x20)));
+
+	dword				Count			= 0;
+	dword				Offset			= 0;
+	Partition_Info*		Partitions		= Read_Partitions(DI, &Count);
+
+	if (!Partitions) return false;
+
+	for (dword i = 0; i < Count; i++)
+	{
+		if (Partitions[i].Type == 0)
+		{
+			Offset = Partitions[i].Offset << 2;
+			break;
+		}
+	}
+
+	Buffer_Pool::Instance()->Free(Partitions);
+
+	if (!Offset) return false;
+
+	Partition_Header* Header = (Partition_Header*)Buffer_Pool::Instance()->Alloc(sizeof(Partition_Header));
+	if (!Header) return false;
+
+	int		Ret		= DI->Read_Unencrypted(Header, sizeof(Partition_Header), Offset);
+	dword	TMD		= Offset + (BE32(Header->TMD_Offset) << 2);
+	dword	Size	= BE32(Header->TMD_Size);
+
+	Buffer_Pool::Instance()->Free(Header);
+
+	if (Ret < 0 || Size <= Offsets::TMD_IOS) return false;
+
+	if (DI->Read_Unencrypted(Block, sizeof(Block), (TMD + Offsets::TMD_IOS) & ~0x1f) < 0) return false;
+
+	*IOS = Block[(TMD + Offsets::TMD_IOS) & 0x1f];
+	return true;
+}
+
+/*******************************************************************************
+ * Read_DOL_Header: Read main.dol's header
+ * -----------------------------------------------------------------------------
+ * The boot info at Offsets::Main_DOL gives the DOL's offset.  The header is
+ * rejected if a section would lie inside it or outside of MEM1, so a bad
+ * header can't be mistaken for a map of the game's code.
+ *
+ * Return Values:
+ *	returns true if the header was read and looks sane
+ *
+ ******************************************************************************/
+
+bool Wii_Disc::Read_DOL_Header(Disc_Source* DI, DOL_Header* Header, dword* Offset)
+{
+	static dword Boot_Info[8] __attribute__((aligned(0x20)));
+
+	*Offset = 0;
+
+	if (DI->Read(Boot_Info, sizeof(Boot_Info), Offsets::Main_DOL) < 0) return false;
+
+	dword DOL_Offset = BE32(Boot_Info[0]) << 2;
+
+	if (DI->Read(Header, sizeof(DOL_Header), DOL_Offset) < 0) return false;
+
+	bool Sections = false;
+
+	for (int i = 0; i < DOL_Header::Sections; i++)
+	{
+		Header->Offset[i]	= BE32(Header->Offset[i]);
+		Header->Address[i]	= BE32(Header->Address[i]);
+		Header->Size[i]		= BE32(Header->Size[i]);
+
+		if (Header->Size[i] == 0) continue;
+
+		if (Header->Offset[i] < sizeof(DOL_Header)) return false;
+		if ((Header->Address[i] & 0xfe000000) != 0x80000000) return false;
+		if ((Header->Address[i] & 0x01ffffff) + Header->Size[i] > 0x01800000) return false;
+
+		Sections = true;
+	}
+
+	Header->BSS_Address	= BE32(Header->BSS_Address);
+	Header->BSS_Size	= BE32(Header->BSS_Size);
+	Header->Entry_Point	= BE32(Header->Entry_Point);
+
+	if (!Sections) return false;
+
+	*Offset = DOL_Offset;
+	return true;
+}
@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * IOS_Inventory.cpp
+ *
+ * Copyright (c) 2009 SoftChip Team
+ *
+ * Distributed under the terms of the GNU General Public License (v3)
+ * See http://www.gnu.org/licenses/gpl-3.0.txt for more info.
+ *
+ * Description:
+ * -----------
+ *	Contains implementation of a class that keeps the revision of each
+ *	installed IOS for the IOS menu
+ *
+ ******************************************************************************/
+
+//--------------------------------------
+// Includes
+
+#include <stdio.h>
+#include <string.h>
+
+#include "IOS_Inventory.h"
+#include "cIOS.h"
+#include "FNV.h"
+#include "Buffer_Pool.h"
+#include "Storage.h"
+
+//--------------------------------------
+// IOS_Inventory Class
+
+/*******************************************************************************
+ * IOS_Inventory: Default constructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+IOS_Inventory::IOS_Inventory()
+{
+	TMD_Reads	= 0;
+	List_Hash	= 0;
+	Loaded		= false;
+	Changed		= false;
+}
+
+/*******************************************************************************
+ * ~IOS_Inventory: Default destructor
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+IOS_Inventory::~IOS_Inventory() {}
+
+/*******************************************************************************
+ * Read: Read the inventory file
+ * -----------------------------------------------------------------------------
+ * Only done once, afterwards the entries in memory are newer.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void IOS_Inventory::Read(const char* Path)
+{
+	Loaded = true;
+
+	Inventory_File::Header	Head;
+	FILE*					fp		= Storage::Instance()->OpenFile(Path, "rb");
+
+	if (fp == NULL) return;
+
+	if (fread(&Head, 1, sizeof(Head), fp) == sizeof(Head)
+		&& memcmp(Head.Signature, Inventory_File::Signature, sizeof(Head.Signature)) == 0
+		&& Head.Version == Inventory_File::Version
+		&& BE32(Head.Count) <= Inventory_File::Max_Entries)
+	{
+		dword Count = BE32(Head.Count);
+		Inventory_File::Entry Record;
+
+		for (dword i = 0; i < Count && fread(&Record, 1, sizeof(Record), fp) == sizeof(Record); i++)
+		{
+			Entry Item;
+
+			Item.Title		= BE32(Record.Title);
+			Item.Revision	= BE32(Record.Revision);
+			Item.TMD_Hash	= BE32(Record.TMD_Hash);
+			Item.Known		= true;
+			Item.Stale		= !(Record.Flags & Inventory_File::Flag_Verified);
+			Item.Seen		= false;
+
+			Entries.push_back(Item);
+		}
+
+		List_Hash = BE32(Head.List_Hash);
+	}
+
+	fclose(fp);
+}
+
+/*******************************************************************************
+ * Update: Bring the inventory up to the titles listed
+ * -----------------------------------------------------------------------------
+ * The file is read the first time.  If the list of titles is the one the
+ * entries were read for, they are trusted and no TMD is read; otherwise they
+ * keep their revisions, marked stale, and new titles have none.
+ *
+ * Return Values:
+ *	returns void
+ *
+ ******************************************************************************/
+
+void IOS_Inventory::Update(const char* Path, const vector<u32>& Titles)
+{
+	if (!Loaded) Read(Path);
+
+	dword Hash = Titles.size() ? FNV::Hash(&Titles[0], Titles.size() * sizeof(u32)) : 0;
+
+	if (Hash == List_Hash && Entries.size() == Titles.size()) return;
+
+	bool			Same_List	= (Hash == List_Hash);
+	vector<Entry>	Previous;
+
+	Previous.swap(Entries);
+
+	for (unsigned int i = 0; i < Titles.size(); i++)
+	{
+		Entry Item;
+		memset(&Item, 0, sizeof(Item));
+
+		Item.Title = Titles[i];
+		Item.Stale = true;
+
+		for (unsigned int j = 0; j < Previous.size(); j++)
+		{
+			if (Previous[j].Title != Titles[i]) continue;
+
+			Item = Previous[j];
+			if (!Same_List) Item.Stale = !Item.Seen;
+			break;
+		}
+
+		Entries.push_back(Item);
+	}
+
+	if (!Same_List) Changed = true;
+	List_Hash = Hash;
+}
+
+/*******************************************************************************
+ * Refresh: Read the TMD of an entry
+ * -----------------------------------------------------------------------------
+ * Done once a session per title; a TMD that can't be read leaves the entry
+ * as it was.
+ *
+ * Return Values:
+ *	returns true if the TMD was read now
+ *
+ ******************************************************************************/
+
+bool IOS_Inventory::Refresh(unsigned int Index)
+{
+	if (Index >= Entries.size() || Entries[Index].Seen) return false;
+
+	Entry&			Item	= Entries[Index];
+	signed_blob*	TMD		= 0;
+	u32				Length	= 0;
+
+	Item.Seen = true;
+	TMD_Reads++;
+
+	if (cIOS::Instance()->GetTMD(TITLEID(Item.Title), &TMD, &Length) < 0)
+	{
+		Buffer_Pool::Instance()->Free(TMD);
+		return false;
+	}
+
+	dword Revision	= ((tmd*)SIGNATURE_PAYLOAD(TMD))->title_version;
+	dword Hash		= FNV::Hash(TMD, Length);
+
+	Buffer_Pool::Instance()->Free(TMD);
+
+	if (!Item.Known || Item.Stale || Item.Revision != Revision || Item.TMD_Hash != Hash) Changed = true;
+
+	Item.Revision	= Revision;
+	Item.TMD_Hash	= Hash;
+	Item.Known		= true;
+	Item.Stale		= false;
+
+	return true;
+}
+
+/*******************************************************************************
+ * Next_Stale: Find an entry left to read
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns its index, -1 if there's none
+ *
+ ******************************************************************************/
+
+int IOS_Inventory::Next_Stale()
+{
+	for (unsigned int i = 0; i < Entries.size(); i++)
+	{
+		if (Entries[i].Stale && !Entries[i].Seen) return i;
+	}
+
+	return -1;
+}
+
+/*******************************************************************************
+ * Save: Write the inventory file
+ * -----------------------------------------------------------------------------
+ * Entries never read are left out, and stale ones are written as such.
+ *
+ * Return Values:
+ *	returns false if the file couldn't be written
+ *
+ ******************************************************************************/
+
+bool IOS_Inventory::Save(const char* Path)
+{
+	if (!Changed) return true;
+
+	FILE* fp = Storage::Instance()->OpenFile(Path, "wb");
+	if (fp == NULL) return false;
+
+	dword Count = 0;
+
+	for (unsigned int i = 0; i < Entries.size() && Count < Inventory_File::Max_Entries; i++)
+	{
+		if (Entries[i].Known) Count++;
+	}
+
+	Inventory_File::Header Head;
+	memset(&Head, 0, sizeof(Head));
+	memcpy(Head.Signature, Inventory_File::Signature, sizeof(Head.Signature));
+
+	Head.Version	= Inventory_File::Version;
+	Head.Count		= BE32(Count);
+	Head.List_Hash	= BE32(List_Hash);
+
+	bool Result = (fwrite(&Head, 1, sizeof(Head), fp) == sizeof(Head));
+
+	for (unsigned int i = 0; Result && Count && i < Entries.size(); i++)
+	{
+		if (!Entries[i].Known) continue;
+
+		Inventory_File::Entry Record;
+		memset(&Record, 0, sizeof(Record));
+
+		Record.Title	= BE32(Entries[i].Title);
+		Record.Revision	= BE32(Entries[i].Revision);
+		Record.TMD_Hash	= BE32(Entries[i].TMD_Hash);
+		Record.Flags	= Entries[i].Stale ? 0 : Inventory_File::Flag_Verified;
+
+		Result = (fwrite(&Record, 1, sizeof(Record), fp) == sizeof(Record));
+		Count--;
+	}
+
+	Result = (fclose(fp) == 0) && Result;
+	if (Result) Changed = false;
+
+	return Result;
+}
+
+/*******************************************************************************
+ * Count: Number of entries
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the number of titles given to Update
+ *
+ ******************************************************************************/
+
+unsigned int IOS_Inventory::Count() const
+{
+	return Entries.size();
+}
+
+/*******************************************************************************
+ * Get: An entry
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *	returns the entry of the title at Index in the list given to Update
+ *
+ ******************************************************************************/
+
+const IOS_Inventory::Entry& IOS_Inventory::Get(unsigned int Index) const
+{
+	return Entries[Index];
+}
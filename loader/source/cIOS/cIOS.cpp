@@ -15,8 +15,13 @@
 //--------------------------------------
 // Includes
 
+#include <stdio.h>
 #include <string.h>
 #include "cIOS.h"
+#include "Buffer_Pool.h"
+#include "FNV.h"
+#include "Configuration.h"
+#include "Storage.h"
 
 //--------------------------------------
 // Typedefs
@@ -32,6 +37,99 @@ typedef struct
 
 static const char certs_fs[] ATTRIBUTE_ALIGN(32) = "/sys/cert.sys";
 
+// The certificate chain, kept across calls and IOS reloads
+static unsigned char	Cert[CERTS_SIZE] ATTRIBUTE_ALIGN(32);
+static u32				Cert_Length	= 0;		// 0 until read in full
+static dword			Cert_Hash	= 0;
+static bool				Cert_SD		= false;	// Kept from the copy on the SD card
+
+/*******************************************************************************
+ * Read_Certs_SD: Read the copy of the certificate chain on the SD card
+ * -----------------------------------------------------------------------------
+ * The copy is followed by the FNV-1a hash of the chain, big-endian.
+ *
+ * Return Values:
+ *
+ * Returns true if it's there, of the right size and hash, and signed
+ *
+ ******************************************************************************/
+
+static bool Read_Certs_SD()
+{
+	FILE* fp = Storage::Instance()->OpenFile(ConfigData::Default_CertFile, "rb");
+	if (fp == NULL) return false;
+
+	dword Hash = 0;
+
+	bool Result = (fread(Cert, 1, CERTS_SIZE, fp) == CERTS_SIZE && fread(&Hash, 1, sizeof(Hash), fp) == sizeof(Hash)
+		&& fgetc(fp) == EOF && FNV::Hash(Cert, CERTS_SIZE) == BE32(Hash)
+		&& IS_VALID_SIGNATURE(reinterpret_cast<signed_blob*>(Cert)));
+
+	fclose(fp);
+	return Result;
+}
+
+/*******************************************************************************
+ * Write_Certs_SD: Leave a copy of the certificate chain on the SD card
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *
+ * Returns void
+ *
+ ******************************************************************************/
+
+static void Write_Certs_SD()
+{
+	FILE* fp = Storage::Instance()->OpenFile(ConfigData::Default_CertFile, "wb");
+	if (fp == NULL) return;
+
+	dword Hash = BE32(Cert_Hash);
+
+	bool Result = (fwrite(Cert, 1, CERTS_SIZE, fp) == CERTS_SIZE && fwrite(&Hash, 1, sizeof(Hash), fp) == sizeof(Hash));
+
+	// A partial copy would be refused by its size, but don't leave one
+	if (fclose(fp) != 0 || !Result) remove(ConfigData::Default_CertFile);
+}
+
+/*******************************************************************************
+ * Read_Certs_NAND: Read the certificate chain from the NAND
+ * -----------------------------------------------------------------------------
+ * A full chain is kept, and a copy is left on the SD card.
+ *
+ * Return Values:
+ *
+ * Returns 0, or the error of IOS_Open/IOS_Read
+ *
+ ******************************************************************************/
+
+static s32 Read_Certs_NAND()
+{
+	memset(Cert, 0, CERTS_SIZE);
+	s32				fd, ret;
+
+	fd = IOS_Open(certs_fs, ISFS_OPEN_READ);
+	if (fd < 0) return fd;
+
+	ret = IOS_Read(fd, Cert, CERTS_SIZE);
+	if (ret < 0)
+	{
+		if (fd >0) IOS_Close(fd);
+		return ret;
+	}
+
+	if (fd > 0) IOS_Close(fd);
+
+	// Only a full chain is kept
+	if (ret == CERTS_SIZE)
+	{
+		Cert_Length = CERTS_SIZE;
+		Cert_Hash = FNV::Hash(Cert, Cert_Length);
+		Write_Certs_SD();
+	}
+
+	return 0;
+}
+
 /*******************************************************************************
  * s32 Load: Loads the IOS specified in Version
  * -----------------------------------------------------------------------------
@@ -82,56 +180,113 @@ s32 cIOS::Identify()
 	s32 ret = GetCerts(&Certs, &Cert_Length);
 	if (ret < 0)
 	{
-		if (Certs)	free(Certs);
-		if (Ticket)	free(Ticket);
-		if (TMD)	free(TMD);
+		Buffer_Pool::Instance()->Free(Ticket);
+		Buffer_Pool::Instance()->Free(TMD);
 		return ret;
 	}
 
 	ret = GenerateTicket(&Ticket, &Ticket_Length);
 	if (ret < 0)
 	{
-		if (Certs)	free(Certs);
-		if (Ticket)	free(Ticket);
-		if (TMD)	free(TMD);
+		Buffer_Pool::Instance()->Free(Ticket);
+		Buffer_Pool::Instance()->Free(TMD);
 		return ret;
 	}
 
 	ret = GetTMD(TITLEID(Version()), &TMD, &TMD_Length);
 	if (ret < 0)
 	{
-		if (Certs)	free(Certs);
-		if (Ticket)	free(Ticket);
-		if (TMD)	free(TMD);
+		Buffer_Pool::Instance()->Free(Ticket);
+		Buffer_Pool::Instance()->Free(TMD);
 		return ret;
 	}
 
-	return ES_Identify(Certs, Cert_Length, TMD, TMD_Length, Ticket, Ticket_Length, NULL);
+	ret = ES_Identify(Certs, Cert_Length, TMD, TMD_Length, Ticket, Ticket_Length, NULL);
+
+	// The copy on the SD card may be refused, the NAND's isn't
+	if (ret < 0 && CertsFromSD() && RereadCerts(&Certs, &Cert_Length) == 0)
+	{
+		ret = ES_Identify(Certs, Cert_Length, TMD, TMD_Length, Ticket, Ticket_Length, NULL);
+	}
+
+	Buffer_Pool::Instance()->Free(Ticket);
+	Buffer_Pool::Instance()->Free(TMD);
+
+	return ret;
 }
 
 
+/*******************************************************************************
+ * s32 GetCerts: Gets the system's certificate chain
+ * -----------------------------------------------------------------------------
+ * /sys/cert.sys never changes, so it's read once and kept, checked against its
+ * hash on each call.  The first read tries the copy on the SD card before the
+ * NAND, and a read from the NAND leaves one there.  If the IOS refuses a chain
+ * from the SD card, RereadCerts replaces it.
+ *
+ * Return Values:
+ *
+ * Returns 0, or the error of IOS_Open/IOS_Read
+ *
+ ******************************************************************************/
+
 s32 cIOS::GetCerts(signed_blob** Certs, u32* Length)
 {
-	static unsigned char		Cert[CERTS_SIZE] __attribute__((aligned(0x20)));
-	memset(Cert, 0, CERTS_SIZE);
-	s32				fd, ret;
+	*Certs = reinterpret_cast<signed_blob*>(Cert);
+	*Length = CERTS_SIZE;
 
-	fd = IOS_Open(certs_fs, ISFS_OPEN_READ);
-	if (fd < 0) return fd;
+	if (Cert_Length == CERTS_SIZE && FNV::Hash(Cert, Cert_Length) == Cert_Hash) return 0;
 
-	ret = IOS_Read(fd, Cert, CERTS_SIZE);
-	if (ret < 0)
+	Cert_Length = 0;
+
+	if (Read_Certs_SD())
 	{
-		if (fd >0) IOS_Close(fd);
-		return ret;
+		Cert_Length = CERTS_SIZE;
+		Cert_Hash = FNV::Hash(Cert, Cert_Length);
+		Cert_SD = true;
+		return 0;
 	}
 
+	Cert_SD = false;
+	return Read_Certs_NAND();
+}
+
+/*******************************************************************************
+ * s32 RereadCerts: Replace a certificate chain the IOS refused
+ * -----------------------------------------------------------------------------
+ * The copy on the SD card is deleted, and the chain read from the NAND again.
+ *
+ * Return Values:
+ *
+ * Returns 0, or the error of IOS_Open/IOS_Read
+ *
+ ******************************************************************************/
+
+s32 cIOS::RereadCerts(signed_blob** Certs, u32* Length)
+{
 	*Certs = reinterpret_cast<signed_blob*>(Cert);
 	*Length = CERTS_SIZE;
 
-	if (fd > 0) IOS_Close(fd);
+	remove(ConfigData::Default_CertFile);
 
-	return 0;
+	Cert_Length = 0;
+	Cert_SD = false;
+
+	return Read_Certs_NAND();
+}
+
+/*******************************************************************************
+ * bool CertsFromSD: Check where the kept certificate chain came from
+ * -----------------------------------------------------------------------------
+ * Return Values:
+ *
+ * Returns true if it was read from the copy on the SD card
+ *
+ ******************************************************************************/
+
+bool cIOS::CertsFromSD()
+{
+	return Cert_SD && Cert_Length == CERTS_SIZE;
 }
 
 s32 cIOS::GetTMD(u64 TicketID, signed_blob **Output, u32 *Length)
@@ -147,7 +302,7 @@ s32 cIOS::GetTMD(u64 TicketID, signed_blob **Output, u32 *Length)
 		return ret;
 
 	/* Allocate memory */
-	TMD = (signed_blob*)memalign(32, (TMD_Length+31)&(~31));
+	TMD = (signed_blob*)Buffer_Pool::Instance()->Alloc((TMD_Length+31)&(~31));
 	if (!TMD)
 		return IPC_ENOMEM;
 
@@ -155,7 +310,7 @@ s32 cIOS::GetTMD(u64 TicketID, signed_blob **Output, u32 *Length)
 	ret = ES_GetStoredTMD(TicketID, TMD, TMD_Length);
 	if (ret < 0)
 	{
-		free(TMD);
+		Buffer_Pool::Instance()->Free(TMD);
 		return ret;
 	}
 
@@ -171,7 +326,7 @@ s32	cIOS::GenerateTicket(signed_blob** Output, u32* Length)
 	signed_tik* Ticket = NULL;
 
 	/* Allocate memory */
-	Ticket = (signed_tik*)memalign(32, sizeof(signed_tik));
+	Ticket = (signed_tik*)Buffer_Pool::Instance()->Alloc(sizeof(signed_tik));
 	if (!Ticket)
 		return IPC_ENOMEM;
 